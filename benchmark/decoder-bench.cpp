@@ -0,0 +1,50 @@
+#include <benchmark/benchmark.h>
+
+#include "besm-666/decoder/decoder.hpp"
+
+using namespace besm;
+
+namespace {
+
+/// A function as compiled by GCC: prologue, loop and epilogue
+RV64UWord const Stream[] = {
+    0xfe010113, // addi sp, sp, -32
+    0x00113c23, // sd ra, 24(sp)
+    0x00813823, // sd s0, 16(sp)
+    0x02010413, // addi s0, sp, 32
+    0x000107b7, // lui a5, 0x10
+    0x00000717, // auipc a4, 0
+    0x0005b503, // ld a0, 0(a1)
+    0x0085a603, // lw a2, 8(a1)
+    0x00154683, // lbu a3, 1(a0)
+    0x00c50533, // add a0, a0, a2
+    0x40c686b3, // sub a3, a3, a2
+    0x00369713, // slli a4, a3, 3
+    0x00e7c7b3, // xor a5, a5, a4
+    0x00e7b2b3, // sltu t0, a5, a4
+    0x0016061b, // addiw a2, a2, 1
+    0x00c5a423, // sw a2, 8(a1)
+    0x00a5b023, // sd a0, 0(a1)
+    0xfcd61ce3, // bne a2, a3, -40
+    0x00028463, // beqz t0, 8
+    0xfc1ff0ef, // jal ra, -64
+    0x0ff57513, // andi a0, a0, 255
+    0x01813083, // ld ra, 24(sp)
+    0x01013403, // ld s0, 16(sp)
+    0x02010113, // addi sp, sp, 32
+    0x00008067, // ret
+};
+constexpr size_t StreamSize = sizeof(Stream) / sizeof(Stream[0]);
+
+void BM_DecoderParse(benchmark::State &state) {
+    dec::Decoder decoder;
+    for (auto _ : state) {
+        for (RV64UWord bytecode : Stream) {
+            benchmark::DoNotOptimize(decoder.parse(bytecode));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * StreamSize);
+}
+BENCHMARK(BM_DecoderParse);
+
+} // namespace
@@ -0,0 +1,76 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "besm-666/exec/basic-block.hpp"
+
+using namespace besm;
+
+namespace {
+
+constexpr uint64_t CodeHash = 1;
+
+/// Publishes \p num blocks of two instructions, 8 bytes apart
+std::vector<exec::BasicBlock const *>
+PublishBlocks(exec::SharedBasicBlockCache &cache, size_t num) {
+    std::vector<exec::BasicBlock const *> bbs;
+    for (size_t i = 0; i < num; ++i) {
+        exec::BasicBlock bb;
+        exec::BasicBlockRebuilder rebuilder(bb, i * 8);
+        Instruction instr{};
+        instr.operation = ADDI;
+        rebuilder.append(instr);
+        instr.operation = JAL;
+        rebuilder.append(instr);
+        bbs.push_back(cache.publish(CodeHash, bb));
+    }
+    return bbs;
+}
+
+/// The working set fits the hart cache, every lookup hits
+void BM_BasicBlockCacheHit(benchmark::State &state) {
+    auto shared = exec::SharedBasicBlockCache::Create();
+    std::vector<exec::BasicBlock const *> bbs =
+        PublishBlocks(*shared, state.range(0));
+
+    exec::BasicBlockCache cache;
+    for (auto bb : bbs) {
+        cache.insert(bb);
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.lookup(bbs[i]->getPC()));
+        i = (i + 1 == bbs.size() ? 0 : i + 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BasicBlockCacheHit)->Arg(1)->Arg(64)->Arg(1024);
+
+void BM_BasicBlockCacheMiss(benchmark::State &state) {
+    exec::BasicBlockCache cache;
+    RV64Ptr pc = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.lookup(pc));
+        pc += 8;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BasicBlockCacheMiss);
+
+/// The path a hart takes on a miss in its own cache
+void BM_SharedBasicBlockCacheLookup(benchmark::State &state) {
+    auto shared = exec::SharedBasicBlockCache::Create();
+    std::vector<exec::BasicBlock const *> bbs =
+        PublishBlocks(*shared, state.range(0));
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(shared->lookup(CodeHash, bbs[i]->getPC()));
+        i = (i + 1 == bbs.size() ? 0 : i + 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SharedBasicBlockCacheLookup)->Range(64, 64 << 10);
+
+} // namespace
@@ -0,0 +1,121 @@
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include "besm-666/memory/mmu.hpp"
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/memory/prefetcher.hpp"
+#include "besm-666/memory/ram.hpp"
+
+using namespace besm;
+
+namespace {
+
+constexpr size_t PageSize = 4096;
+constexpr size_t ChunkSize = 2 * 1024 * 1024;
+constexpr size_t MaxWorkingSet = 64 * 1024 * 1024;
+
+/*
+ * The accesses stride through a working set of state.range(0) bytes one
+ * cache line apart, wrapping at its end. The pages are touched before the
+ * timing starts, so the allocation isn't measured.
+ */
+
+void Touch(mem::RAM &ram, size_t workingSet) {
+    for (RV64Ptr address = 0; address < workingSet; address += PageSize) {
+        ram.storeDWord(address, 0);
+    }
+}
+
+void BM_RAMLoadDWord(benchmark::State &state) {
+    size_t workingSet = state.range(0);
+    mem::RAM ram(MaxWorkingSet, PageSize, ChunkSize);
+    Touch(ram, workingSet);
+
+    RV64Ptr address = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ram.loadDWord(address));
+        address = (address + 64) & (workingSet - 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RAMLoadDWord)->RangeMultiplier(16)->Range(4 << 10, 64 << 20);
+
+void BM_RAMStoreDWord(benchmark::State &state) {
+    size_t workingSet = state.range(0);
+    mem::RAM ram(MaxWorkingSet, PageSize, ChunkSize);
+    Touch(ram, workingSet);
+
+    RV64Ptr address = 0;
+    for (auto _ : state) {
+        ram.storeDWord(address, address);
+        address = (address + 64) & (workingSet - 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RAMStoreDWord)->RangeMultiplier(16)->Range(4 << 10, 64 << 20);
+
+/// RAM behind the device lookup of PhysMem
+void BM_PhysMemLoadDWord(benchmark::State &state) {
+    size_t workingSet = state.range(0);
+    std::shared_ptr<mem::PhysMem> pMem =
+        mem::PhysMemBuilder()
+            .mapRAM(0, MaxWorkingSet, PageSize, ChunkSize)
+            .build();
+    for (RV64Ptr address = 0; address < workingSet; address += PageSize) {
+        pMem->storeDWord(address, 0);
+    }
+
+    RV64Ptr address = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(pMem->loadDWord(address));
+        address = (address + 64) & (workingSet - 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PhysMemLoadDWord)->RangeMultiplier(16)->Range(4 << 10, 64 << 20);
+
+void BM_PhysMemStoreDWord(benchmark::State &state) {
+    size_t workingSet = state.range(0);
+    std::shared_ptr<mem::PhysMem> pMem =
+        mem::PhysMemBuilder()
+            .mapRAM(0, MaxWorkingSet, PageSize, ChunkSize)
+            .build();
+    for (RV64Ptr address = 0; address < workingSet; address += PageSize) {
+        pMem->storeDWord(address, 0);
+    }
+
+    RV64Ptr address = 0;
+    for (auto _ : state) {
+        pMem->storeDWord(address, address);
+        address = (address + 64) & (workingSet - 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PhysMemStoreDWord)->RangeMultiplier(16)->Range(4 << 10, 64 << 20);
+
+/**
+ * \p stride 4 fetches sequentially within the saved page, PageSize takes
+ * the slow path on every fetch
+ */
+void BM_PrefetcherLoadWord(benchmark::State &state) {
+    size_t stride = state.range(0);
+    std::shared_ptr<mem::PhysMem> pMem =
+        mem::PhysMemBuilder()
+            .mapRAM(0, 16 * PageSize, PageSize, ChunkSize)
+            .build();
+    for (RV64Ptr address = 0; address < 16 * PageSize; address += PageSize) {
+        pMem->storeWord(address, 0x00000013); // nop
+    }
+    mem::Prefetcher prefetcher(mem::MMU::Create(pMem));
+
+    RV64Ptr address = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(prefetcher.loadWord(address));
+        address = (address + stride) & (16 * PageSize - 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PrefetcherLoadWord)->Arg(4)->Arg(PageSize);
+
+} // namespace
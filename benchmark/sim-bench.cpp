@@ -0,0 +1,194 @@
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "besm-666/exec/basic-block.hpp"
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/hooks.hpp"
+
+using namespace besm;
+
+namespace {
+
+void BBFetchHook(exec::BasicBlock const &bb) {
+    benchmark::DoNotOptimize(bb.getPC());
+}
+
+void InstrExecHook(Instruction const &instr) {
+    benchmark::DoNotOptimize(instr.operation);
+}
+
+void BM_HookManagerTriggerBBFetch(benchmark::State &state) {
+    auto hookManager = sim::HookManager::Create();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        hookManager->registerBBFetchHook(BBFetchHook);
+    }
+
+    exec::BasicBlock bb;
+    for (auto _ : state) {
+        hookManager->triggerBBFetchHook(bb);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HookManagerTriggerBBFetch)->Arg(0)->Arg(1)->Arg(8);
+
+void BM_HookManagerTriggerInstrExec(benchmark::State &state) {
+    auto hookManager = sim::HookManager::Create();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        hookManager->registerInstrExecHook(InstrExecHook);
+    }
+
+    Instruction instr{};
+    for (auto _ : state) {
+        hookManager->triggerInstrExecHook(instr);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HookManagerTriggerInstrExec)->Arg(0)->Arg(1)->Arg(8);
+
+/// 1 << 20 iterations of a block of 6 arithmetic instructions
+RV64UWord const ALULoop[] = {
+    0x3e800313, // addi t1, zero, 1000
+    0x00a31313, // slli t1, t1, 10
+    0x006383b3, // loop: add t2, t2, t1
+    0x00339e13, // slli t3, t2, 3
+    0x01ceceb3, // xor t4, t4, t3
+    0x007ebf33, // sltu t5, t4, t2
+    0xfff30313, // addi t1, t1, -1
+    0xfe0316e3, // bnez t1, loop
+    0x00100073, // end: ebreak
+};
+constexpr RV64Ptr ALULoopEnd = 0x20;
+
+/// The same with a load and a store to a counter in each block
+RV64UWord const MemLoop[] = {
+    0x00100293, // addi t0, zero, 1
+    0x01029293, // slli t0, t0, 16
+    0x3e800313, // addi t1, zero, 1000
+    0x00a31313, // slli t1, t1, 10
+    0x0002b383, // loop: ld t2, 0(t0)
+    0x00138393, // addi t2, t2, 1
+    0x0072b023, // sd t2, 0(t0)
+    0x007e4e33, // xor t3, t3, t2
+    0xfff30313, // addi t1, t1, -1
+    0xfe0316e3, // bnez t1, loop
+    0x00100073, // end: ebreak
+};
+constexpr RV64Ptr MemLoopEnd = 0x28;
+
+/**
+ * Whole hart throughput, the "MIPS" counter is guest instructions per host
+ * second. A fresh hart and memory are built per iteration outside of the
+ * timing, so the decoding of the loop is included.
+ */
+template <size_t N>
+void BM_HartLoop(benchmark::State &state, RV64UWord const (&program)[N],
+                 RV64Ptr end) {
+    size_t instrs = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::shared_ptr<mem::PhysMem> pMem =
+            mem::PhysMemBuilder()
+                .mapRAM(0, 1024 * 1024, 4096, 64 * 1024)
+                .build();
+        pMem->storeContArea(0, program, sizeof(program));
+        sim::Hart::SPtr hart =
+            sim::Hart::Create(pMem, sim::HookManager::Create());
+        state.ResumeTiming();
+
+        hart->runUntil(end);
+        instrs += hart->getInstrsExecuted();
+    }
+    state.SetItemsProcessed(instrs);
+    state.counters["MIPS"] =
+        benchmark::Counter(instrs * 1e-6, benchmark::Counter::kIsRate);
+}
+BENCHMARK_CAPTURE(BM_HartLoop, alu, ALULoop, ALULoopEnd)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_HartLoop, mem, MemLoop, MemLoopEnd)
+    ->Unit(benchmark::kMillisecond);
+
+/// 1 << 16 atomic increments of the dword at 0x1000
+RV64UWord const AMOAddLoop[] = {
+    0x00100293, // addi t0, zero, 1
+    0x00c29293, // slli t0, t0, 12
+    0x00100313, // addi t1, zero, 1
+    0x01031313, // slli t1, t1, 16
+    0x00100393, // addi t2, zero, 1
+    0x0072b02f, // loop: amoadd.d zero, t2, (t0)
+    0xfff30313, // addi t1, t1, -1
+    0xfe031ce3, // bnez t1, loop
+    0x00100073, // ebreak
+};
+
+/// The same with an LR/SC retry loop
+RV64UWord const LRSCLoop[] = {
+    0x00100293, // addi t0, zero, 1
+    0x00c29293, // slli t0, t0, 12
+    0x00100313, // addi t1, zero, 1
+    0x01031313, // slli t1, t1, 16
+    0x1002b3af, // loop: lr.d t2, (t0)
+    0x00138393, // addi t2, t2, 1
+    0x1872be2f, // sc.d t3, t2, (t0)
+    0xfe0e1ae3, // bnez t3, loop
+    0xfff30313, // addi t1, t1, -1
+    0xfe0316e3, // bnez t1, loop
+    0x00100073, // ebreak
+};
+
+/**
+ * state.range(0) harts on their own host threads incrementing the same
+ * dword, "MIPS" is the guest instructions of all the harts per host second
+ */
+template <size_t N>
+void BM_HartContention(benchmark::State &state,
+                       RV64UWord const (&program)[N]) {
+    size_t numHarts = state.range(0);
+    size_t instrs = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::shared_ptr<mem::PhysMem> pMem =
+            mem::PhysMemBuilder()
+                .mapRAM(0, 1024 * 1024, 4096, 64 * 1024)
+                .build();
+        pMem->storeContArea(0, program, sizeof(program));
+        std::vector<sim::Hart::SPtr> harts;
+        for (size_t hartId = 0; hartId < numHarts; ++hartId) {
+            harts.push_back(
+                sim::Hart::Create(pMem, sim::HookManager::Create(), hartId));
+        }
+        state.ResumeTiming();
+
+        std::vector<std::thread> threads;
+        for (sim::Hart::SPtr const &hart : harts) {
+            threads.emplace_back([&hart] { hart->run(); });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+
+        for (sim::Hart::SPtr const &hart : harts) {
+            instrs += hart->getInstrsExecuted();
+        }
+    }
+    state.SetItemsProcessed(instrs);
+    state.counters["MIPS"] =
+        benchmark::Counter(instrs * 1e-6, benchmark::Counter::kIsRate);
+}
+BENCHMARK_CAPTURE(BM_HartContention, amoadd, AMOAddLoop)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_HartContention, lrsc, LRSCLoop)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,181 @@
+#include "bootstrap.h"
+
+/*
+ * CoreMark-like integer workload: linked list processing, matrix
+ * arithmetic and a state machine, all of them folded into a CRC16.
+ * The target has no M extension, multiplications go through libgcc.
+ */
+
+#define ITERATIONS 400
+#define LIST_SIZE 256
+#define MATRIX_SIZE 16
+#define INPUT_SIZE 512
+#define CRC_EXPECTED 0x6c7e
+
+struct node {
+    struct node *next;
+    rv64dw value;
+};
+
+struct node nodes[LIST_SIZE];
+rv64dw matrix_a[MATRIX_SIZE][MATRIX_SIZE];
+rv64dw matrix_b[MATRIX_SIZE][MATRIX_SIZE];
+rv64dw matrix_c[MATRIX_SIZE][MATRIX_SIZE];
+char input[INPUT_SIZE];
+
+rv64dw crc16(rv64dw crc, rv64dw value) {
+    for (int i = 0; i < 16; ++i) {
+        rv64dw bit = (crc ^ value) & 1;
+        value >>= 1;
+        crc >>= 1;
+        if (bit) {
+            crc ^= 0xA001;
+        }
+    }
+    return crc & 0xFFFF;
+}
+
+rv64dw xorshift(rv64dw *state) {
+    rv64dw x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+struct node *list_init(rv64dw *seed) {
+    for (int i = 0; i < LIST_SIZE; ++i) {
+        nodes[i].value = xorshift(seed) & 0xFFFF;
+        nodes[i].next = i + 1 < LIST_SIZE ? &nodes[i + 1] : 0;
+    }
+    return &nodes[0];
+}
+
+struct node *list_reverse(struct node *head) {
+    struct node *prev = 0;
+    while (head) {
+        struct node *next = head->next;
+        head->next = prev;
+        prev = head;
+        head = next;
+    }
+    return prev;
+}
+
+/* Insertion sort of the list by value */
+struct node *list_sort(struct node *head) {
+    struct node *sorted = 0;
+    while (head) {
+        struct node *next = head->next;
+        struct node **place = &sorted;
+        while (*place && (*place)->value < head->value) {
+            place = &(*place)->next;
+        }
+        head->next = *place;
+        *place = head;
+        head = next;
+    }
+    return sorted;
+}
+
+rv64dw list_bench(rv64dw crc, rv64dw *seed) {
+    struct node *head = list_init(seed);
+    head = list_reverse(head);
+    head = list_sort(head);
+    for (struct node *node = head; node; node = node->next) {
+        crc = crc16(crc, node->value);
+    }
+    return crc;
+}
+
+rv64dw matrix_bench(rv64dw crc, rv64dw *seed) {
+    for (int i = 0; i < MATRIX_SIZE; ++i) {
+        for (int j = 0; j < MATRIX_SIZE; ++j) {
+            matrix_a[i][j] = xorshift(seed) & 0xFF;
+            matrix_b[i][j] = xorshift(seed) & 0xFF;
+        }
+    }
+    for (int i = 0; i < MATRIX_SIZE; ++i) {
+        for (int j = 0; j < MATRIX_SIZE; ++j) {
+            rv64dw sum = 0;
+            for (int k = 0; k < MATRIX_SIZE; ++k) {
+                sum += matrix_a[i][k] * matrix_b[k][j];
+            }
+            matrix_c[i][j] = sum;
+        }
+    }
+    for (int i = 0; i < MATRIX_SIZE; ++i) {
+        crc = crc16(crc, matrix_c[i][i]);
+    }
+    return crc;
+}
+
+enum state { STATE_START, STATE_INT, STATE_HEX, STATE_WORD, STATE_INVALID };
+
+rv64dw state_bench(rv64dw crc, rv64dw *seed) {
+    static char const alphabet[16] = {'0', '1', '7', '9', 'x', 'a', 'f', 'z',
+                                      ' ', ' ', '-', '5', 'q', '3', ' ', ','};
+    for (int i = 0; i < INPUT_SIZE; ++i) {
+        input[i] = alphabet[xorshift(seed) & 0xF];
+    }
+
+    rv64dw counts[5];
+    for (int i = 0; i < 5; ++i) {
+        counts[i] = 0;
+    }
+    enum state state = STATE_START;
+    for (int i = 0; i < INPUT_SIZE; ++i) {
+        char c = input[i];
+        if (c == ' ' || c == ',') {
+            ++counts[state];
+            state = STATE_START;
+            continue;
+        }
+        switch (state) {
+        case STATE_START:
+            if (c >= '0' && c <= '9') {
+                state = STATE_INT;
+            } else if (c >= 'a' && c <= 'z') {
+                state = STATE_WORD;
+            } else {
+                state = STATE_INVALID;
+            }
+            break;
+        case STATE_INT:
+            if (c == 'x') {
+                state = STATE_HEX;
+            } else if (c < '0' || c > '9') {
+                state = STATE_INVALID;
+            }
+            break;
+        case STATE_HEX:
+            if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+                state = STATE_INVALID;
+            }
+            break;
+        case STATE_WORD:
+            if (c < 'a' || c > 'z') {
+                state = STATE_INVALID;
+            }
+            break;
+        case STATE_INVALID:
+            break;
+        }
+    }
+    for (int i = 0; i < 5; ++i) {
+        crc = crc16(crc, counts[i]);
+    }
+    return crc;
+}
+
+rv64dw start() {
+    rv64dw seed = 0x2545F4914F6CDD1D;
+    rv64dw crc = 0;
+    for (int i = 0; i < ITERATIONS; ++i) {
+        crc = list_bench(crc, &seed);
+        crc = matrix_bench(crc, &seed);
+        crc = state_bench(crc, &seed);
+    }
+    return crc == CRC_EXPECTED;
+}
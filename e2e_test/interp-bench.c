@@ -0,0 +1,138 @@
+#include "bootstrap.h"
+
+/*
+ * Branch-heavy workload: a switch-dispatched stack machine interpreting a
+ * program which sums the Collatz sequence lengths of the first numbers.
+ */
+
+#define LIMIT 30000
+#define SUM_EXPECTED 0x2bb4b7
+
+enum op {
+    OP_PUSH,  // push imm
+    OP_LOAD,  // push var[imm]
+    OP_STORE, // var[imm] = pop
+    OP_ADD,
+    OP_SUB,
+    OP_AND,
+    OP_SHR1,
+    OP_TRIPLE_INC, // x -> 3 * x + 1
+    OP_JZ,         // pc = imm if pop == 0
+    OP_JMP,
+    OP_HALT
+};
+
+struct instr {
+    enum op op;
+    int imm;
+};
+
+enum { VAR_N, VAR_X, VAR_SUM, VAR_LIMIT, NUM_VARS };
+
+/*
+ *   n = LIMIT
+ * outer:
+ *   if n == 0 goto done
+ *   x = n
+ * inner:
+ *   if x - 1 == 0 goto next
+ *   sum = sum + 1
+ *   if x & 1 == 0 goto even
+ *   x = 3 * x + 1; goto inner
+ * even:
+ *   x = x >> 1; goto inner
+ * next:
+ *   n = n - 1; goto outer
+ * done:
+ */
+struct instr const program[] = {
+    /*  0 */ {OP_LOAD, VAR_LIMIT},
+    /*  1 */ {OP_STORE, VAR_N},
+    /*  2 */ {OP_LOAD, VAR_N},
+    /*  3 */ {OP_JZ, 32},
+    /*  4 */ {OP_LOAD, VAR_N},
+    /*  5 */ {OP_STORE, VAR_X},
+    /*  6 */ {OP_LOAD, VAR_X},
+    /*  7 */ {OP_PUSH, 1},
+    /*  8 */ {OP_SUB, 0},
+    /*  9 */ {OP_JZ, 27},
+    /* 10 */ {OP_LOAD, VAR_SUM},
+    /* 11 */ {OP_PUSH, 1},
+    /* 12 */ {OP_ADD, 0},
+    /* 13 */ {OP_STORE, VAR_SUM},
+    /* 14 */ {OP_LOAD, VAR_X},
+    /* 15 */ {OP_PUSH, 1},
+    /* 16 */ {OP_AND, 0},
+    /* 17 */ {OP_JZ, 22},
+    /* 18 */ {OP_LOAD, VAR_X},
+    /* 19 */ {OP_TRIPLE_INC, 0},
+    /* 20 */ {OP_STORE, VAR_X},
+    /* 21 */ {OP_JMP, 6},
+    /* 22 */ {OP_LOAD, VAR_X},
+    /* 23 */ {OP_SHR1, 0},
+    /* 24 */ {OP_STORE, VAR_X},
+    /* 25 */ {OP_JMP, 6},
+    /* 26 */ {OP_HALT, 0},
+    /* 27 */ {OP_LOAD, VAR_N},
+    /* 28 */ {OP_PUSH, 1},
+    /* 29 */ {OP_SUB, 0},
+    /* 30 */ {OP_STORE, VAR_N},
+    /* 31 */ {OP_JMP, 2},
+    /* 32 */ {OP_HALT, 0},
+};
+
+rv64dw vars[NUM_VARS];
+rv64dw stack[16];
+
+rv64dw interpret(struct instr const *code) {
+    rv64dw *sp = stack;
+    int pc = 0;
+    for (;;) {
+        struct instr const *instr = &code[pc++];
+        switch (instr->op) {
+        case OP_PUSH:
+            *sp++ = instr->imm;
+            break;
+        case OP_LOAD:
+            *sp++ = vars[instr->imm];
+            break;
+        case OP_STORE:
+            vars[instr->imm] = *--sp;
+            break;
+        case OP_ADD:
+            --sp;
+            sp[-1] += sp[0];
+            break;
+        case OP_SUB:
+            --sp;
+            sp[-1] -= sp[0];
+            break;
+        case OP_AND:
+            --sp;
+            sp[-1] &= sp[0];
+            break;
+        case OP_SHR1:
+            sp[-1] >>= 1;
+            break;
+        case OP_TRIPLE_INC:
+            sp[-1] = (sp[-1] << 1) + sp[-1] + 1;
+            break;
+        case OP_JZ:
+            if (*--sp == 0) {
+                pc = instr->imm;
+            }
+            break;
+        case OP_JMP:
+            pc = instr->imm;
+            break;
+        case OP_HALT:
+            return vars[VAR_SUM];
+        }
+    }
+}
+
+rv64dw start() {
+    vars[VAR_LIMIT] = LIMIT;
+    rv64dw sum = interpret(program);
+    return sum == SUM_EXPECTED;
+}
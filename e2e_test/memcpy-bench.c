@@ -0,0 +1,68 @@
+#include "bootstrap.h"
+
+/*
+ * memcpy/memset-heavy loops: byte and double word copies and fills over
+ * buffers spanning several RAM pages, at aligned and unaligned offsets.
+ * Built with -fno-tree-loop-distribute-patterns, so the loops aren't
+ * turned into calls of the missing libc functions.
+ */
+
+#define ITERATIONS 256
+#define BUFFER_SIZE (64 * 1024)
+#define SUM_EXPECTED 0xebfb248fa6262d49
+
+rv64dw src[BUFFER_SIZE / 8];
+rv64dw dst[BUFFER_SIZE / 8];
+
+void copy_bytes(char *to, char const *from, rv64dw size) {
+    for (rv64dw i = 0; i < size; ++i) {
+        to[i] = from[i];
+    }
+}
+
+void copy_dwords(rv64dw *to, rv64dw const *from, rv64dw size) {
+    for (rv64dw i = 0; i < size; ++i) {
+        to[i] = from[i];
+    }
+}
+
+void fill_bytes(char *to, char value, rv64dw size) {
+    for (rv64dw i = 0; i < size; ++i) {
+        to[i] = value;
+    }
+}
+
+void fill_dwords(rv64dw *to, rv64dw value, rv64dw size) {
+    for (rv64dw i = 0; i < size; ++i) {
+        to[i] = value;
+    }
+}
+
+rv64dw checksum(rv64dw const *buffer, rv64dw size) {
+    rv64dw sum = 0;
+    for (rv64dw i = 0; i < size; ++i) {
+        sum = (sum << 5 | sum >> 59) + buffer[i];
+    }
+    return sum;
+}
+
+rv64dw start() {
+    for (rv64dw i = 0; i < BUFFER_SIZE / 8; ++i) {
+        src[i] = i ^ (i << 17) ^ 0x5555AAAA5555AAAA;
+    }
+
+    rv64dw sum = 0;
+    for (rv64dw i = 0; i < ITERATIONS; ++i) {
+        rv64dw offset = i & 7;
+        copy_dwords(dst, src, BUFFER_SIZE / 8);
+        sum ^= checksum(dst, BUFFER_SIZE / 8);
+        copy_bytes((char *)dst + offset, (char const *)src,
+                   BUFFER_SIZE - 8);
+        sum ^= checksum(dst, BUFFER_SIZE / 8);
+        fill_bytes((char *)dst + offset, (char)i, BUFFER_SIZE - 8);
+        sum ^= checksum(dst, BUFFER_SIZE / 8);
+        fill_dwords(dst, sum, BUFFER_SIZE / 8);
+        sum += checksum(dst, BUFFER_SIZE / 8);
+    }
+    return sum == SUM_EXPECTED;
+}
@@ -0,0 +1,60 @@
+#include "bootstrap.h"
+
+/*
+ * Pointer chasing over a single random cycle through 8 MiB, so every load
+ * goes to another RAM page and the host caches don't help.
+ */
+
+#define NODES (1024 * 1024)
+#define STEPS (8 * 1024 * 1024)
+#define SUM_EXPECTED 0xb40f09e5851f5698
+
+rv64dw next[NODES];
+
+rv64dw xorshift(rv64dw *state) {
+    rv64dw x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+/* Uniform in [0, bound), by rejection: the target has no division */
+rv64dw random_below(rv64dw *state, rv64dw bound) {
+    rv64dw mask = bound - 1;
+    mask |= mask >> 1;
+    mask |= mask >> 2;
+    mask |= mask >> 4;
+    mask |= mask >> 8;
+    mask |= mask >> 16;
+    mask |= mask >> 32;
+    rv64dw value;
+    do {
+        value = xorshift(state) & mask;
+    } while (value >= bound);
+    return value;
+}
+
+rv64dw start() {
+    rv64dw seed = 0x9E3779B97F4A7C15;
+
+    // Sattolo's algorithm gives a single cycle through all the nodes
+    for (rv64dw i = 0; i < NODES; ++i) {
+        next[i] = i;
+    }
+    for (rv64dw i = NODES - 1; i > 0; --i) {
+        rv64dw j = random_below(&seed, i);
+        rv64dw tmp = next[i];
+        next[i] = next[j];
+        next[j] = tmp;
+    }
+
+    rv64dw node = 0;
+    rv64dw sum = 0;
+    for (rv64dw step = 0; step < STEPS; ++step) {
+        node = next[node];
+        sum = (sum << 1 | sum >> 63) + node;
+    }
+    return sum == SUM_EXPECTED;
+}
@@ -168,7 +168,7 @@ constexpr static Cell INSTR_WHO[128][8] = {
         {ILLEGAL, INV_OP},
     }, // opcode: 0b1110
     {
-        {I, PAUSE},
+        {I, INV_OP},
         {I, INV_OP},
         {I, INV_OP},
         {I, INV_OP},
@@ -490,8 +490,8 @@ constexpr static Cell INSTR_WHO[128][8] = {
     {
         {ILLEGAL, INV_OP},
         {ILLEGAL, INV_OP},
-        {ILLEGAL, INV_OP},
-        {ILLEGAL, INV_OP},
+        {R, INV_OP},
+        {R, INV_OP},
         {ILLEGAL, INV_OP},
         {ILLEGAL, INV_OP},
         {ILLEGAL, INV_OP},
@@ -1,12 +1,16 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <vector>
 
 #include "besm-666/instruction.hpp"
 #include "besm-666/util/math.hpp"
+#include "besm-666/util/non-copyable.hpp"
 
 namespace besm::exec {
 
@@ -21,14 +25,86 @@ public:
     Instruction const *getInstructions() const noexcept {
         return instrs_.data();
     }
+    /// Instructions of the block, BB_END aside
+    size_t getSize() const noexcept { return size_; }
+
+    /**
+     * Dense id assigned by SharedBasicBlockCache on publish, starting from
+     * 1, so per-block data may live in arrays. 0 if the block hasn't been
+     * published.
+     */
+    size_t getId() const noexcept { return id_; }
 
 private:
     friend class BasicBlockRebuilder;
+    friend class SharedBasicBlockCache;
 
     InstrStorage instrs_;
     RV64Ptr pc_;
+    size_t size_;
+    size_t id_;
 };
 
+/**
+ * Process-wide store of decoded basic blocks. A block is identified by the
+ * hash of the code image it has been decoded from and its PC, so the harts
+ * of all the machines running the same program decode each block once.
+ *
+ * Published blocks are immutable and live as long as the cache. Lookups
+ * take no locks: a bucket is the atomic head of a singly linked list which
+ * only grows at the head, and a block is published with a release
+ * compare-and-swap once it is fully built.
+ */
+class SharedBasicBlockCache : INonCopyable {
+public:
+    using SPtr = std::shared_ptr<SharedBasicBlockCache>;
+
+    static SPtr Create();
+
+    /// The cache shared by all the machines of the process
+    static SPtr const &Global();
+
+    ~SharedBasicBlockCache();
+
+    /// Returns nullptr if the block hasn't been published
+    BasicBlock const *lookup(uint64_t codeHash, RV64Ptr pc) const noexcept;
+
+    /**
+     * Publishes a copy of \p bb. If another thread has published the same
+     * block first, its block is returned and the copy is dropped.
+     */
+    BasicBlock const *publish(uint64_t codeHash, BasicBlock const &bb);
+
+    size_t getBlocksNum() const noexcept {
+        return blocksNum_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr size_t kBucketBits = 14;
+    static constexpr size_t kBuckets = (1ull << kBucketBits);
+
+    struct Node {
+        uint64_t codeHash;
+        BasicBlock bb;
+        Node const *next;
+    };
+
+    SharedBasicBlockCache();
+
+    static size_t GetBucket(uint64_t codeHash, RV64Ptr pc) noexcept;
+    static BasicBlock const *Find(Node const *node, Node const *end,
+                                  uint64_t codeHash, RV64Ptr pc) noexcept;
+
+    std::unique_ptr<std::atomic<Node const *>[]> buckets_;
+    std::atomic<size_t> blocksNum_;
+    std::atomic<size_t> nextId_;
+};
+
+/**
+ * Hart-private set-associative cache of pointers to the blocks of a
+ * SharedBasicBlockCache, it only spares the hart the hashing and the
+ * bucket walk.
+ */
 class BasicBlockCache {
 public:
     static constexpr size_t kSetBits = 7;
@@ -42,10 +118,16 @@ public:
 
     BasicBlockCache();
 
-    std::pair<bool, BasicBlock &> lookup(RV64Ptr pc);
+    /// Returns nullptr on a miss
+    BasicBlock const *lookup(RV64Ptr pc) const noexcept;
+
+    /// Replaces the least recently inserted block of the set
+    void insert(BasicBlock const *bb) noexcept;
 
 private:
-    std::array<BasicBlock, kSets * kWays> bbs_;
+    static size_t GetSet(RV64Ptr pc) noexcept;
+
+    std::array<BasicBlock const *, kSets * kWays> bbs_;
     std::array<size_t, kSets> lruRowers_;
 };
 
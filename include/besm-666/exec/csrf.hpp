@@ -48,6 +48,8 @@ private:
 public:
     MHartID mhartid;
     MStatus mstatus;
+    MIE mie;
+    MIP mip;
     MEPC mepc;
     MTVec mtvec;
     MCause mcause;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <iostream>
 
 #include "besm-666/exec/csr.hpp"
@@ -23,6 +24,9 @@ class MStatus final : public CSRStructure<MStatusDefs::SIE, MStatusDefs::MIE,
                                           MStatusDefs::SPP, MStatusDefs::MPP>,
                       public MStatusDefs {
 public:
+    // Hides ICSR::MIE register id
+    using MIE = MStatusDefs::MIE;
+
     MStatus(CSRF &csrf) : CSRStructure(csrf, ICSR::MSTATUS) {}
     ~MStatus() = default;
 };
@@ -74,9 +78,51 @@ public:
     MTVec(CSRF &csrf) : CSRStructure(csrf, ICSR::MTVEC) {}
 };
 
+class MIEDefs {
+public:
+    using MSIE = CSRUncheckedField<MIP_MSIP>;
+    using MTIE = CSRUncheckedField<MIP_MTIP>;
+    using MEIE = CSRUncheckedField<MIP_MEIP>;
+};
+
+class MIE final
+    : public CSRStructure<MIEDefs::MSIE, MIEDefs::MTIE, MIEDefs::MEIE>,
+      public MIEDefs {
+public:
+    MIE(CSRF &csrf) : CSRStructure(csrf, ICSR::MIE) {}
+};
+
+/**
+ * Machine interrupt pending bits. MSIP, MTIP and MEIP are read-only for the
+ * guest: they are driven by devices, which may raise and clear them from any
+ * host thread.
+ */
+class MIP final : public ICSR {
+public:
+    MIP(CSRF &csrf) : ICSR(csrf, ICSR::MIP) {}
+
+    RV64UDWord read() const noexcept override {
+        return pending_.load(std::memory_order_relaxed);
+    }
+    bool write(RV64UDWord) noexcept override { return true; }
+
+    void raise(RV64UDWord mask) noexcept {
+        pending_.fetch_or(mask, std::memory_order_acq_rel);
+    }
+    void clear(RV64UDWord mask) noexcept {
+        pending_.fetch_and(~mask, std::memory_order_acq_rel);
+    }
+
+protected:
+    void onUpdate() noexcept override {}
+
+private:
+    std::atomic<RV64UDWord> pending_{0};
+};
+
 class MHartIDDefs {
 public:
-    using Value = CSRUncheckedField<0b11>;
+    using Value = CSRUncheckedField<~static_cast<RV64UDWord>(0)>;
 };
 
 class MHartID : public CSRStructure<MHartIDDefs::Value>, public MHartIDDefs {
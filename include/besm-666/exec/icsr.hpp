@@ -20,9 +20,11 @@ public:
         MCONFIGPTR = 0xF15,
 
         MSTATUS = 0x300,
+        MIE = 0x304,
         MTVEC = 0x305,
         MEPC = 0x341,
         MCAUSE = 0x342,
+        MIP = 0x344,
 
         NUM_IDS
     };
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "besm-666/exec/csrs.hpp"
+#include "besm-666/memory/phys-mem-device.hpp"
+#include "besm-666/riscv-types.hpp"
+
+namespace besm::mem {
+
+/**
+ * SiFive-compatible core-local interruptor: msip, mtimecmp and mtime
+ * registers.
+ *
+ * Time is virtual: the hart is assumed to retire one instruction per
+ * nanosecond, so mtime = instrsExecuted * frequency / 1GHz and no host clock
+ * is ever read. A mtimecmp store converts the compare value into an
+ * instruction count deadline, which the hart compares with its own counter
+ * at basic block boundaries (see getDeadline()).
+ *
+ * mtime is read from the clock of hart 0, each hart compares its own
+ * mtimecmp with its own clock, unless a time source is set (see
+ * setTimeSource()). MTIP and MSIP are driven into the mip of the attached
+ * harts.
+ */
+class CLINT final : public IPhysMemDevice {
+public:
+    using SPtr = std::shared_ptr<CLINT>;
+
+    static constexpr RV64Ptr kMSIPBase = 0x0;
+    static constexpr RV64Ptr kMTimeCmpBase = 0x4000;
+    static constexpr RV64Ptr kMTime = 0xBFF8;
+    static constexpr size_t kSize = 0x10000;
+    static constexpr size_t kMaxHarts = 4095;
+
+    static constexpr RV64UDWord kHartFrequency = 1'000'000'000;
+    static constexpr RV64UDWord kNoDeadline = ~static_cast<RV64UDWord>(0);
+
+    /**
+     * \param frequency mtime ticks per second of virtual time, must not
+     * exceed kHartFrequency
+     */
+    static SPtr Create(size_t numHarts, RV64UDWord frequency);
+
+    RV64UChar loadByte(RV64Ptr address) const override;
+    RV64UHWord loadHWord(RV64Ptr address) const override;
+    RV64UWord loadWord(RV64Ptr address) const override;
+    RV64UDWord loadDWord(RV64Ptr address) const override;
+
+    void storeByte(RV64Ptr address, RV64UChar value) override;
+    void storeHWord(RV64Ptr address, RV64UHWord value) override;
+    void storeWord(RV64Ptr address, RV64UWord value) override;
+    void storeDWord(RV64Ptr address, RV64UDWord value) override;
+
+    // Registers have no host memory behind them
+    std::pair<void const *, size_t>
+    getHostAddress(RV64Ptr address) const override;
+    std::pair<void *, size_t> touchHostAddress(RV64Ptr address) override;
+
+    size_t getSize() const noexcept override;
+
+    /**
+     * Binds the hart clock and interrupt pending bits, both must outlive the
+     * device
+     */
+    void attachHart(size_t hartId,
+                    std::atomic<size_t> const *instrsExecuted,
+                    exec::MIP &mip);
+
+    /**
+     * Instruction count at which the hart timer fires, kNoDeadline if the
+     * timer is disarmed or has already fired
+     */
+    std::atomic<RV64UDWord> const &getDeadline(size_t hartId) const;
+
+    /**
+     * Called by the hart once its deadline has passed: latches MTIP and
+     * disarms the deadline until the next mtimecmp store
+     */
+    void expireTimer(size_t hartId);
+
+    bool timerPending(size_t hartId) const;
+    bool softwarePending(size_t hartId) const;
+
+    RV64UDWord getTime() const noexcept;
+
+    /**
+     * Makes mtime follow \p instrs instead of the clock of hart 0, the
+     * counter must outlive the device. Null restores the clock of hart 0.
+     *
+     * The hart clocks are not kept in step with the source, so the timers
+     * are then fired by expireTimers() rather than by the harts.
+     */
+    void setTimeSource(std::atomic<size_t> const *instrs);
+
+    /**
+     * Fires the timers whose mtimecmp the time source has reached, called
+     * by the owner of the source after advancing it
+     */
+    void expireTimers();
+
+private:
+    /// Armed deadline never reached by the hart clock, see expireTimers()
+    static constexpr RV64UDWord kTimeSourceDeadline = kNoDeadline - 1;
+
+    struct HartState {
+        std::atomic<size_t> const *instrsExecuted = nullptr;
+        exec::MIP *mip = nullptr;
+        RV64UDWord mtimecmp = kNoDeadline;
+        std::atomic<RV64UDWord> deadline{kNoDeadline};
+        std::atomic<bool> mtip{false};
+        std::atomic<bool> msip{false};
+    };
+
+    CLINT(size_t numHarts, RV64UDWord frequency);
+
+    HartState &hart(size_t hartId) const;
+
+    RV64UDWord toTime(size_t instrs) const noexcept;
+    RV64UDWord toInstrs(RV64UDWord time) const noexcept;
+
+    void updateDeadline(size_t hartId);
+    void setPending(HartState &state, RV64UDWord mask, bool pending);
+
+    RV64UDWord readRegister(RV64Ptr address, size_t size) const;
+    void writeRegister(RV64Ptr address, size_t size, RV64UDWord value);
+
+    size_t numHarts_;
+    RV64UDWord frequency_;
+    RV64UDWord timeOffset_; ///< set by mtime stores, a delta modulo 2^64
+    std::atomic<size_t> const *timeSource_;
+    std::unique_ptr<HartState[]> harts_;
+};
+
+} // namespace besm::mem
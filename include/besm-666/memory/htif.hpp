@@ -0,0 +1,91 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "besm-666/memory/phys-mem-device.hpp"
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/riscv-types.hpp"
+
+namespace besm::mem {
+
+/**
+ * Berkeley Host-Target Interface: the tohost/fromhost register pair used by
+ * riscv-tests and bare-metal newlib ports to report completion and to print.
+ *
+ * Guest stores only latch the register value. Commands are served by
+ * process(), which the hart calls at basic block boundaries when pending()
+ * reports a non-zero tohost, so the device costs nothing on the store path.
+ *
+ * Supported commands (tohost layout is device[63:56] cmd[55:48] payload):
+ *  - device 0, cmd 0, payload & 1: exit with code payload >> 1
+ *  - device 0, cmd 0, otherwise: payload points to magic_mem syscall frame
+ *    {num, arg0, arg1, arg2, ...}, only write(2) to stdout/stderr is served
+ *  - device 1, cmd 1: put character payload & 0xFF to the console
+ */
+class HTIF final : public IPhysMemDevice {
+public:
+    using SPtr = std::shared_ptr<HTIF>;
+
+    /**
+     * \param tohost guest physical address of the tohost register
+     * \param fromhost guest physical address of the fromhost register, it is
+     * placed right after tohost if the program does not define it
+     */
+    static SPtr Create(RV64Ptr tohost, std::optional<RV64Ptr> fromhost);
+
+    RV64UChar loadByte(RV64Ptr address) const override;
+    RV64UHWord loadHWord(RV64Ptr address) const override;
+    RV64UWord loadWord(RV64Ptr address) const override;
+    RV64UDWord loadDWord(RV64Ptr address) const override;
+
+    void storeByte(RV64Ptr address, RV64UChar value) override;
+    void storeHWord(RV64Ptr address, RV64UHWord value) override;
+    void storeWord(RV64Ptr address, RV64UWord value) override;
+    void storeDWord(RV64Ptr address, RV64UDWord value) override;
+
+    std::pair<void const *, size_t>
+    getHostAddress(RV64Ptr address) const override;
+    std::pair<void *, size_t> touchHostAddress(RV64Ptr address) override;
+
+    size_t getSize() const noexcept override;
+
+    RV64Ptr getBaseAddress() const noexcept { return baseAddress_; }
+
+    bool pending() const noexcept {
+        return __atomic_load_n(&regs_[tohostIdx_], __ATOMIC_RELAXED) != 0;
+    }
+
+    /**
+     * Serves the command latched in tohost and clears it. Returns false if
+     * the guest has requested to exit.
+     *
+     * Harts may call it concurrently, the command is claimed by exchanging
+     * tohost with zero, so it is served once.
+     */
+    bool process(PhysMem &pMem);
+
+    bool exited() const noexcept { return exited_; }
+    int exitCode() const noexcept { return exitCode_; }
+
+private:
+    static constexpr RV64UDWord kSyscallWrite = 64;
+
+    HTIF(RV64Ptr tohost, RV64Ptr fromhost);
+
+    RV64DWord doSyscall(PhysMem &pMem, RV64Ptr magicMem);
+
+    template <typename DataType> DataType load(RV64Ptr address) const;
+    template <typename DataType> void store(RV64Ptr address, DataType value);
+
+    RV64Ptr baseAddress_;
+    size_t tohostIdx_;
+    size_t fromhostIdx_;
+    std::vector<RV64UDWord> regs_;
+
+    bool exited_;
+    int exitCode_;
+};
+
+} // namespace besm::mem
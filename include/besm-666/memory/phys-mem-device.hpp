@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <memory>
 #include <stdexcept>
@@ -17,6 +18,7 @@ public:
         RAM,
         UART,
         TIMER,
+        HTIF,
 
         NUM_TYPES
     };
@@ -46,8 +48,23 @@ public:
     Type getType() const noexcept;
     std::string getTypeName() const;
 
+    /**
+     * Guest loads and stores served by the device. Only memory mapped
+     * registers are counted, RAM reports its touched pages instead, which
+     * keeps the counting off the per-instruction path.
+     */
+    size_t getAccessesNum() const noexcept {
+        return accessesNum_.load(std::memory_order_relaxed);
+    }
+
+protected:
+    void countAccess() const noexcept {
+        accessesNum_.fetch_add(1, std::memory_order_relaxed);
+    }
+
 private:
     Type type_;
+    mutable std::atomic<size_t> accessesNum_;
 };
 
 } // namespace besm::mem
@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "besm-666/memory/phys-mem-device.hpp"
 #include "besm-666/riscv-types.hpp"
@@ -13,9 +14,21 @@
 
 namespace besm::mem {
 
+class CLINT;
+class HTIF;
+class RAMChunkPool;
+class SharedImage;
+class UART;
+
 using PhysMemDeviceMap =
     std::map<util::Range<RV64Ptr>, std::shared_ptr<IPhysMemDevice>>;
 
+/**
+ * Physical address space of a machine. The device map is immutable once
+ * built, so harts may access the memory concurrently from several host
+ * threads. Plain loads and stores reach the host memory as plain host
+ * accesses, their ordering is the one of the host.
+ */
 class PhysMem : public INonCopyable {
 public:
     ~PhysMem() = default;
@@ -35,6 +48,13 @@ public:
     std::pair<void const *, size_t> getHostAddress(RV64Ptr address) const;
     std::pair<void *, size_t> touchHostAddress(RV64Ptr address);
 
+    /**
+     * Backs [address, address + size) with a copy-on-write mapping of the
+     * file, see RAM::mapFile(). Returns false if the range isn't in a
+     * single RAM or can't be mapped.
+     */
+    bool mapFile(RV64Ptr address, size_t size, int fd, size_t offset);
+
     struct DeviceDescriptor {
         util::Range<RV64Ptr> const range;
         std::shared_ptr<IPhysMemDevice const> const device;
@@ -45,17 +65,21 @@ public:
 private:
     friend class PhysMemBuilder;
 
-    PhysMem(PhysMemDeviceMap &&devices)
-        : devices_(std::move(devices)), lastAccessedRange_(0, 0) {}
+    PhysMem(PhysMemDeviceMap &&devices) : devices_(std::move(devices)) {}
 
-    std::pair<util::Range<RV64Ptr>, std::shared_ptr<IPhysMemDevice>>
+    // Raw pointer: copying shared_ptr on each access would make harts
+    // contend on the reference counter
+    std::pair<util::Range<RV64Ptr>, IPhysMemDevice *>
     findDevice(RV64Ptr address) const;
 
-    PhysMemDeviceMap devices_;
-    mutable util::Range<RV64Ptr> lastAccessedRange_;
-    mutable std::shared_ptr<IPhysMemDevice> lastAccessedDevice_;
+    PhysMemDeviceMap const devices_;
 };
 
+/**
+ * Devices may be mapped over RAM: RAM ranges are created on build() with
+ * holes left for the devices, so a device always shadows the RAM beneath it.
+ * RAM ranges may not intersect each other, nor may devices.
+ */
 class PhysMemBuilder {
 public:
     BESM_UTIL_DUMMY_EXCEPTION(MappingIntersection);
@@ -65,16 +89,33 @@ public:
 
     PhysMemBuilder &mapRAM(RV64Ptr address, size_t ramSize, size_t ramPageSize,
                            size_t ramChunkSize);
-    PhysMemBuilder &mapUART();
-    PhysMemBuilder &mapTimer();
+    PhysMemBuilder &mapHTIF(std::shared_ptr<HTIF> const &htif);
+    PhysMemBuilder &mapUART(RV64Ptr address,
+                            std::shared_ptr<UART> const &uart);
+    PhysMemBuilder &mapTimer(RV64Ptr address,
+                             std::shared_ptr<CLINT> const &clint);
+
+    /// RAMs built afterwards recycle their chunks through \p pool
+    PhysMemBuilder &setRAMChunkPool(std::shared_ptr<RAMChunkPool> pool);
 
     std::shared_ptr<PhysMem> build();
 
 private:
+    struct RAMDescriptor {
+        util::Range<RV64Ptr> range;
+        size_t pageSize;
+        size_t chunkSize;
+    };
+
     void mapDevice(std::shared_ptr<IPhysMemDevice> const &device,
                    RV64Ptr address);
 
+    static bool Intersect(util::Range<RV64Ptr> lhs,
+                          util::Range<RV64Ptr> rhs) noexcept;
+
     PhysMemDeviceMap devices_;
+    std::vector<RAMDescriptor> rams_;
+    std::shared_ptr<RAMChunkPool> ramChunkPool_;
 };
 
 class PhysMemLoader {
@@ -82,6 +123,13 @@ public:
     PhysMemLoader(std::shared_ptr<PhysMem> const &physMem);
 
     void loadElf(std::filesystem::path const &elfPath);
+    void loadElf(util::IElfParser &parser);
+
+    /**
+     * Loads \p parser as loadElf() does, but maps the read-only pages from
+     * \p image instead of copying them where RAM allows
+     */
+    void loadElf(util::IElfParser &parser, SharedImage const &image);
     void loadIso(std::filesystem::path const &isoPath);
     void loadBin(RV64Ptr address, std::filesystem::path const &isoPath);
 
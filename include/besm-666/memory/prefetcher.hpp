@@ -20,6 +20,9 @@ public:
      */
     RV64UWord loadWord(RV64Ptr vaddress);
 
+    /// Number of host address lookups made through MMU
+    size_t getTranslationsNum() const { return translationsNum_; }
+
 private:
     mem::MMU::SPtr mmu_;
 
@@ -37,6 +40,8 @@ private:
      * Number of continuous bytes starting from {@link Prefetcher::start_}
      */
     RV64Size len_;
+
+    size_t translationsNum_;
 };
 
 } // namespace besm::mem
@@ -1,34 +1,78 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
-#include <set>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "besm-666/memory/phys-mem-device.hpp"
 #include "besm-666/riscv-types.hpp"
 #include "besm-666/util/non-copyable.hpp"
+#include "besm-666/util/tracer.hpp"
 
 namespace besm::mem {
 
+/**
+ * Keeps the chunks of destroyed RAMs mapped, so the RAMs created later with
+ * the same pool take them instead of mapping fresh memory. A chunk is zeroed
+ * up to its allocation mark when it is returned, so the pages touched by the
+ * previous owner stay resident and don't fault again. The pool is shared by
+ * RAMs on different host threads and holds up to their peak memory.
+ */
+class RAMChunkPool final : public INonCopyable {
+public:
+    using SPtr = std::shared_ptr<RAMChunkPool>;
+
+    static SPtr Create();
+    ~RAMChunkPool();
+
+    /// Returns a zeroed mapping of \p size bytes, nullptr if there is none
+    char *take(size_t size);
+
+    /**
+     * Takes the ownership of the mapping, only the first \p used bytes may
+     * be non-zero
+     */
+    void give(char *data, size_t size, size_t used);
+
+    size_t getChunksNum() const;
+
+private:
+    RAMChunkPool() = default;
+
+    mutable std::mutex mutex_;
+    std::vector<std::pair<char *, size_t>> chunks_;
+};
+
 class RAMPageAllocator final : public INonCopyable {
 public:
-    RAMPageAllocator(size_t pageSize, size_t chunkSize);
+    /**
+     * \param pool chunks are taken from and returned to the pool, mapped
+     * and unmapped directly if null
+     */
+    RAMPageAllocator(size_t pageSize, size_t chunkSize,
+                     RAMChunkPool::SPtr pool = nullptr);
     RAMPageAllocator(RAMPageAllocator &&other) noexcept;
     ~RAMPageAllocator() = default;
 
     void *allocPage();
 
+    size_t getChunksNum() const noexcept { return chunks_.size(); }
+
 private:
     class Chunk;
 
     size_t chunkSize_;
     size_t pageSize_;
+    RAMChunkPool::SPtr pool_; ///< outlives chunks_
     std::vector<Chunk> chunks_;
 };
 
 class RAMPageAllocator::Chunk final : public INonCopyable {
 public:
-    Chunk(size_t pageSize, size_t chunkSize);
+    Chunk(size_t pageSize, size_t chunkSize, RAMChunkPool *pool);
     Chunk(Chunk &&other) noexcept;
     ~Chunk();
 
@@ -39,13 +83,20 @@ private:
     char *rower_;
     size_t size_;
     size_t pageSize_;
+    RAMChunkPool *pool_;
 };
 
+/**
+ * Lazily allocated RAM. Pages are looked up in a two-level table of atomic
+ * pointers, so harts on different host threads access RAM without locks,
+ * only the allocation of a new page is serialized.
+ */
 class RAM final : public mem::IPhysMemDevice {
 public:
-    RAM(size_t ramSize, size_t pageSize, size_t chunkSize);
+    RAM(size_t ramSize, size_t pageSize, size_t chunkSize,
+        RAMChunkPool::SPtr pool = nullptr);
     RAM(RAM &&other);
-    ~RAM() {}
+    ~RAM();
 
     RV64UChar loadByte(RV64Ptr address) const override;
     RV64UHWord loadHWord(RV64Ptr address) const override;
@@ -62,19 +113,32 @@ public:
     std::pair<void *, size_t> touchHostAddress(RV64Ptr address) override;
 
     size_t getSize() const noexcept override;
+    size_t getPageSize() const noexcept { return pageSize_; }
+
+    /// Pages backed by host memory, allocated or mapped from a file
+    size_t getPagesTouched() const noexcept {
+        return pagesTouched_.load(std::memory_order_relaxed);
+    }
+    /// Allocator chunks taken by the RAM, the mapped files aside
+    size_t getChunksNum() const;
+
+    /**
+     * Backs the pages of [address, address + size) with a private
+     * copy-on-write mapping of the file \p fd from \p offset, so RAMs
+     * mapping the same file share the host memory until a guest writes to
+     * it. The range must be page aligned and its pages untouched. Returns
+     * false if the pages can't be mapped, e.g. the RAM pages are smaller
+     * than the host ones.
+     */
+    bool mapFile(RV64Ptr address, size_t size, int fd, size_t offset);
 
 private:
     using PageId = RV64Size;
-    struct Page {
-        PageId const id;
-        char *const mem;
-    };
-
-    friend bool operator<(Page left, Page right) noexcept;
-    friend bool operator<(Page left, PageId right) noexcept;
-    friend bool operator<(PageId left, Page right) noexcept;
+    using PageTable = std::atomic<char *>[];
 
-    using Pagemap = std::set<Page, std::less<>>;
+    static constexpr size_t kPageTableSize = 512;
+    /// First touches closer than that are traced as a single span
+    static constexpr std::chrono::microseconds kTraceBurstGap{100};
 
     void validateAddressBounds(RV64Ptr address) const;
 
@@ -82,9 +146,11 @@ private:
     void validateAddressAlignment(RV64Ptr address) const;
 
     PageId getPageId(RV64Ptr address) const noexcept;
+    std::atomic<char *> *findPageEntry(PageId pageId) const noexcept;
     void const *getPageAddress(RV64Ptr address) const noexcept;
     void *touchPageAddress(RV64Ptr address);
     size_t getPageOffset(RV64Ptr address) const noexcept;
+    size_t getSpanSize(RV64Ptr address, size_t offset) const noexcept;
 
     template <typename DataType> DataType load(RV64Ptr address) const;
 
@@ -92,8 +158,13 @@ private:
 
     size_t ramSize_;
     size_t pageSize_;
-    RAMPageAllocator allocator_;
-    Pagemap pagemap_;
+    RAMPageAllocator allocator_; ///< guarded by allocationMutex_
+    std::unique_ptr<std::atomic<std::atomic<char *> *>[]> directory_;
+    std::vector<std::unique_ptr<PageTable>> pageTables_;
+    mutable std::mutex allocationMutex_;
+    std::vector<std::pair<char *, size_t>> fileMappings_;
+    std::atomic<size_t> pagesTouched_; ///< written under allocationMutex_
+    util::TraceBurst firstTouches_;    ///< guarded by allocationMutex_
 };
 
 template <typename DataType>
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "besm-666/riscv-types.hpp"
+#include "besm-666/util/elf-parser.hpp"
+#include "besm-666/util/non-copyable.hpp"
+
+namespace besm::mem {
+
+/**
+ * Read-only pages of a program image kept in a memfd. The machines loading
+ * the same image map them MAP_PRIVATE into their RAMs instead of copying
+ * the segments, so the host holds a single copy of text and rodata until a
+ * guest writes to its pages.
+ *
+ * A page is shared if it is covered by read-only segments only: the pages
+ * also holding writable data are loaded as usual.
+ */
+class SharedImage : INonCopyable {
+public:
+    using SPtr = std::shared_ptr<SharedImage>;
+
+    /// Guest pages [address, address + size) at offset in the memfd
+    struct Range {
+        RV64Ptr address;
+        size_t offset;
+        size_t size;
+    };
+
+    /**
+     * Returns the image of \p elf cut into \p pageSize pages, \p imageHash
+     * identifies the loaded bytes and the segment bounds are compared as
+     * well. It is built on the first request and reused while any machine
+     * holds it. Returns nullptr if there is nothing to
+     * share or the host has no memfd.
+     */
+    static SPtr Get(util::IElfParser &elf, uint64_t imageHash,
+                    size_t pageSize);
+
+    ~SharedImage();
+
+    int getFd() const noexcept { return fd_; }
+    std::vector<Range> const &getRanges() const noexcept { return ranges_; }
+
+private:
+    SharedImage(int fd, std::vector<Range> &&ranges)
+        : fd_(fd), ranges_(std::move(ranges)) {}
+
+    static SPtr Build(util::IElfParser &elf, size_t pageSize);
+
+    int fd_;
+    std::vector<Range> ranges_;
+};
+
+} // namespace besm::mem
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <sys/types.h>
+#include <thread>
+
+#include "besm-666/exec/csrs.hpp"
+#include "besm-666/memory/phys-mem-device.hpp"
+#include "besm-666/riscv-types.hpp"
+#include "besm-666/util/spsc-queue.hpp"
+
+namespace besm::mem {
+
+/**
+ * 16550-compatible UART with byte-wide registers.
+ *
+ * The guest never waits for the host: THR stores are pushed into a lock-free
+ * SPSC queue which a host writer thread drains to stdout in batched write(2)
+ * calls, so THR is always reported empty. RX bytes are read from the
+ * input (stdin or a file) by a host reader thread into another SPSC queue,
+ * LSR.DR reports whether it has data. The reader polls the input and leaves
+ * its file status flags alone, the descriptor may be shared.
+ *
+ * The writer thread is started on the first register access, so a machine
+ * may be forked before the guest touches its console. The reader is started
+ * then only for an input file, stdin is read once the guest enables the RX
+ * interrupt, so a guest which only prints never consumes the host stdin.
+ *
+ * There is no PLIC, so the UART interrupt drives MEIP of the connected hart
+ * directly.
+ *
+ * Register accesses of several harts are serialized, so the queues keep a
+ * single producer and a single consumer on the guest side.
+ */
+class UART final : public IPhysMemDevice {
+public:
+    using SPtr = std::shared_ptr<UART>;
+
+    static constexpr size_t kSize = 8;
+
+    /**
+     * \param inputPath file to feed RX from, stdin is used if empty
+     */
+    static SPtr Create(std::filesystem::path const &inputPath);
+    ~UART();
+
+    RV64UChar loadByte(RV64Ptr address) const override;
+    RV64UHWord loadHWord(RV64Ptr address) const override;
+    RV64UWord loadWord(RV64Ptr address) const override;
+    RV64UDWord loadDWord(RV64Ptr address) const override;
+
+    void storeByte(RV64Ptr address, RV64UChar value) override;
+    void storeHWord(RV64Ptr address, RV64UHWord value) override;
+    void storeWord(RV64Ptr address, RV64UWord value) override;
+    void storeDWord(RV64Ptr address, RV64UDWord value) override;
+
+    // Registers have no host memory behind them
+    std::pair<void const *, size_t>
+    getHostAddress(RV64Ptr address) const override;
+    std::pair<void *, size_t> touchHostAddress(RV64Ptr address) override;
+
+    size_t getSize() const noexcept override;
+
+    /**
+     * Routes the UART interrupt to \p mip, must be called before the first
+     * register access
+     */
+    void connectInterrupt(exec::MIP &mip) { mip_ = &mip; }
+
+    /**
+     * Must be called in a child forked after the host threads were started,
+     * they don't exist there: THR stores are written to stdout directly and
+     * the input is polled on register reads instead. The polled RX raises
+     * MEIP only when the guest accesses the UART.
+     */
+    void afterFork();
+
+private:
+    enum Register {
+        RBR_THR_DLL = 0,
+        IER_DLM = 1,
+        IIR_FCR = 2,
+        LCR = 3,
+        MCR = 4,
+        LSR = 5,
+        MSR = 6,
+        SCR = 7
+    };
+
+    static constexpr RV64UChar kLCRDivisorLatch = 0x80;
+    static constexpr RV64UChar kLSRDataReady = 0x01;
+    static constexpr RV64UChar kLSRTxEmpty = 0x60; // THRE | TEMT
+    static constexpr RV64UChar kMSRConnected = 0xB0; // DCD | DSR | CTS
+    static constexpr RV64UChar kIERRxAvailable = 0x01;
+    static constexpr RV64UChar kIERTxEmpty = 0x02;
+    static constexpr RV64UChar kFCREnable = 0x01;
+
+    static constexpr size_t kQueueSize = 64 * 1024;
+    static constexpr size_t kBatchSize = 4096;
+    static constexpr std::chrono::milliseconds kIdleTimeout{10};
+
+    explicit UART(std::filesystem::path const &inputPath);
+
+    void start();
+    void startReader();
+    void writerLoop();
+    void readerLoop();
+    /**
+     * Drops the handles of the threads in a forked child: detaching a
+     * thread that doesn't exist in the process is undefined
+     */
+    void releaseThreads();
+
+    void transmit(char c);
+    bool dataReady();
+    void pollInput();
+
+    RV64UChar readRegister(RV64Ptr address);
+    void writeRegister(RV64Ptr address, RV64UChar value);
+    void updateInterrupt();
+
+    int inputFd_;
+    bool ownsInput_;
+
+    std::atomic<RV64UChar> ier_; ///< read by the reader thread
+    RV64UChar fcr_;
+    RV64UChar lcr_;
+    RV64UChar mcr_;
+    RV64UChar scr_;
+    RV64UChar dll_;
+    RV64UChar dlm_;
+
+    char rbr_;
+    bool rbrValid_;
+
+    exec::MIP *mip_;
+
+    util::SPSCQueue<char, kQueueSize> tx_;
+    util::SPSCQueue<char, kQueueSize> rx_;
+
+    bool started_;
+    pid_t startedPid_;
+    bool direct_;   ///< no host threads, see afterFork()
+    bool rxPolled_; ///< the input is read by pollInput()
+    std::thread writer_;
+    std::thread reader_;
+    std::atomic<bool> stop_;
+    std::atomic<bool> writerIdle_;
+    std::mutex mutex_;
+    std::mutex guestMutex_;
+    std::condition_variable wakeUp_;
+};
+
+} // namespace besm::mem
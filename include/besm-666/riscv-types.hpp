@@ -50,4 +50,10 @@ enum ExceptionId {
     EXCEPTION_STORE_PAGEFAULT = 15,
 };
 
+enum InterruptId {
+    INTERRUPT_MSOFTWARE = 3,
+    INTERRUPT_MTIMER = 7,
+    INTERRUPT_MEXTERNAL = 11,
+};
+
 } // namespace besm
@@ -71,6 +71,30 @@ enum InstructionOp {
     CSRRCI, // 1110011 , 111     , I
     SRET,
     MRET,
+    WFI,
+    // RV64A:
+    LR_W,
+    SC_W,
+    AMOSWAP_W,
+    AMOADD_W,
+    AMOXOR_W,
+    AMOAND_W,
+    AMOOR_W,
+    AMOMIN_W,
+    AMOMAX_W,
+    AMOMINU_W,
+    AMOMAXU_W,
+    LR_D,
+    SC_D,
+    AMOSWAP_D,
+    AMOADD_D,
+    AMOXOR_D,
+    AMOAND_D,
+    AMOOR_D,
+    AMOMIN_D,
+    AMOMAX_D,
+    AMOMINU_D,
+    AMOMAXU_D,
     BB_END // keep it last instruction
 };
 
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "besm-666/memory/ram.hpp"
+#include "besm-666/riscv-types.hpp"
+#include "besm-666/sim/config.hpp"
+#include "besm-666/util/non-copyable.hpp"
+#include "besm-666/util/range.hpp"
+
+namespace besm::sim {
+
+class Machine;
+
+/**
+ * Runs many independent programs in one process: the jobs are taken by a
+ * pool of host threads, each job gets its own Machine. The machines share a
+ * RAMChunkPool, so a job reuses the warm RAM chunks of the finished ones
+ * instead of mapping and faulting in fresh memory.
+ */
+class BatchRunner : INonCopyable {
+public:
+    /**
+     * A manifest line, options override the base configuration:
+     *
+     *   path/to/elf [ram=ADDRESS,SIZE]... [ram-page-size=N]
+     *               [ram-chunk-size=N] [max-instrs=N] [timeout=SECONDS]
+     *               [user-mode] [-- GUEST ARGS...]
+     *
+     * Empty lines and lines starting with '#' are skipped.
+     */
+    struct Job {
+        std::filesystem::path executablePath;
+        std::vector<std::string> guestArgs;
+        std::vector<util::Range<RV64Ptr>> ramRanges; ///< base ones if empty
+        std::optional<size_t> ramPageSize;
+        std::optional<size_t> ramChunkSize;
+        std::optional<size_t> maxInstrs;
+        std::optional<std::chrono::duration<double>> timeout;
+        bool userMode = false;
+    };
+
+    enum Status {
+        STATUS_EXITED,  ///< the guest has reported an exit code
+        STATUS_STOPPED, ///< the hart has stopped without an exit code
+        STATUS_BUDGET,  ///< max-instrs has run out
+        STATUS_TIMEOUT, ///< the host time limit has run out
+        STATUS_ERROR    ///< invalid configuration or simulator exception
+    };
+
+    struct Result {
+        Status status = STATUS_ERROR;
+        std::optional<int> exitCode;
+        size_t instrsExecuted = 0;
+        std::chrono::duration<double> runTime{0}; ///< without loading
+        std::string error;
+    };
+
+    /// Throws InvalidConfiguration naming the line of an invalid job
+    static std::vector<Job> ParseManifest(std::istream &manifest);
+
+    /// Writes a JSON array with an object per job, in the manifest order
+    static void WriteResults(std::ostream &output, std::vector<Job> const &jobs,
+                             std::vector<Result> const &results);
+
+    /**
+     * \param base options the jobs share, such as devices. Throws
+     * InvalidConfiguration if they are invalid or have several harts.
+     */
+    BatchRunner(ConfigBuilder const &base, size_t numThreads);
+
+    std::vector<Result> run(std::vector<Job> const &jobs);
+
+    mem::RAMChunkPool const &getRAMChunkPool() const { return *ramChunkPool_; }
+
+private:
+    static constexpr std::chrono::milliseconds kWatchdogPeriod{10};
+
+    /// A job in progress, watched for its timeout
+    struct Slot {
+        std::mutex mutex;
+        Machine *machine = nullptr;
+        std::chrono::steady_clock::time_point deadline;
+        bool timedOut = false;
+    };
+
+    Config makeConfig(Job const &job) const;
+    Result runJob(Job const &job, Slot &slot);
+    void watchdogLoop();
+
+    ConfigBuilder base_;
+    size_t numThreads_;
+    mem::RAMChunkPool::SPtr ramChunkPool_;
+
+    std::unique_ptr<Slot[]> slots_; ///< a slot per thread
+    std::atomic<bool> finished_;
+};
+
+} // namespace besm::sim
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <set>
+#include <vector>
+
+#include "besm-666/exec/basic-block.hpp"
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/block-profiler.hpp"
+#include "besm-666/util/non-copyable.hpp"
+
+namespace besm::sim {
+
+class Hart;
+
+/**
+ * Collects SimPoint basic block vectors of a hart and writes them in the
+ * .bb format, a line per interval:
+ *
+ *   T:<block id>:<instructions> :<block id>:<instructions> ...
+ *
+ * The hart reports each fetched block, the instructions retired since the
+ * previous fetch are added to the previous block in an array indexed by
+ * exec::BasicBlock::getId(). Nothing is done per instruction. An interval
+ * ends at the first block boundary after a multiple of the interval size.
+ *
+ * Optionally the state of the hart and RAM is dumped at the start of the
+ * intervals chosen by SimPoint, see setSimPoints().
+ */
+class BBVProfiler : public IBlockProfiler, INonCopyable {
+public:
+    BBVProfiler(std::ostream &output, size_t intervalSize);
+
+    /**
+     * Dumps the state at the start of each of \p intervals into
+     * \p dumpDir / <interval>: text file "regs" with the registers and
+     * "ram-<address>.bin" files with the touched RAM pages.
+     */
+    void setSimPoints(std::set<size_t> intervals,
+                      std::filesystem::path dumpDir,
+                      std::shared_ptr<mem::PhysMem const> pMem);
+
+    /// Reads the interval numbers from a SimPoint .simpts file
+    static std::set<size_t> ReadSimPoints(std::istream &simPoints);
+
+    static void DumpState(std::filesystem::path const &dir, Hart const &hart,
+                          mem::PhysMem const &pMem);
+
+    void onBlockFetch(Hart const &hart, exec::BasicBlock const &bb) override;
+
+    /// Writes the last, incomplete interval
+    void finish(Hart const &hart) override;
+
+    size_t getIntervalsNum() const noexcept { return interval_; }
+
+private:
+    void account(size_t instrsExecuted);
+    void startInterval(Hart const &hart);
+    void writeInterval();
+
+    std::ostream &output_;
+    size_t intervalSize_;
+    size_t intervalEnd_;
+    size_t interval_;
+    bool started_;
+
+    std::vector<uint64_t> counts_; ///< indexed by block id
+    std::vector<size_t> touched_;  ///< ids with non-zero counts
+    size_t lastId_;
+    size_t lastInstrs_;
+
+    std::set<size_t> simPoints_;
+    std::filesystem::path dumpDir_;
+    std::shared_ptr<mem::PhysMem const> pMem_;
+};
+
+} // namespace besm::sim
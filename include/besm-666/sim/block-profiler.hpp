@@ -0,0 +1,26 @@
+#pragma once
+
+#include "besm-666/exec/basic-block.hpp"
+
+namespace besm::sim {
+
+class Hart;
+
+/**
+ * Observer of the basic blocks fetched by a hart, see
+ * Hart::attachProfiler(). Profilers are called at block boundaries only,
+ * never per instruction: the instructions retired since the previous call
+ * have been executed in the previously fetched block.
+ */
+class IBlockProfiler {
+public:
+    virtual ~IBlockProfiler() = default;
+
+    virtual void onBlockFetch(Hart const &hart,
+                              exec::BasicBlock const &bb) = 0;
+
+    /// Accounts the last block once the hart has stopped
+    virtual void finish(Hart const &hart) = 0;
+};
+
+} // namespace besm::sim
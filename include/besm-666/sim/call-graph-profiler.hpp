@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "besm-666/exec/basic-block.hpp"
+#include "besm-666/riscv-types.hpp"
+#include "besm-666/sim/block-profiler.hpp"
+#include "besm-666/util/non-copyable.hpp"
+#include "besm-666/util/symtab.hpp"
+
+namespace besm::sim {
+
+/**
+ * Instructions of a hart by guest call path, kept with a shadow call stack.
+ *
+ * The stack is updated at block boundaries by the instruction ending the
+ * previous block: JAL and JALR with rd == ra push the callee, JALR with
+ * rd == zero and rs1 == ra returns to the innermost frame expecting the
+ * target address, so a longjmp or an unwinder popping several frames at
+ * once is followed. Returns matching no frame are ignored. Calls beyond
+ * the maximum depth are not pushed and are counted in the deepest frame.
+ * Trap handlers are counted in the interrupted path.
+ */
+class CallGraphProfiler : public IBlockProfiler, INonCopyable {
+public:
+    static constexpr size_t kDefaultMaxDepth = 256;
+
+    /**
+     * Exclusive instructions by call path, a path holds the entry addresses
+     * of its frames from the outermost one
+     */
+    using Counts = std::map<std::vector<RV64Ptr>, uint64_t>;
+
+    struct Entry {
+        std::string stack; ///< symbolized frames separated by ';'
+        uint64_t self;     ///< exclusive instructions
+        uint64_t total;    ///< inclusive instructions
+    };
+
+    /**
+     * Names the frames by the covering functions of \p symtab, or by the
+     * address, the path with the most inclusive instructions first
+     */
+    static std::vector<Entry> Symbolize(util::Symtab const &symtab,
+                                        Counts const &counts);
+
+    /// The first \p topN paths with their inclusive and exclusive ratios
+    static void Print(std::ostream &output, std::vector<Entry> const &profile,
+                      size_t topN);
+
+    /**
+     * A "<frame>;<frame>;... <exclusive instructions>" line per path, the
+     * folded stacks format of flamegraph.pl
+     */
+    static void WriteFolded(std::ostream &output,
+                            std::vector<Entry> const &profile);
+
+    /// \throws std::invalid_argument if \p maxDepth is 0
+    explicit CallGraphProfiler(size_t maxDepth = kDefaultMaxDepth);
+
+    void onBlockFetch(Hart const &hart, exec::BasicBlock const &bb) override;
+    void finish(Hart const &hart) override;
+
+    /// Adds the exclusive instructions of the executed paths to \p counts
+    void addCounts(Counts &counts) const;
+
+    size_t getDepth() const noexcept { return stack_.size(); }
+
+private:
+    static constexpr RV64Ptr kNoReturn = ~RV64Ptr(0);
+
+    /// A node of the call tree, the path is found through the parents
+    struct Node {
+        RV64Ptr entry;
+        size_t parent;
+        uint64_t self;
+    };
+
+    struct Frame {
+        size_t node;
+        RV64Ptr returnAddress;
+    };
+
+    void account(size_t instrsExecuted);
+    void call(RV64Ptr entry, RV64Ptr returnAddress);
+    void ret(RV64Ptr target);
+
+    size_t maxDepth_;
+    std::vector<Node> nodes_;
+    std::map<std::pair<size_t, RV64Ptr>, size_t> children_;
+    std::vector<Frame> stack_;
+    size_t truncated_; ///< calls not pushed beyond the maximum depth
+
+    exec::BasicBlock const *last_;
+    size_t lastInstrs_;
+    bool lastCompleted_; ///< the previous block ran up to its end
+};
+
+} // namespace besm::sim
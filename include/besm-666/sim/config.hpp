@@ -1,9 +1,12 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <functional>
+#include <optional>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 #include "besm-666/riscv-types.hpp"
@@ -14,11 +17,32 @@ namespace besm::sim {
 struct ConfigData {
     // Input files
     std::filesystem::path executablePath;
+    std::vector<std::string> guestArgs;
+
+    // Personality
+    bool userMode = false;
+
+    bool verbose = true; ///< report the machine setup to std::clog
+
+    // Harts
+    size_t numHarts = 1;
+    std::vector<int> hartAffinity; ///< host CPU per hart, not pinned if empty
+    size_t hostThreads = 0; ///< a host thread per hart if 0
+    size_t hartQuantum = 50'000;
+    bool deterministic = false;
+    uint64_t schedulerSeed = 0; ///< hart id order if 0
+    bool sharedCodeCache = false; ///< share decoded blocks, see Machine
 
     // Memory
     std::vector<util::Range<RV64Ptr>> ramRanges;
     size_t ramPageSize;
     size_t ramChunkSize;
+
+    // Devices
+    std::optional<RV64Ptr> uartAddress;
+    std::filesystem::path uartInputPath; ///< stdin if empty
+    std::optional<RV64Ptr> timerAddress;
+    RV64UDWord timerFrequency = 10'000'000;
 };
 
 class InvalidConfiguration : public std::runtime_error {
@@ -33,9 +57,23 @@ public:
     Config();
 
     std::filesystem::path executablePath() const;
+    std::vector<std::string> const &guestArgs() const;
+    bool userMode() const;
+    bool verbose() const;
+    size_t numHarts() const;
+    std::vector<int> const &hartAffinity() const;
+    size_t hostThreads() const;
+    size_t hartQuantum() const;
+    bool deterministic() const;
+    uint64_t schedulerSeed() const;
+    bool sharedCodeCache() const;
     std::vector<util::Range<RV64Ptr>> const &ramRanges() const;
     size_t ramPageSize() const;
     size_t ramChunkSize() const;
+    std::optional<RV64Ptr> uartAddress() const;
+    std::filesystem::path uartInputPath() const;
+    std::optional<RV64Ptr> timerAddress() const;
+    RV64UDWord timerFrequency() const;
 
 private:
     friend class ConfigBuilder;
@@ -49,9 +87,24 @@ public:
     ConfigBuilder() = default;
 
     void setExecutablePath(std::filesystem::path executablePath);
+    void addGuestArg(std::string arg);
+    void setUserMode(bool userMode);
+    void setVerbose(bool verbose);
+    void setNumHarts(size_t numHarts);
+    void addHartAffinity(int cpu);
+    void setHostThreads(size_t hostThreads);
+    void setHartQuantum(size_t quantum);
+    void setDeterministic(bool deterministic);
+    void setSchedulerSeed(uint64_t seed);
+    void setSharedCodeCache(bool sharedCodeCache);
     void addRamRange(util::Range<RV64Ptr> range);
+    void clearRamRanges();
     void setRamPageSize(size_t pageSize);
     void setRamChunkSize(size_t chunkSize);
+    void setUartAddress(RV64Ptr address);
+    void setUartInputPath(std::filesystem::path path);
+    void setTimerAddress(RV64Ptr address);
+    void setTimerFrequency(RV64UDWord frequency);
 
     Config build();
 
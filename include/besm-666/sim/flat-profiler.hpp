@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "besm-666/exec/basic-block.hpp"
+#include "besm-666/riscv-types.hpp"
+#include "besm-666/sim/block-profiler.hpp"
+#include "besm-666/util/non-copyable.hpp"
+#include "besm-666/util/symtab.hpp"
+
+namespace besm::sim {
+
+/**
+ * Flat profile of the guest functions executed by a hart.
+ *
+ * Like BBVProfiler, the instructions retired since the previous fetch are
+ * added to the previous block in an array indexed by
+ * exec::BasicBlock::getId(). Blocks are attributed to the functions by
+ * their start address once the run is over, see Symbolize().
+ */
+class FlatProfiler : public IBlockProfiler, INonCopyable {
+public:
+    /// Instructions by block address
+    using Counts = std::unordered_map<RV64Ptr, uint64_t>;
+
+    struct Entry {
+        std::string name; ///< "[unknown]" for code not covered by symbols
+        RV64Ptr address;  ///< 0 for unknown code
+        uint64_t instrs;
+    };
+
+    /**
+     * Sums \p counts by the covering functions of \p symtab, the most
+     * executed function first
+     */
+    static std::vector<Entry> Symbolize(util::Symtab const &symtab,
+                                        Counts const &counts);
+
+    /// The first \p topN functions with their self and cumulative ratios
+    static void Print(std::ostream &output, std::vector<Entry> const &profile,
+                      size_t topN);
+
+    /**
+     * A "<function> <instructions>" line per function, the folded stacks
+     * format of flamegraph.pl
+     */
+    static void WriteFolded(std::ostream &output,
+                            std::vector<Entry> const &profile);
+
+    FlatProfiler();
+
+    void onBlockFetch(Hart const &hart, exec::BasicBlock const &bb) override;
+    void finish(Hart const &hart) override;
+
+    /// Adds the instructions of the executed blocks to \p counts
+    void addCounts(Counts &counts) const;
+
+private:
+    void account(size_t instrsExecuted);
+
+    std::vector<uint64_t> instrs_; ///< indexed by block id
+    std::vector<RV64Ptr> pcs_;     ///< indexed by block id
+    size_t lastId_;
+    size_t lastInstrs_;
+};
+
+} // namespace besm::sim
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/util/non-copyable.hpp"
+
+namespace besm::sim {
+
+/**
+ * Runs the harts of a machine on host threads.
+ */
+class IHartScheduler : INonCopyable {
+public:
+    virtual ~IHartScheduler() = default;
+
+    /**
+     * Runs the harts until each of them is about to fetch a basic block at
+     * \p stopPC, see Hart::runUntil(). Once a hart stops elsewhere, the
+     * others are stopped.
+     */
+    virtual void runUntil(RV64Ptr stopPC) = 0;
+
+    /// Host time the hart has spent running
+    virtual std::chrono::duration<double> getRunTime(size_t hartId) const = 0;
+};
+
+/**
+ * Multiplexes many harts onto a fixed pool of host threads.
+ *
+ * Each worker owns a deque of runnable harts: it resumes the hart at the
+ * front for a quantum of instructions (see Hart::runSlice()) and pushes it
+ * back once the quantum is over. A worker with an empty deque steals from
+ * the back of the others. A hart stays the same object when it migrates,
+ * so its basic block cache stays warm.
+ *
+ * A hart which has executed WFI is parked off the deques until
+ * Hart::wakeUpPending(). Parked harts are polled by the workers between
+ * slices and by idle workers. A hart which has executed PAUSE just yields
+ * the rest of its quantum.
+ */
+class WorkStealingScheduler final : public IHartScheduler {
+public:
+    WorkStealingScheduler(std::vector<Hart::SPtr> harts, size_t numWorkers,
+                          size_t quantum);
+
+    /// The calling thread is one of the workers
+    void runUntil(RV64Ptr stopPC) override;
+
+    std::chrono::duration<double> getRunTime(size_t hartId) const override;
+
+private:
+    static constexpr std::chrono::milliseconds kIdleTimeout{1};
+
+    struct Task {
+        Hart *hart;
+        size_t hartId;
+    };
+
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t workerId, RV64Ptr stopPC);
+    void runTask(size_t workerId, Task task, RV64Ptr stopPC);
+
+    void push(size_t workerId, Task task);
+    bool pop(size_t workerId, Task &task);
+    bool steal(size_t workerId, Task &task);
+
+    void park(Task task);
+    void wakeUpParked(size_t workerId);
+
+    void finish();
+    void stopAll();
+
+    std::vector<Hart::SPtr> harts_;
+    std::vector<std::chrono::duration<double>> runTimes_;
+    size_t quantum_;
+
+    std::unique_ptr<Worker[]> workers_;
+    size_t numWorkers_;
+
+    std::mutex parkedMutex_;
+    std::vector<Task> parked_;
+    std::atomic<size_t> parkedNum_;
+
+    std::atomic<size_t> runningNum_; ///< harts which haven't stopped yet
+    std::mutex idleMutex_;
+    std::condition_variable wakeUp_;
+
+    std::mutex errorMutex_;
+    std::exception_ptr error_;
+};
+
+} // namespace besm::sim
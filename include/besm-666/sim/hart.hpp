@@ -4,40 +4,166 @@
 #include "besm-666/exec/basic-block.hpp"
 #include "besm-666/exec/csrf.hpp"
 #include "besm-666/exec/gprf.hpp"
+#include "besm-666/memory/clint.hpp"
+#include "besm-666/memory/htif.hpp"
 #include "besm-666/memory/mmu.hpp"
 #include "besm-666/memory/phys-mem.hpp"
 #include "besm-666/memory/prefetcher.hpp"
+#include "besm-666/sim/block-profiler.hpp"
+#include "besm-666/sim/stats.hpp"
 #include "besm-666/util/assotiative-cache.hpp"
+#include "besm-666/util/tracer.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <vector>
 
 namespace besm::sim {
 
 class HookManager;
+class SyscallEmulator;
 
 class Hart : public INonCopyable {
 public:
     using SPtr = std::shared_ptr<Hart>;
     using Handler = void (*)(Hart &);
 
+    // Unaligned, so it can't be met on runtime as a basic block address
+    static constexpr RV64Ptr kNoStopPC = 1;
+
+    /**
+     * Harts of a machine share \p pMem, while MMU and prefetcher are private
+     * to each hart. The hart decodes into a private block store unless
+     * attachCodeCache() is called.
+     */
     static SPtr Create(std::shared_ptr<mem::PhysMem> const &pMem,
-                       std::shared_ptr<HookManager> const &hookManager);
+                       std::shared_ptr<HookManager> const &hookManager,
+                       size_t hartId = 0);
 
     exec::GPRF const &getGPRF() const { return gprf_; }
     exec::CSRF const &getCSRF() const { return csrf_; }
     mem::MMU const &getMMU() const { return *mmu_; }
-    size_t getInstrsExecuted() const { return instrsExecuted_; }
+    size_t getInstrsExecuted() const {
+        return instrsExecuted_.load(std::memory_order_relaxed);
+    }
+
+    Stats const &getStats() const { return *stats_; }
+
+    /**
+     * Address of the last fetched basic block with the privilege level in
+     * the two low bits. It is published with a relaxed store per block
+     * fetch, so samplers may read it from any thread or signal handler.
+     */
+    std::atomic<uint64_t> const &getBlockWord() const { return blockWord_; }
+    static RV64Ptr GetBlockWordPC(uint64_t word) { return word & ~3ULL; }
+    static RV64UDWord GetBlockWordPrivilege(uint64_t word) { return word & 3; }
 
     bool finished() const;
 
     void run();
 
+    /**
+     * Runs the hart until it is about to fetch a basic block at \p stopPC.
+     * The check is performed at basic block boundaries only, so \p stopPC
+     * should be a block entry (a jump target or a trap vector), otherwise
+     * the hart runs until the program end.
+     */
+    void runUntil(RV64Ptr stopPC);
+
+    /// Why runSlice() has returned
+    enum YieldReason {
+        YIELD_NONE,    ///< the hart has stopped as runUntil() does
+        YIELD_QUANTUM, ///< the quantum is over
+        YIELD_PAUSE,   ///< the guest spins, it has executed PAUSE
+        YIELD_WFI      ///< the guest waits for an interrupt
+    };
+
+    /**
+     * Runs the hart as runUntil() does, but returns at the first basic block
+     * boundary after \p quantum instructions, or at the next one after the
+     * guest executes PAUSE or WFI. The hart may be resumed with another
+     * runSlice() on any host thread, it keeps its decoded blocks and TLB.
+     */
+    YieldReason runSlice(RV64Ptr stopPC, size_t quantum);
+
+    /**
+     * A hart which has yielded with YIELD_WFI may be resumed once an enabled
+     * interrupt is pending or a stop is requested. Must not be called while
+     * the hart runs.
+     */
+    bool wakeUpPending() const;
+
+    /**
+     * Asks the hart to return from run() at the next basic block boundary,
+     * may be called from any thread. The request is sticky: the hart
+     * returns from all the later runs immediately.
+     */
+    void requestStop();
+
+    /**
+     * Pending interrupts word, devices raise and clear MSIP, MTIP and MEIP
+     * in it from any host thread.
+     *
+     * The word is tested with a single relaxed load in exec_BB_END and never
+     * per instruction, so an interrupt is taken before the first basic block
+     * fetched after it becomes visible to the hart. A block holds at most
+     * BasicBlock::kCapacity - 1 = 7 instructions, which bounds the worst-case
+     * latency by 7 instructions. The same bound applies to enabling
+     * interrupts with CSR writes in the middle of a block.
+     */
+    exec::MIP &getInterruptsPending() { return csrf_.mip; }
+
+    /**
+     * Switches the hart to the user-mode Linux personality: the process is
+     * set up by the emulator and U-mode ECALLs are served by it.
+     */
+    void attachSyscallEmulator(std::shared_ptr<SyscallEmulator> emulator);
+
+    /**
+     * Makes the hart serve HTIF commands. Pending tohost is checked at basic
+     * block boundaries only, the hart stops once the guest requests to exit.
+     */
+    void attachHTIF(mem::HTIF::SPtr htif);
+
+    /**
+     * Binds the hart clock to CLINT. The timer deadline is compared with the
+     * executed instructions counter at basic block boundaries only.
+     */
+    void attachCLINT(mem::CLINT::SPtr clint);
+
+    /**
+     * Makes the hart take decoded blocks from \p codeCache and publish the
+     * ones it decodes there. \p codeHash identifies the code image: harts
+     * with the same hash must see the same instructions at the same PCs,
+     * blocks are never invalidated.
+     */
+    void attachCodeCache(exec::SharedBasicBlockCache::SPtr codeCache,
+                         uint64_t codeHash);
+
+    /**
+     * Reports every fetched basic block to \p profiler, which must outlive
+     * the runs or be detached. The profilers are called in the attachment
+     * order.
+     */
+    void attachProfiler(IBlockProfiler *profiler);
+    void detachProfiler(IBlockProfiler *profiler);
+
+    /**
+     * Registers the hart statistics in \p stats, the hart writes the shard
+     * of its id. Until then they are kept in a private registry.
+     */
+    void attachStats(Stats::SPtr stats);
+
 private:
     exec::BasicBlockCache bbCache_;
+    exec::SharedBasicBlockCache::SPtr codeCache_;
+    uint64_t codeHash_;
     Instruction const *currentInstr_;
 
     dec::Decoder dec_;
 
+    std::shared_ptr<mem::PhysMem> pMem_;
     mem::MMU::SPtr mmu_;
     mem::Prefetcher prefetcher_;
 
@@ -45,17 +171,69 @@ private:
     exec::CSRF csrf_;
 
     std::shared_ptr<sim::HookManager> hookManager_;
+    std::vector<IBlockProfiler *> profilers_;
+    std::shared_ptr<SyscallEmulator> syscalls_;
+    mem::HTIF::SPtr htif_;
+    mem::CLINT::SPtr clint_;
+    std::atomic<RV64UDWord> const *timerDeadline_;
+
+    /**
+     * LR/SC reservation, private to the hart. SC succeeds if the reserved
+     * location still holds the value loaded by LR, which is checked with a
+     * host compare-and-swap, so harts share no reservation state and take
+     * no locks. As with any value-based scheme, SC may succeed after the
+     * location has been changed and changed back.
+     */
+    struct Reservation {
+        RV64Ptr address;
+        RV64UDWord value;
+        size_t size; ///< 0 if there is no reservation
+    };
+    Reservation reservation_;
+
+    /// Written by the hart only, read by CLINT and the stats exporter
+    std::atomic<size_t> instrsExecuted_;
 
-    size_t instrsExecuted_;
+    /// Counted per basic block fetch or trap, never per instruction
+    struct StatsSlots {
+        Stats::Counter *bbCacheLookups;
+        Stats::Counter *bbCacheMisses;
+        Stats::Counter *blocksDecoded;
+        Stats::Counter *fetchTranslations;
+        Stats::Counter *exceptions;
+        Stats::Counter *interrupts;
+        Stats::Histogram *blockLength;
+    };
+    Stats::SPtr stats_;
+    size_t statsShard_;
+    StatsSlots statsSlots_;
+    size_t blockStart_; ///< instrsExecuted_ at the last basic block fetch
+    std::atomic<uint64_t> blockWord_; ///< see getBlockWord()
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                  "Block word is read from signal handlers");
 
-    explicit Hart(std::shared_ptr<mem::PhysMem> const &pMem,
-                  std::shared_ptr<HookManager> hookManager);
+    /// Decodes closer than that are traced as a single span
+    static constexpr std::chrono::microseconds kTraceBurstGap{100};
+    util::TraceBurst decodeBursts_;
+    RV64Ptr stopPC_;
+    std::atomic<bool> stopRequested_;
+
+    static constexpr size_t kNoSliceEnd = ~static_cast<size_t>(0);
+    size_t sliceEnd_; ///< kNoSliceEnd unless the hart runs a slice
+    YieldReason yieldReason_;
+
+    Hart(std::shared_ptr<mem::PhysMem> const &pMem,
+         std::shared_ptr<HookManager> hookManager, size_t hartId);
 
     void assembleBB(exec::BasicBlock &bb, RV64Ptr pc);
+    exec::BasicBlock const *findBB(RV64Ptr pc);
+    void registerStats();
     void fetchBB();
     inline static void execNextInstr(Hart &hart);
 
+    void enterTrap(RV64UDWord cause, bool interrupt);
     void raiseException(ExceptionId id);
+    void takeInterrupt();
     void raiseIllegalInstruction();
 
     static void exec_BB_END(Hart &hart);
@@ -107,9 +285,11 @@ private:
     static void exec_FENCE_TSO(Hart &hart);
 
     /**
-     * @todo #81:90min to be implemented
+     * PAUSE and WFI are NOPs unless the hart runs a slice, then they end the
+     * slice at the next basic block boundary.
      */
     static void exec_PAUSE(Hart &hart);
+    static void exec_WFI(Hart &hart);
 
     // Will be implemented after CSR system release
     static void exec_ECALL(Hart &hart);
@@ -136,6 +316,44 @@ private:
     static void exec_CSRRSI(Hart &hart);
     static void exec_CSRRCI(Hart &hart);
 
+    /**
+     * AMOs are performed with host atomic instructions on the host memory
+     * backing the guest address, so they are atomic with respect to the
+     * other harts. Device registers have no host memory, there the AMO is a
+     * plain read-modify-write serialized by the device.
+     *
+     * The aq and rl bits are ignored: every AMO, LR and SC is sequentially
+     * consistent.
+     */
+    static void exec_LR_W(Hart &hart);
+    static void exec_SC_W(Hart &hart);
+    static void exec_AMOSWAP_W(Hart &hart);
+    static void exec_AMOADD_W(Hart &hart);
+    static void exec_AMOXOR_W(Hart &hart);
+    static void exec_AMOAND_W(Hart &hart);
+    static void exec_AMOOR_W(Hart &hart);
+    static void exec_AMOMIN_W(Hart &hart);
+    static void exec_AMOMAX_W(Hart &hart);
+    static void exec_AMOMINU_W(Hart &hart);
+    static void exec_AMOMAXU_W(Hart &hart);
+    static void exec_LR_D(Hart &hart);
+    static void exec_SC_D(Hart &hart);
+    static void exec_AMOSWAP_D(Hart &hart);
+    static void exec_AMOADD_D(Hart &hart);
+    static void exec_AMOXOR_D(Hart &hart);
+    static void exec_AMOAND_D(Hart &hart);
+    static void exec_AMOOR_D(Hart &hart);
+    static void exec_AMOMIN_D(Hart &hart);
+    static void exec_AMOMAX_D(Hart &hart);
+    static void exec_AMOMINU_D(Hart &hart);
+    static void exec_AMOMAXU_D(Hart &hart);
+
+    template <typename DataType> static void execLR(Hart &hart);
+    template <typename DataType> static void execSC(Hart &hart);
+    template <typename DataType, typename Operation>
+    static void execAMO(Hart &hart);
+    static void raiseMisaligned(Hart &hart, ExceptionId id);
+
     void nextPC();
 
 public:
@@ -145,28 +363,35 @@ public:
      * array to keep them consistent (handler index is enum value of operation)
      */
     static constexpr Handler HANDLER_ARR[] = {
-        &Hart::exec_INV_OP,    &Hart::exec_LUI,    &Hart::exec_AUIPC,
-        &Hart::exec_JAL,       &Hart::exec_JALR,   &Hart::exec_BEQ,
-        &Hart::exec_BNE,       &Hart::exec_BLT,    &Hart::exec_BGE,
-        &Hart::exec_BLTU,      &Hart::exec_BGEU,   &Hart::exec_LB,
-        &Hart::exec_LH,        &Hart::exec_LW,     &Hart::exec_LBU,
-        &Hart::exec_LHU,       &Hart::exec_SB,     &Hart::exec_SH,
-        &Hart::exec_SW,        &Hart::exec_ADDI,   &Hart::exec_SLTI,
-        &Hart::exec_SLTIU,     &Hart::exec_XORI,   &Hart::exec_ORI,
-        &Hart::exec_ANDI,      &Hart::exec_ADD,    &Hart::exec_SUB,
-        &Hart::exec_SLL,       &Hart::exec_SLT,    &Hart::exec_SLTU,
-        &Hart::exec_XOR,       &Hart::exec_SRL,    &Hart::exec_SRA,
-        &Hart::exec_OR,        &Hart::exec_AND,    &Hart::exec_FENCE,
-        &Hart::exec_FENCE_TSO, &Hart::exec_PAUSE,  &Hart::exec_ECALL,
-        &Hart::exec_EBREAK,    &Hart::exec_LWU,    &Hart::exec_LD,
-        &Hart::exec_SD,        &Hart::exec_SLLI,   &Hart::exec_SRLI,
-        &Hart::exec_SRAI,      &Hart::exec_ADDIW,  &Hart::exec_SLLIW,
-        &Hart::exec_SRLIW,     &Hart::exec_SRAIW,  &Hart::exec_ADDW,
-        &Hart::exec_SUBW,      &Hart::exec_SLLW,   &Hart::exec_SRLW,
-        &Hart::exec_SRAW,      &Hart::exec_CSRRW,  &Hart::exec_CSRRS,
-        &Hart::exec_CSRRC,     &Hart::exec_CSRRWI, &Hart::exec_CSRRSI,
-        &Hart::exec_CSRRCI,    &Hart::exec_SRET,   &Hart::exec_MRET,
-        &Hart::exec_BB_END};
+        &Hart::exec_INV_OP,    &Hart::exec_LUI,       &Hart::exec_AUIPC,
+        &Hart::exec_JAL,       &Hart::exec_JALR,      &Hart::exec_BEQ,
+        &Hart::exec_BNE,       &Hart::exec_BLT,       &Hart::exec_BGE,
+        &Hart::exec_BLTU,      &Hart::exec_BGEU,      &Hart::exec_LB,
+        &Hart::exec_LH,        &Hart::exec_LW,        &Hart::exec_LBU,
+        &Hart::exec_LHU,       &Hart::exec_SB,        &Hart::exec_SH,
+        &Hart::exec_SW,        &Hart::exec_ADDI,      &Hart::exec_SLTI,
+        &Hart::exec_SLTIU,     &Hart::exec_XORI,      &Hart::exec_ORI,
+        &Hart::exec_ANDI,      &Hart::exec_ADD,       &Hart::exec_SUB,
+        &Hart::exec_SLL,       &Hart::exec_SLT,       &Hart::exec_SLTU,
+        &Hart::exec_XOR,       &Hart::exec_SRL,       &Hart::exec_SRA,
+        &Hart::exec_OR,        &Hart::exec_AND,       &Hart::exec_FENCE,
+        &Hart::exec_FENCE_TSO, &Hart::exec_PAUSE,     &Hart::exec_ECALL,
+        &Hart::exec_EBREAK,    &Hart::exec_LWU,       &Hart::exec_LD,
+        &Hart::exec_SD,        &Hart::exec_SLLI,      &Hart::exec_SRLI,
+        &Hart::exec_SRAI,      &Hart::exec_ADDIW,     &Hart::exec_SLLIW,
+        &Hart::exec_SRLIW,     &Hart::exec_SRAIW,     &Hart::exec_ADDW,
+        &Hart::exec_SUBW,      &Hart::exec_SLLW,      &Hart::exec_SRLW,
+        &Hart::exec_SRAW,      &Hart::exec_CSRRW,     &Hart::exec_CSRRS,
+        &Hart::exec_CSRRC,     &Hart::exec_CSRRWI,    &Hart::exec_CSRRSI,
+        &Hart::exec_CSRRCI,    &Hart::exec_SRET,      &Hart::exec_MRET,
+        &Hart::exec_WFI,       &Hart::exec_LR_W,      &Hart::exec_SC_W,
+        &Hart::exec_AMOSWAP_W, &Hart::exec_AMOADD_W,  &Hart::exec_AMOXOR_W,
+        &Hart::exec_AMOAND_W,  &Hart::exec_AMOOR_W,   &Hart::exec_AMOMIN_W,
+        &Hart::exec_AMOMAX_W,  &Hart::exec_AMOMINU_W, &Hart::exec_AMOMAXU_W,
+        &Hart::exec_LR_D,      &Hart::exec_SC_D,      &Hart::exec_AMOSWAP_D,
+        &Hart::exec_AMOADD_D,  &Hart::exec_AMOXOR_D,  &Hart::exec_AMOAND_D,
+        &Hart::exec_AMOOR_D,   &Hart::exec_AMOMIN_D,  &Hart::exec_AMOMAX_D,
+        &Hart::exec_AMOMINU_D, &Hart::exec_AMOMAXU_D, &Hart::exec_BB_END};
 };
 
 } // namespace besm::sim
@@ -23,6 +23,11 @@ public:
     void triggerBBFetchHook(exec::BasicBlock const &bb) const;
     void triggerInstrExecHook(Instruction const &instr) const;
 
+    size_t getBBFetchHooksNum() const { return hooks_.count(BB_FETCHED); }
+    size_t getInstrExecHooksNum() const {
+        return hooks_.count(INSTR_EXECUTED);
+    }
+
     static HookManager::SPtr Create();
 
 private:
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "besm-666/exec/basic-block.hpp"
+#include "besm-666/rv-instruction-op.hpp"
+#include "besm-666/sim/block-profiler.hpp"
+#include "besm-666/util/non-copyable.hpp"
+
+namespace besm::sim {
+
+/**
+ * Exact dynamic instruction mix of a hart, without per-instruction hooks.
+ *
+ * A decoded block is a histogram of its operations, so the profiler only
+ * counts the runs of each block, in an array indexed by
+ * exec::BasicBlock::getId(), and weights the block operations by them when
+ * the mix is read. A block left before its end by a trap is accounted by
+ * its retired prefix at once.
+ */
+class InstrMixProfiler : public IBlockProfiler, INonCopyable {
+public:
+    enum Class {
+        CLASS_ALU,
+        CLASS_LOAD,
+        CLASS_STORE,
+        CLASS_BRANCH, ///< conditional
+        CLASS_JUMP,
+        CLASS_ATOMIC,
+        CLASS_SYSTEM, ///< CSR, trap, fence and hint instructions
+
+        NUM_CLASSES
+    };
+
+    struct Mix {
+        std::array<uint64_t, BB_END> ops{}; ///< indexed by InstructionOp
+
+        uint64_t getTotal() const;
+        uint64_t getClassCount(Class instrClass) const;
+
+        Mix &operator+=(Mix const &other);
+    };
+
+    static char const *GetOperationName(InstructionOp op);
+    static char const *GetClassName(Class instrClass);
+    static Class GetClass(InstructionOp op);
+
+    /// Classes with their ratios, then the operations by count
+    static void Print(std::ostream &output, Mix const &mix);
+
+    /**
+     * {"instructions": N, "classes": {name: count}, "ratios": {name: ratio},
+     *  "operations": {name: count}}, the executed operations only
+     */
+    static void WriteJSON(std::ostream &output, Mix const &mix);
+
+    InstrMixProfiler();
+
+    void onBlockFetch(Hart const &hart, exec::BasicBlock const &bb) override;
+    void finish(Hart const &hart) override;
+
+    Mix getMix() const;
+
+private:
+    void account(size_t instrsExecuted);
+
+    std::vector<exec::BasicBlock const *> blocks_; ///< indexed by block id
+    std::vector<uint64_t> runs_;                   ///< indexed by block id
+    Mix partial_;                                  ///< blocks left by traps
+
+    exec::BasicBlock const *last_;
+    size_t lastInstrs_;
+};
+
+} // namespace besm::sim
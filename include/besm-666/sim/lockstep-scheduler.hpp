@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "besm-666/memory/clint.hpp"
+#include "besm-666/sim/hart-scheduler.hpp"
+#include "besm-666/sim/hart.hpp"
+
+namespace besm::sim {
+
+/**
+ * Interleaves the harts deterministically. The run is a sequence of rounds,
+ * in each round every runnable hart runs one slice of a quantum of
+ * instructions (see Hart::runSlice()). Harts which have executed WFI are
+ * skipped until Hart::wakeUpPending().
+ *
+ * On a single host thread the slices of a round run one after another in
+ * an order drawn from the seed (hart id order if the seed is 0), so the
+ * same guest, seed and quantum give bit-identical results.
+ *
+ * On several host threads the slices of a round run in parallel and the
+ * threads meet at a barrier between rounds. Every hart still executes the
+ * same instructions in each round and mtime only advances between rounds,
+ * but the order of the accesses of different harts to shared memory within
+ * a round is up to the host: the results are reproducible for guests which
+ * don't communicate within a quantum.
+ *
+ * Asynchronous inputs, such as UART RX, break determinism in both modes.
+ */
+class LockstepScheduler final : public IHartScheduler {
+public:
+    /**
+     * \param clint if not null and there are several threads, mtime advances
+     * by the quantum between rounds and the timers fire then
+     */
+    LockstepScheduler(std::vector<Hart::SPtr> harts, size_t numThreads,
+                      size_t quantum, uint64_t seed, mem::CLINT::SPtr clint);
+    ~LockstepScheduler();
+
+    /// The calling thread runs the first share of the harts
+    void runUntil(RV64Ptr stopPC) override;
+
+    std::chrono::duration<double> getRunTime(size_t hartId) const override;
+
+private:
+    static constexpr std::chrono::milliseconds kIdleTimeout{1};
+
+    enum HartState { RUNNABLE, PARKED, STOPPED };
+
+    void threadLoop(size_t threadId, RV64Ptr stopPC);
+    void runRound(RV64Ptr stopPC);
+    void runShare(size_t threadId, RV64Ptr stopPC);
+    void runSlice(size_t hartId, RV64Ptr stopPC);
+    void shuffleOrder();
+
+    std::vector<Hart::SPtr> harts_;
+    std::vector<std::chrono::duration<double>> runTimes_;
+    std::vector<HartState> states_;
+    std::vector<Hart::YieldReason> reasons_;
+    std::vector<std::exception_ptr> errors_;
+    std::vector<size_t> order_; ///< harts running in the current round
+    size_t numThreads_;
+    size_t quantum_;
+    uint64_t seed_;
+    std::mt19937_64 random_;
+
+    mem::CLINT::SPtr clint_;
+    /// A quantum per round run, read by CLINT
+    std::atomic<size_t> roundTime_;
+
+    std::mutex roundMutex_;
+    std::condition_variable roundStart_;
+    std::condition_variable roundEnd_;
+    size_t round_;
+    size_t pendingThreads_;
+    bool exit_;
+};
+
+} // namespace besm::sim
@@ -1,28 +1,141 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "besm-666/memory/clint.hpp"
+#include "besm-666/memory/htif.hpp"
 #include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/memory/ram.hpp"
+#include "besm-666/memory/shared-image.hpp"
+#include "besm-666/memory/uart.hpp"
+#include "besm-666/sim/bbv-profiler.hpp"
 #include "besm-666/sim/config.hpp"
+#include "besm-666/sim/hart-scheduler.hpp"
 #include "besm-666/sim/hart.hpp"
 #include "besm-666/sim/hooks.hpp"
+#include "besm-666/sim/lockstep-scheduler.hpp"
+#include "besm-666/sim/stats.hpp"
+#include "besm-666/sim/syscall-emulator.hpp"
 #include "besm-666/util/non-copyable.hpp"
+#include "besm-666/util/symtab.hpp"
 
 namespace besm::sim {
 
+/**
+ * Harts share the physical memory and the devices. A single hart runs on
+ * the calling thread, otherwise each hart runs on its own host thread,
+ * optionally pinned to a host CPU, or the harts are multiplexed onto a pool
+ * of host threads by a scheduler, deterministically if configured so. Once
+ * a hart stops, the others are stopped at their next basic block boundary.
+ *
+ * Decoded blocks are shared by the harts of a machine. With
+ * Config::sharedCodeCache() they are shared by all the machines running the
+ * same ELF image in the process too. The blocks are keyed by the image hash
+ * and the PC only, so this is sound as long as the guests execute the code
+ * loaded from the image alone: code written at runtime by one machine would
+ * be run by the others. Read-only pages of the image are shared
+ * copy-on-write by the machines, see SharedImage.
+ */
 class Machine : INonCopyable {
 public:
-    Machine(sim::Config const &config);
+    /**
+     * \param ramChunkPool recycles the RAM chunks of the machines sharing it
+     */
+    Machine(sim::Config const &config,
+            mem::RAMChunkPool::SPtr ramChunkPool = nullptr);
 
     void run();
 
+    /**
+     * Runs a single hart machine like run(), but stops the hart at the first
+     * basic block boundary after \p maxInstrs instructions. Returns false if
+     * the budget has run out before the hart stopped.
+     */
+    bool runFor(size_t maxInstrs);
+
+    /**
+     * Stops all the harts at their next basic block boundary, may be called
+     * from any thread
+     */
+    void requestStop();
+
+    /**
+     * Runs the harts until each of them is about to fetch a basic block at
+     * \p stopPC, see Hart::runUntil()
+     */
+    void runUntil(RV64Ptr stopPC);
+
+    /// Returns the boot hart
     sim::Hart const &getHart() const;
+    sim::Hart const &getHart(size_t hartId) const;
+    size_t getHartsNum() const { return harts_.size(); }
+
+    /// Instructions executed by all the harts
+    size_t getInstrsExecuted() const;
+
+    /// Host time the hart has spent running
+    std::chrono::duration<double> getRunTime(size_t hartId) const;
+
+    /**
+     * Returns the exit code reported by the guest, if it has reported one
+     */
+    std::optional<int> getExitCode() const;
 
-    size_t getInstrsExecuted() const { return hart_->getInstrsExecuted(); }
     sim::HookManager &getHookManager() { return *hookManager_; }
 
+    std::shared_ptr<mem::PhysMem const> getPhysMem() const { return pMem_; }
+
+    /**
+     * Must be called in a child process forked from a machine which may have
+     * started device host threads, see UART::afterFork()
+     */
+    void afterFork();
+
+    /// See Hart::attachProfiler()
+    void attachProfiler(size_t hartId, IBlockProfiler *profiler);
+
+    /**
+     * Statistics of the harts, a shard per hart, and of the shared memory
+     * system, the registry may be read while the machine runs
+     */
+    Stats const &getStats() const { return *stats_; }
+
+    /// Code symbols of the executable
+    util::Symtab const &getSymtab() const { return symtab_; }
+
 private:
+    static SyscallEmulator::ProcessImage
+    MakeProcessImage(sim::Config const &config, util::IElfParser &elf);
+
+    /**
+     * Creates HTIF if the program defines tohost symbol
+     */
+    static mem::HTIF::SPtr MakeHTIF(util::IElfParser &elf);
+
+    static uint64_t HashCode(util::IElfParser &elf);
+
+    static void SetAffinity(int cpu);
+
+    void registerStats(exec::SharedBasicBlockCache::SPtr const &codeCache);
+
+    void runHart(size_t hartId, RV64Ptr stopPC);
+
     HookManager::SPtr hookManager_;
+    mem::SharedImage::SPtr sharedImage_; ///< kept for the next machines
     std::shared_ptr<mem::PhysMem> pMem_;
-    sim::Hart::SPtr hart_;
+    std::vector<sim::Hart::SPtr> harts_;
+    std::vector<std::chrono::duration<double>> runTimes_;
+    std::vector<int> hartAffinity_;
+    std::unique_ptr<IHartScheduler> scheduler_; ///< null if a thread per hart
+    SyscallEmulator::SPtr syscalls_;
+    mem::HTIF::SPtr htif_;
+    mem::UART::SPtr uart_;
+    mem::CLINT::SPtr clint_;
+    Stats::SPtr stats_;
+    util::Symtab symtab_;
 };
 
 } // namespace besm::sim
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <ostream>
+#include <signal.h>
+#include <string>
+#include <vector>
+
+#include "besm-666/riscv-types.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/util/non-copyable.hpp"
+#include "besm-666/util/symtab.hpp"
+
+namespace besm::sim {
+
+/**
+ * Statistical profile of the guest PC for runs too long to count blocks.
+ *
+ * A timer_create(2) timer raises SIGPROF at the sampling frequency and the
+ * signal handler reads the block word of each hart, see
+ * Hart::getBlockWord(), into a fixed open addressing table. The harts do
+ * nothing but publish the word, so the cost is proportional to the sampling
+ * rate rather than to the execution rate. A single sampler may run at a
+ * time.
+ */
+class PCSampler : INonCopyable {
+public:
+    static constexpr size_t kNumPrivileges = 4;
+
+    struct Sample {
+        RV64Ptr pc; ///< of the basic block
+        RV64UDWord privilege;
+        uint64_t count;
+    };
+
+    struct Entry {
+        std::string name; ///< "[unknown]" for code not covered by symbols
+        RV64Ptr address;  ///< 0 for unknown code
+        std::array<uint64_t, kNumPrivileges> counts; ///< by privilege level
+        uint64_t total;
+    };
+
+    /**
+     * Sums \p samples by the covering functions of \p symtab, the most
+     * sampled function first
+     */
+    static std::vector<Entry> Symbolize(util::Symtab const &symtab,
+                                        std::vector<Sample> const &samples);
+
+    /// The first \p topN functions with their U, S and M-mode samples
+    static void Print(std::ostream &output, std::vector<Entry> const &profile,
+                      size_t topN);
+
+    /**
+     * A "<privilege>;<function> <samples>" line per function and privilege
+     * level, the folded stacks format of flamegraph.pl
+     */
+    static void WriteFolded(std::ostream &output,
+                            std::vector<Entry> const &profile);
+
+    /// \throws std::invalid_argument if \p frequency is 0
+    explicit PCSampler(unsigned frequency);
+    ~PCSampler();
+
+    /**
+     * Starts sampling \p harts, which must outlive stop(). Returns false if
+     * the timer can't be created or another sampler runs, see getError().
+     */
+    bool start(std::vector<Hart const *> const &harts);
+    void stop();
+
+    std::string const &getError() const { return error_; }
+
+    /// Most sampled first
+    std::vector<Sample> getSamples() const;
+    uint64_t getSamplesNum() const;
+
+    /// Samples of the blocks which have found no free table slot
+    uint64_t getDroppedNum() const;
+
+private:
+    static constexpr size_t kSlotsLog = 14;
+    static constexpr size_t kSlots = size_t(1) << kSlotsLog;
+    static constexpr size_t kMaxProbes = 64;
+
+    /// Key is the block word plus one, 0 if the slot is free
+    struct Slot {
+        std::atomic<uint64_t> key;
+        std::atomic<uint64_t> count;
+    };
+
+    static void HandleSignal(int signo);
+    void sample();
+    void record(uint64_t word);
+
+    unsigned frequency_;
+    std::unique_ptr<Slot[]> slots_;
+    std::vector<std::atomic<uint64_t> const *> words_;
+    std::atomic<uint64_t> samples_;
+    std::atomic<uint64_t> dropped_;
+
+    bool running_;
+    timer_t timer_;
+    struct sigaction previousAction_;
+    std::string error_;
+};
+
+} // namespace besm::sim
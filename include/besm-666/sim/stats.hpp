@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include "besm-666/util/non-copyable.hpp"
+
+namespace besm::sim {
+
+/**
+ * Registry of named statistics shared by the subsystems of a machine.
+ *
+ * Counters and histograms are sharded: each hart writes its own shard, which
+ * lives on its own cache lines, with plain relaxed stores, and the shards
+ * are summed on read. A shard must have a single writer at a time. Gauges
+ * are callbacks sampled on read, they expose the state the shared
+ * subsystems keep anyway (RAM pages, devices accesses).
+ *
+ * Names are dot separated, e.g. "bb_cache.misses". Registering a name
+ * twice returns the same statistic, so each hart may register the ones it
+ * writes. Reads and exports are safe while the harts run.
+ */
+class Stats : INonCopyable {
+    static constexpr size_t kLineSize = 64;
+
+public:
+    using SPtr = std::shared_ptr<Stats>;
+
+    class Counter : INonCopyable {
+    public:
+        Counter(std::string name, std::string help, size_t numShards);
+
+        void add(size_t shard, uint64_t value = 1) noexcept {
+            std::atomic<uint64_t> &slot = shards_[shard].value;
+            slot.store(slot.load(std::memory_order_relaxed) + value,
+                       std::memory_order_relaxed);
+        }
+
+        uint64_t read() const noexcept;
+
+        std::string const &getName() const { return name_; }
+        std::string const &getHelp() const { return help_; }
+
+    private:
+        struct alignas(kLineSize) Shard {
+            std::atomic<uint64_t> value{0};
+        };
+
+        std::string name_;
+        std::string help_;
+        std::unique_ptr<Shard[]> shards_;
+        size_t numShards_;
+    };
+
+    /**
+     * Distribution of non-negative values in power of 2 buckets: bucket 0
+     * holds 0, bucket i holds [2^(i-1), 2^i), the last one everything above.
+     */
+    class Histogram : INonCopyable {
+    public:
+        static constexpr size_t kBuckets = 16;
+
+        struct Snapshot {
+            std::array<uint64_t, kBuckets> buckets{};
+            uint64_t count = 0;
+            uint64_t sum = 0;
+        };
+
+        /// Inclusive upper bound of the bucket, the last one is unbounded
+        static uint64_t GetBucketBound(size_t bucket) noexcept {
+            return (1ull << bucket) - 1;
+        }
+
+        Histogram(std::string name, std::string help, size_t numShards);
+
+        void record(size_t shard, uint64_t value) noexcept {
+            size_t bucket =
+                value == 0 ? 0 : 64 - static_cast<size_t>(__builtin_clzll(value));
+            bucket = bucket < kBuckets ? bucket : kBuckets - 1;
+
+            Shard &slot = shards_[shard];
+            Increment(slot.buckets[bucket], 1);
+            Increment(slot.sum, value);
+        }
+
+        Snapshot read() const noexcept;
+
+        std::string const &getName() const { return name_; }
+        std::string const &getHelp() const { return help_; }
+
+    private:
+        struct alignas(kLineSize) Shard {
+            std::array<std::atomic<uint64_t>, kBuckets> buckets{};
+            std::atomic<uint64_t> sum{0};
+        };
+
+        static void Increment(std::atomic<uint64_t> &slot,
+                              uint64_t value) noexcept {
+            slot.store(slot.load(std::memory_order_relaxed) + value,
+                       std::memory_order_relaxed);
+        }
+
+        std::string name_;
+        std::string help_;
+        std::unique_ptr<Shard[]> shards_;
+        size_t numShards_;
+    };
+
+    class Gauge : INonCopyable {
+    public:
+        using Callback = std::function<double()>;
+
+        Gauge(std::string name, std::string help, Callback callback);
+
+        double read() const { return callback_(); }
+
+        std::string const &getName() const { return name_; }
+        std::string const &getHelp() const { return help_; }
+
+    private:
+        std::string name_;
+        std::string help_;
+        Callback callback_;
+    };
+
+    /// \param numShards writers, usually the harts number
+    static SPtr Create(size_t numShards);
+
+    size_t getShardsNum() const { return numShards_; }
+
+    Counter &counter(std::string const &name, std::string const &help);
+    Histogram &histogram(std::string const &name, std::string const &help);
+    /// The callback must stay valid as long as the registry is read
+    void gauge(std::string const &name, std::string const &help,
+               Gauge::Callback callback);
+
+    /// Return nullptr if the name isn't registered
+    Counter const *findCounter(std::string const &name) const;
+    Histogram const *findHistogram(std::string const &name) const;
+    Gauge const *findGauge(std::string const &name) const;
+
+    /**
+     * {"counters": {name: value}, "gauges": {name: value},
+     *  "histograms": {name: {"count", "sum", "buckets": [{"le", "count"}]}}}
+     */
+    void writeJSON(std::ostream &output) const;
+
+    /**
+     * Prometheus text exposition format. Names get the "besm666_" prefix,
+     * dots become underscores and counters get the "_total" suffix.
+     */
+    void writePrometheus(std::ostream &output) const;
+
+private:
+    explicit Stats(size_t numShards);
+
+    size_t numShards_;
+
+    mutable std::mutex mutex_; ///< guards the lists, not the values
+    std::deque<Counter> counters_;
+    std::deque<Histogram> histograms_;
+    std::deque<Gauge> gauges_;
+};
+
+} // namespace besm::sim
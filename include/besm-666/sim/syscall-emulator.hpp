@@ -0,0 +1,123 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/uio.h>
+#include <vector>
+
+#include "besm-666/exec/gprf.hpp"
+#include "besm-666/memory/mmu.hpp"
+#include "besm-666/riscv-types.hpp"
+#include "besm-666/util/elf-parser.hpp"
+#include "besm-666/util/non-copyable.hpp"
+
+namespace besm::sim {
+
+/**
+ * User-mode Linux personality: serves U-mode ECALLs of statically linked
+ * RISCV Linux executables directly in the simulator instead of raising an
+ * exception into the guest.
+ *
+ * Guest I/O buffers are passed to host syscalls as the list of host spans
+ * backing the guest pages (see MMU::touchHostAddress), so no staging copies
+ * are made. Guest file descriptors are host file descriptors.
+ */
+class SyscallEmulator : public INonCopyable {
+public:
+    using SPtr = std::shared_ptr<SyscallEmulator>;
+
+    struct ProcessImage {
+        RV64Ptr entry;
+        util::IElfParser::ProgramHeaders programHeaders;
+        RV64Ptr imageEnd; ///< end of the highest loaded segment
+        RV64Ptr stackTop;
+        std::vector<std::string> args;
+    };
+
+    static constexpr RV64Size kPageSize = 4096;
+    static constexpr RV64Size kStackSize = 8 * 1024 * 1024;
+
+    static SPtr Create(ProcessImage image);
+
+    /**
+     * Builds the initial process stack (argc, argv, envp, auxv) and sets up
+     * the entry point and the stack pointer.
+     */
+    void initProcess(exec::GPRF &gprf, mem::MMU &mmu);
+
+    /**
+     * Serves the syscall requested by a7 with arguments a0-a5, the result is
+     * written to a0. Returns false if the guest process has exited.
+     */
+    bool handle(exec::GPRF &gprf, mem::MMU &mmu);
+
+    bool exited() const noexcept { return exited_; }
+    int exitCode() const noexcept { return exitCode_; }
+
+private:
+    explicit SyscallEmulator(ProcessImage &&image);
+
+    /// \param offset of pread64 and pwrite64, -1 for the file position
+    RV64DWord doRead(mem::MMU &mmu, int fd, RV64Ptr buf, RV64Size count,
+                     off_t offset);
+    RV64DWord doWrite(mem::MMU &mmu, int fd, RV64Ptr buf, RV64Size count,
+                      off_t offset);
+    RV64DWord doReadV(mem::MMU &mmu, int fd, RV64Ptr iov, RV64Size iovcnt,
+                      bool write);
+    RV64DWord doOpenAt(mem::MMU &mmu, int dirfd, RV64Ptr path, int flags,
+                       int mode);
+    RV64DWord doFStat(mem::MMU &mmu, int fd, RV64Ptr statbuf);
+    RV64DWord doFStatAt(mem::MMU &mmu, int dirfd, RV64Ptr path,
+                        RV64Ptr statbuf, int flags);
+    RV64DWord doBrk(mem::MMU &mmu, RV64Ptr address);
+    RV64DWord doMmap(mem::MMU &mmu, RV64Ptr address, RV64Size length,
+                     int flags, int fd, RV64Size offset);
+    RV64DWord doMunmap(RV64Ptr address, RV64Size length);
+    RV64DWord doClockGetTime(mem::MMU &mmu, int clock, RV64Ptr tp);
+    RV64DWord doGetTimeOfDay(mem::MMU &mmu, RV64Ptr tv);
+    RV64DWord doUname(mem::MMU &mmu, RV64Ptr buf);
+    RV64DWord doGetRandom(mem::MMU &mmu, RV64Ptr buf, RV64Size count);
+
+    /**
+     * Appends host spans backing guest range [address, address + size) to
+     * the iovec list up to the first page not backed by host memory.
+     * Returns the size of the backed part.
+     */
+    static RV64Size collectSpans(mem::MMU &mmu, RV64Ptr address,
+                                 RV64Size size, std::vector<iovec> &spans);
+
+    /// Whether [begin, end) overlaps the pages of some MAP_FIXED mapping
+    bool overlapsFixed(RV64Ptr begin, RV64Ptr end) const;
+    /// Removes [begin, end) from the released mmap ranges
+    void reserveRange(RV64Ptr begin, RV64Ptr end);
+    void zeroGuest(mem::MMU &mmu, RV64Ptr address, RV64Size size);
+
+    static bool copyFromGuest(mem::MMU &mmu, RV64Ptr address, void *data,
+                              RV64Size size);
+    static bool copyToGuest(mem::MMU &mmu, RV64Ptr address, void const *data,
+                            RV64Size size);
+    static bool readGuestString(mem::MMU &mmu, RV64Ptr address,
+                                std::string &string);
+
+    ProcessImage image_;
+
+    RV64Ptr brkBase_;
+    RV64Ptr brk_;
+    RV64Ptr brkHigh_;
+    RV64Ptr mmapTop_;
+    RV64Ptr mmapEnd_;
+    RV64Ptr mmapLow_; ///< the least mmapTop_ so far
+    /// Unmapped ranges above mmapTop_ by their begin, never adjacent
+    std::map<RV64Ptr, RV64Ptr> released_;
+    /// Hull of the MAP_FIXED mappings, whose pages may hold stale data
+    RV64Ptr fixedLow_;
+    RV64Ptr fixedHigh_;
+
+    bool exited_;
+    int exitCode_;
+
+    std::vector<iovec> spans_;
+};
+
+} // namespace besm::sim
@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include "besm-666/riscv-types.hpp"
@@ -10,6 +11,8 @@
 
 namespace besm::util {
 
+class Symtab;
+
 /**
  * \brief interface for elf parser, that can retrieve all LOAD segments
  */
@@ -22,8 +25,11 @@ public:
         RV64Ptr address;
         const void *data;
         RV64Size size;
+        RV64Size memSize; ///< size in memory, includes zero-filled tail
+        bool writable;
 
-        LoadableSegment(RV64Ptr address, void const *data, RV64Size size);
+        LoadableSegment(RV64Ptr address, void const *data, RV64Size size,
+                        RV64Size memSize, bool writable = true);
         LoadableSegment(LoadableSegment &&other);
         LoadableSegment &operator=(LoadableSegment &&other);
     };
@@ -34,6 +40,40 @@ public:
      */
     virtual const std::vector<LoadableSegment> &getLoadableSegments() & = 0;
 
+    /**
+     * \brief stores the location of program headers in the loaded image
+     */
+    struct ProgramHeaders {
+        RV64Ptr address; ///< 0 if headers are not covered by LOAD segments
+        RV64Size entrySize;
+        RV64Size count;
+    };
+
+    virtual RV64Ptr getEntryPoint() const = 0;
+    virtual ProgramHeaders getProgramHeaders() const = 0;
+
+    /**
+     * \brief stores data about defined symbol of .symtab or .dynsym
+     */
+    struct Symbol {
+        std::string name;
+        RV64Ptr address;
+        RV64Size size;
+        bool isFunction;
+    };
+
+    /**
+     * \brief stores all defined named symbols in vector and returns a
+     * reference to it
+     */
+    virtual const std::vector<Symbol> &getSymbols() & = 0;
+
+    /**
+     * \brief returns the code symbols sorted by address, built once from
+     * getSymbols()
+     */
+    virtual const Symtab &getSymtab() & = 0;
+
     virtual ~IElfParser() = default;
 };
 
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "besm-666/util/non-copyable.hpp"
+
+namespace besm::util {
+
+/**
+ * Host hardware counters read with perf_event_open(2). The counters follow
+ * the thread which has created them and the threads it starts afterwards,
+ * so they should be created before the harts are.
+ *
+ * Events the host can't count (no PMU in a VM, perf_event_paranoid,
+ * seccomp) are reported unavailable and the others are counted as usual.
+ * Counts of multiplexed events are scaled by their enabled to running time
+ * ratio.
+ */
+class PerfCounters : INonCopyable {
+public:
+    enum Event {
+        EVENT_CYCLES,
+        EVENT_INSTRUCTIONS,
+        EVENT_BRANCH_MISSES,
+        EVENT_L1D_LOAD_MISSES,
+        EVENT_DTLB_LOAD_MISSES,
+
+        NUM_EVENTS
+    };
+
+    /// Empty for the unavailable events
+    using Counts = std::array<std::optional<uint64_t>, NUM_EVENTS>;
+
+    static char const *GetEventName(Event event);
+
+    PerfCounters();
+    ~PerfCounters();
+
+    /// True if at least one of the events is counted
+    bool available() const;
+
+    /// Why the first unavailable event couldn't be opened
+    std::string const &getError() const { return error_; }
+
+    /// Resets and enables the counters
+    void start();
+
+    /// Disables the counters and returns the counts since start()
+    Counts stop();
+
+private:
+    std::array<int, NUM_EVENTS> fds_;
+    std::string error_;
+};
+
+} // namespace besm::util
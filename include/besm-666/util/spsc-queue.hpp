@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+#include "besm-666/util/math.hpp"
+#include "besm-666/util/non-copyable.hpp"
+
+namespace besm::util {
+
+/**
+ * Bounded lock-free single-producer single-consumer ring. Positions grow
+ * monotonically and are wrapped with a mask, so Capacity must be a power of
+ * two. Each side caches the other's position and reloads it only when the
+ * ring looks full (short of elements), so the fast path touches one shared
+ * cache line.
+ */
+template <typename Type, size_t Capacity>
+class SPSCQueue : public INonCopyable {
+    static_assert(Is2Pow(Capacity), "Capacity must be a power of 2");
+    static_assert(std::is_trivially_copyable_v<Type>);
+
+public:
+    SPSCQueue() = default;
+
+    /// Producer side. Returns false if the queue is full.
+    bool push(Type value) noexcept;
+
+    /// Consumer side. Pops up to \p count elements, returns popped count.
+    size_t pop(Type *out, size_t count) noexcept;
+
+    bool empty() const noexcept;
+
+private:
+    static constexpr size_t kMask = Capacity - 1;
+    static constexpr size_t kLineSize = 64;
+
+    alignas(kLineSize) std::atomic<size_t> head_{0}; ///< written by consumer
+    size_t cachedTail_ = 0;
+
+    alignas(kLineSize) std::atomic<size_t> tail_{0}; ///< written by producer
+    size_t cachedHead_ = 0;
+
+    alignas(kLineSize) Type data_[Capacity];
+};
+
+template <typename Type, size_t Capacity>
+bool SPSCQueue<Type, Capacity>::push(Type value) noexcept {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cachedHead_ == Capacity) {
+        cachedHead_ = head_.load(std::memory_order_acquire);
+        if (tail - cachedHead_ == Capacity) {
+            return false;
+        }
+    }
+
+    data_[tail & kMask] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename Type, size_t Capacity>
+size_t SPSCQueue<Type, Capacity>::pop(Type *out, size_t count) noexcept {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (cachedTail_ - head < count) {
+        cachedTail_ = tail_.load(std::memory_order_acquire);
+    }
+
+    count = std::min(count, cachedTail_ - head);
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = data_[(head + i) & kMask];
+    }
+
+    head_.store(head + count, std::memory_order_release);
+    return count;
+}
+
+template <typename Type, size_t Capacity>
+bool SPSCQueue<Type, Capacity>::empty() const noexcept {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+}
+
+} // namespace besm::util
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "besm-666/riscv-types.hpp"
+#include "besm-666/util/elf-parser.hpp"
+
+namespace besm::util {
+
+/**
+ * \brief address index of the code symbols of an ELF, see
+ * IElfParser::getSymtab()
+ *
+ * Function symbols are indexed, or all the symbols if the ELF has no typed
+ * functions, as hand-written assembly usually does. A symbol without size
+ * spans up to the next indexed symbol, aliases of an address are merged
+ * into the first of them.
+ */
+class Symtab {
+public:
+    struct Entry {
+        std::string name;
+        RV64Ptr address;
+        RV64Size size; ///< 0 if the symbol spans up to the next one
+    };
+
+    Symtab() = default;
+    explicit Symtab(std::vector<IElfParser::Symbol> const &symbols);
+
+    /**
+     * \brief returns the symbol covering \p address, nullptr if there is
+     * none. O(log n)
+     */
+    Entry const *lookup(RV64Ptr address) const;
+
+    /// Sorted by address
+    std::vector<Entry> const &getEntries() const { return entries_; }
+    bool empty() const { return entries_.empty(); }
+
+private:
+    std::vector<Entry> entries_;
+};
+
+} // namespace besm::util
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "besm-666/util/non-copyable.hpp"
+
+namespace besm::util {
+
+/**
+ * Host timeline of the simulator phases in the Chrome trace-event JSON
+ * format, which chrome://tracing and Perfetto open.
+ *
+ * Spans are appended to a buffer of the recording thread and written to the
+ * file by a background thread, so recording takes no global lock and does
+ * no I/O. While the tracer is stopped a span costs a relaxed load and a
+ * branch.
+ *
+ * Event names must be string literals, only the pointers are buffered.
+ */
+class Tracer {
+public:
+    /// Steady clock nanoseconds, the span timestamps
+    static uint64_t Now() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    static bool Enabled() noexcept {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Starts writing the trace to \p path, flushing the buffers every
+     * \p flushPeriod. Returns false if the file can't be opened or the
+     * tracer already runs.
+     */
+    static bool Start(std::filesystem::path const &path,
+                      std::chrono::milliseconds flushPeriod =
+                          std::chrono::milliseconds(100));
+
+    /**
+     * Flushes the buffers and completes the file. Spans still open on
+     * other threads are dropped.
+     */
+    static void Stop();
+
+    /// Records a complete event, \p argName is an optional counter of it
+    static void Record(char const *name, uint64_t start, uint64_t end,
+                       char const *argName = nullptr, uint64_t arg = 0);
+
+    /// Names the calling thread in the trace viewer
+    static void SetThreadName(std::string name);
+
+private:
+    static std::atomic<bool> enabled_;
+};
+
+/**
+ * Traces the scope it lives in:
+ *
+ *     util::TraceSpan span("phys_mem.load_elf");
+ */
+class TraceSpan : INonCopyable {
+public:
+    explicit TraceSpan(char const *name) noexcept
+        : name_(name), start_(Tracer::Enabled() ? Tracer::Now() : 0) {}
+
+    ~TraceSpan() {
+        if (start_ != 0) {
+            Tracer::Record(name_, start_, Tracer::Now());
+        }
+    }
+
+private:
+    char const *name_;
+    uint64_t start_; ///< 0 if the tracer was stopped
+};
+
+/**
+ * Merges events closer than the gap into a single span counting them, for
+ * frequent short events such as block decoding. Not thread-safe, the
+ * owner serializes add() and flush().
+ */
+class TraceBurst : INonCopyable {
+public:
+    TraceBurst(char const *name, char const *countName,
+               std::chrono::nanoseconds gap)
+        : name_(name), countName_(countName), gap_(gap.count()), start_(0),
+          end_(0), count_(0) {}
+
+    ~TraceBurst() { this->flush(); }
+
+    void add(uint64_t start, uint64_t end) {
+        if (count_ != 0 && start > end_ + gap_) {
+            this->flush();
+        }
+        if (count_ == 0) {
+            start_ = start;
+        }
+        end_ = end;
+        ++count_;
+    }
+
+    /// Records the pending burst
+    void flush() {
+        if (count_ != 0) {
+            Tracer::Record(name_, start_, end_, countName_, count_);
+            count_ = 0;
+        }
+    }
+
+private:
+    char const *name_;
+    char const *countName_;
+    uint64_t gap_;
+    uint64_t start_;
+    uint64_t end_;
+    uint64_t count_;
+};
+
+} // namespace besm::util
@@ -55,6 +55,7 @@ Instruction dec::Decoder::parse_R(const RV64UWord bytecode, const Opcode opcode,
     constexpr RV64UWord FUNC7_MASK = 0b1111111 << FUNC7_SHIFT;
     constexpr Opcode OP = 0b0110011;
     constexpr Opcode OP32 = 0b0111011;
+    constexpr Opcode AMO = 0b0101111;
     const uint16_t func7 = (bytecode & FUNC7_MASK) >> (FUNC7_SHIFT - 3);
     const uint16_t func10 = func7 | func3;
     assert(func10 < 0b10000000000);
@@ -112,6 +113,52 @@ Instruction dec::Decoder::parse_R(const RV64UWord bytecode, const Opcode opcode,
             break;
         }
         break;
+    case AMO: {
+        // aq and rl bits are ignored, AMOs are sequentially consistent
+        constexpr uint8_t WIDTH_W = 0b010;
+        constexpr uint8_t WIDTH_D = 0b011;
+        const uint8_t func5 = func7 >> 5;
+        const bool isDouble = func3 == WIDTH_D;
+        assert(func3 == WIDTH_W || func3 == WIDTH_D);
+        switch (func5) {
+        case 0b00010:
+            if (ExtractRegister<RS2_SHIFT>(bytecode) == 0) {
+                operation = isDouble ? LR_D : LR_W;
+            }
+            break;
+        case 0b00011:
+            operation = isDouble ? SC_D : SC_W;
+            break;
+        case 0b00001:
+            operation = isDouble ? AMOSWAP_D : AMOSWAP_W;
+            break;
+        case 0b00000:
+            operation = isDouble ? AMOADD_D : AMOADD_W;
+            break;
+        case 0b00100:
+            operation = isDouble ? AMOXOR_D : AMOXOR_W;
+            break;
+        case 0b01100:
+            operation = isDouble ? AMOAND_D : AMOAND_W;
+            break;
+        case 0b01000:
+            operation = isDouble ? AMOOR_D : AMOOR_W;
+            break;
+        case 0b10000:
+            operation = isDouble ? AMOMIN_D : AMOMIN_W;
+            break;
+        case 0b10100:
+            operation = isDouble ? AMOMAX_D : AMOMAX_W;
+            break;
+        case 0b11000:
+            operation = isDouble ? AMOMINU_D : AMOMINU_W;
+            break;
+        case 0b11100:
+            operation = isDouble ? AMOMAXU_D : AMOMAXU_W;
+            break;
+        }
+        break;
+    }
     }
     return Instruction{.rd = ExtractRegister<RD_SHIFT>(bytecode),
                        .rs1 = ExtractRegister<RS1_SHIFT>(bytecode),
@@ -145,15 +192,18 @@ Instruction dec::Decoder::parse_I(const RV64UWord bytecode,
     constexpr Opcode OPP_IMM32 = 0b0011011;
     switch (opcode) {
     case MISC_MEM:
-        /*
-         * @todo #39:90min Implement processing of 0b0001111 opcode.
-         *  According to the new specification
-         *  https://raw.githubusercontent.com/riscv/riscv-isa-manual/8176af1a46bfe2e15f8cdb170d74e52e1ba6efa2/src/rv-32-64g.adoc
-         *  there are not FENCE only but also FENCE.TSO and PAUSE with
-         * non-trivial decoding. Nor it just returns FENCE operation.
-         */
-        return Instruction{
-            .rd = rd, .rs1 = rs1, .immidiate = imm, .operation = FENCE};
+        // FENCE.TSO and PAUSE are FENCEs with particular fm, pred and succ
+        operation = FENCE;
+        if (rd == 0b0 && rs1 == 0b0 && func3 == 0b0) {
+            switch (imm) {
+            case 0b100000110011:
+                operation = FENCE_TSO;
+                break;
+            case 0b000000010000:
+                operation = PAUSE;
+                break;
+            }
+        }
         break;
     case SYSTEM:
         if (rd == 0b0 && rs1 == 0b0 && func3 == 0b0) {
@@ -170,6 +220,9 @@ Instruction dec::Decoder::parse_I(const RV64UWord bytecode,
             case 0b001100000010:
                 operation = MRET;
                 break;
+            case 0b000100000101:
+                operation = WFI;
+                break;
             }
         }
         break;
@@ -2,50 +2,139 @@
 #include "besm-666/decoder/decoder.hpp"
 #include <iostream>
 #include <limits>
+#include <utility>
 
 namespace besm::exec {
 
 BasicBlock::BasicBlock() {
     pc_ = 1; // POISONED VALUE, CAN'T BE MET ON RUNTIME
+    size_ = 0;
+    id_ = 0;
     instrs_[0].operation = INV_OP;
 }
 
-BasicBlockCache::BasicBlockCache() {
-    for (auto &lruRower : lruRowers_) {
-        lruRower = 0;
+SharedBasicBlockCache::SPtr SharedBasicBlockCache::Create() {
+    return std::shared_ptr<SharedBasicBlockCache>(new SharedBasicBlockCache());
+}
+
+SharedBasicBlockCache::SPtr const &SharedBasicBlockCache::Global() {
+    static SPtr const global = Create();
+    return global;
+}
+
+SharedBasicBlockCache::SharedBasicBlockCache()
+    : buckets_(new std::atomic<Node const *>[kBuckets]), blocksNum_(0),
+      nextId_(1) {
+    for (size_t i = 0; i < kBuckets; ++i) {
+        buckets_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+SharedBasicBlockCache::~SharedBasicBlockCache() {
+    for (size_t i = 0; i < kBuckets; ++i) {
+        Node const *node = buckets_[i].load(std::memory_order_relaxed);
+        while (node != nullptr) {
+            delete std::exchange(node, node->next);
+        }
+    }
+}
+
+size_t SharedBasicBlockCache::GetBucket(uint64_t codeHash,
+                                        RV64Ptr pc) noexcept {
+    uint64_t hash = (codeHash ^ (pc >> 2)) * 0x9E3779B97F4A7C15ull;
+    return hash >> (64 - kBucketBits);
+}
+
+BasicBlock const *SharedBasicBlockCache::Find(Node const *node,
+                                              Node const *end,
+                                              uint64_t codeHash,
+                                              RV64Ptr pc) noexcept {
+    for (; node != end; node = node->next) {
+        if (node->bb.getPC() == pc && node->codeHash == codeHash) {
+            return &node->bb;
+        }
     }
+    return nullptr;
 }
 
-std::pair<bool, BasicBlock &> BasicBlockCache::lookup(RV64Ptr pc) {
+BasicBlock const *SharedBasicBlockCache::lookup(uint64_t codeHash,
+                                                RV64Ptr pc) const noexcept {
+    std::atomic<Node const *> const &bucket =
+        buckets_[GetBucket(codeHash, pc)];
+    return Find(bucket.load(std::memory_order_acquire), nullptr, codeHash, pc);
+}
+
+BasicBlock const *SharedBasicBlockCache::publish(uint64_t codeHash,
+                                                 BasicBlock const &bb) {
+    std::atomic<Node const *> &bucket =
+        buckets_[GetBucket(codeHash, bb.getPC())];
+
+    Node *node = new Node{codeHash, bb, bucket.load(std::memory_order_acquire)};
+    // A block which loses the race wastes its id, the ids stay unique
+    node->bb.id_ = nextId_.fetch_add(1, std::memory_order_relaxed);
+    Node const *checked = nullptr;
+    while (true) {
+        // Only the nodes published since the last attempt may hold the block
+        BasicBlock const *published =
+            Find(node->next, checked, codeHash, bb.getPC());
+        if (published != nullptr) {
+            delete node;
+            return published;
+        }
+        checked = node->next;
+
+        if (bucket.compare_exchange_weak(node->next, node,
+                                         std::memory_order_release,
+                                         std::memory_order_acquire)) {
+            blocksNum_.fetch_add(1, std::memory_order_relaxed);
+            return &node->bb;
+        }
+    }
+}
+
+BasicBlockCache::BasicBlockCache() {
+    static BasicBlock const poisoned;
+    bbs_.fill(&poisoned);
+    lruRowers_.fill(0);
+}
+
+size_t BasicBlockCache::GetSet(RV64Ptr pc) noexcept {
     // Fix me: 2 bit offset because of insn alignment, 3 bits because
     // of bb capacity
-    RV64Ptr hash = (pc & (kSetMask << 5)) >> 5;
-    size_t setPos = hash * kWays;
+    return (pc & (kSetMask << 5)) >> 5;
+}
 
-    for (size_t i = 0; i < kWays; ++i) {
-        size_t index = setPos + i;
+BasicBlock const *BasicBlockCache::lookup(RV64Ptr pc) const noexcept {
+    size_t setPos = GetSet(pc) * kWays;
 
-        if (bbs_[index].getPC() == pc) {
-            return std::make_pair(true, std::ref(bbs_[index]));
+    for (size_t i = 0; i < kWays; ++i) {
+        BasicBlock const *bb = bbs_[setPos + i];
+        if (bb->getPC() == pc) {
+            return bb;
         }
     }
 
-    size_t index = lruRowers_[hash] + setPos;
+    return nullptr;
+}
 
-    lruRowers_[hash] = (lruRowers_[hash] + 1) & kWayMask;
+void BasicBlockCache::insert(BasicBlock const *bb) noexcept {
+    size_t set = GetSet(bb->getPC());
 
-    return std::make_pair(false, std::ref(bbs_[index]));
+    bbs_[set * kWays + lruRowers_[set]] = bb;
+    lruRowers_[set] = (lruRowers_[set] + 1) & kWayMask;
 }
 
 BasicBlockRebuilder::BasicBlockRebuilder(BasicBlock &targetBB, size_t pc)
     : bb_(targetBB), count_(0) {
     bb_.pc_ = pc;
+    bb_.size_ = 0;
 }
 
 bool BasicBlockRebuilder::append(Instruction const &instr) noexcept {
     bb_.instrs_[count_] = instr;
 
     ++count_;
+    bb_.size_ = count_;
     if (instr.isJump() || count_ == BasicBlock::kCapacity - 1) {
         bb_.instrs_[count_].operation = BB_END;
         return false;
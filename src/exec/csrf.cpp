@@ -8,7 +8,8 @@
 namespace besm::exec {
 
 CSRF::CSRF()
-    : mhartid(*this), mstatus(*this), mepc(*this), mtvec(*this), mcause(*this),
+    : mhartid(*this), mstatus(*this), mie(*this), mip(*this), mepc(*this),
+      mtvec(*this), mcause(*this),
       privillege_(PRIVILLEGE_MACHINE) {}
 
 std::variant<bool, RV64UDWord> CSRF::write(RV64UDWord rawId,
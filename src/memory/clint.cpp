@@ -0,0 +1,256 @@
+#include <stdexcept>
+
+#include "besm-666/memory/clint.hpp"
+
+namespace besm::mem {
+
+CLINT::SPtr CLINT::Create(size_t numHarts, RV64UDWord frequency) {
+    return std::shared_ptr<CLINT>(new CLINT(numHarts, frequency));
+}
+
+CLINT::CLINT(size_t numHarts, RV64UDWord frequency)
+    : IPhysMemDevice(IPhysMemDevice::TIMER), numHarts_(numHarts),
+      frequency_(frequency), timeOffset_(0), timeSource_(nullptr),
+      harts_(new HartState[numHarts]) {
+    if (numHarts == 0 || numHarts > kMaxHarts) {
+        throw std::invalid_argument("Invalid CLINT harts number");
+    }
+    if (frequency == 0 || frequency > kHartFrequency) {
+        throw std::invalid_argument("Invalid CLINT frequency");
+    }
+}
+
+RV64UChar CLINT::loadByte(RV64Ptr address) const {
+    return this->readRegister(address, sizeof(RV64UChar));
+}
+RV64UHWord CLINT::loadHWord(RV64Ptr address) const {
+    return this->readRegister(address, sizeof(RV64UHWord));
+}
+RV64UWord CLINT::loadWord(RV64Ptr address) const {
+    return this->readRegister(address, sizeof(RV64UWord));
+}
+RV64UDWord CLINT::loadDWord(RV64Ptr address) const {
+    return this->readRegister(address, sizeof(RV64UDWord));
+}
+
+void CLINT::storeByte(RV64Ptr address, RV64UChar value) {
+    this->writeRegister(address, sizeof(value), value);
+}
+void CLINT::storeHWord(RV64Ptr address, RV64UHWord value) {
+    this->writeRegister(address, sizeof(value), value);
+}
+void CLINT::storeWord(RV64Ptr address, RV64UWord value) {
+    this->writeRegister(address, sizeof(value), value);
+}
+void CLINT::storeDWord(RV64Ptr address, RV64UDWord value) {
+    this->writeRegister(address, sizeof(value), value);
+}
+
+std::pair<void const *, size_t> CLINT::getHostAddress(RV64Ptr) const {
+    return std::make_pair(nullptr, 0);
+}
+std::pair<void *, size_t> CLINT::touchHostAddress(RV64Ptr) {
+    return std::make_pair(nullptr, 0);
+}
+
+size_t CLINT::getSize() const noexcept { return kSize; }
+
+void CLINT::attachHart(size_t hartId,
+                       std::atomic<size_t> const *instrsExecuted,
+                       exec::MIP &mip) {
+    HartState &state = this->hart(hartId);
+    state.instrsExecuted = instrsExecuted;
+    state.mip = &mip;
+    this->updateDeadline(hartId);
+}
+
+std::atomic<RV64UDWord> const &CLINT::getDeadline(size_t hartId) const {
+    return this->hart(hartId).deadline;
+}
+
+void CLINT::expireTimer(size_t hartId) {
+    HartState &state = this->hart(hartId);
+    state.deadline.store(kNoDeadline, std::memory_order_relaxed);
+    state.mtip.store(true, std::memory_order_release);
+    this->setPending(state, MIP_MTIP, true);
+}
+
+bool CLINT::timerPending(size_t hartId) const {
+    return this->hart(hartId).mtip.load(std::memory_order_acquire);
+}
+bool CLINT::softwarePending(size_t hartId) const {
+    return this->hart(hartId).msip.load(std::memory_order_acquire);
+}
+
+void CLINT::setTimeSource(std::atomic<size_t> const *instrs) {
+    timeSource_ = instrs;
+    for (size_t hartId = 0; hartId < numHarts_; ++hartId) {
+        if (harts_[hartId].deadline.load(std::memory_order_relaxed) !=
+            kNoDeadline) {
+            this->updateDeadline(hartId);
+        }
+    }
+}
+
+void CLINT::expireTimers() {
+    RV64UDWord now = this->getTime();
+    for (size_t hartId = 0; hartId < numHarts_; ++hartId) {
+        HartState &state = harts_[hartId];
+        if (state.deadline.load(std::memory_order_relaxed) ==
+                kTimeSourceDeadline &&
+            state.mtimecmp <= now) {
+            this->expireTimer(hartId);
+        }
+    }
+}
+
+RV64UDWord CLINT::getTime() const noexcept {
+    // The counter is advanced possibly on another host thread
+    std::atomic<size_t> const *instrs =
+        timeSource_ != nullptr ? timeSource_ : harts_[0].instrsExecuted;
+    return this->toTime(instrs == nullptr
+                            ? 0
+                            : instrs->load(std::memory_order_relaxed)) +
+           timeOffset_;
+}
+
+CLINT::HartState &CLINT::hart(size_t hartId) const {
+    if (hartId >= numHarts_) {
+        throw IPhysMemDevice::InvalidAddressError("CLINT invalid hart");
+    }
+    return harts_[hartId];
+}
+
+RV64UDWord CLINT::toTime(size_t instrs) const noexcept {
+    return static_cast<unsigned __int128>(instrs) * frequency_ /
+           kHartFrequency;
+}
+
+/**
+ * The least instruction count at which toTime() reaches \p time
+ */
+RV64UDWord CLINT::toInstrs(RV64UDWord time) const noexcept {
+    unsigned __int128 instrs =
+        (static_cast<unsigned __int128>(time) * kHartFrequency + frequency_ -
+         1) /
+        frequency_;
+    return instrs >= kNoDeadline ? kNoDeadline
+                                 : static_cast<RV64UDWord>(instrs);
+}
+
+void CLINT::updateDeadline(size_t hartId) {
+    HartState &state = this->hart(hartId);
+    state.mtip.store(false, std::memory_order_release);
+    this->setPending(state, MIP_MTIP, false);
+
+    RV64UDWord deadline = kNoDeadline;
+    if (state.mtimecmp != kNoDeadline && timeSource_ != nullptr) {
+        // The hart clock may run ahead of or lag behind the time source
+        deadline =
+            state.mtimecmp <= this->getTime() ? 0 : kTimeSourceDeadline;
+    } else if (state.mtimecmp != kNoDeadline) {
+        size_t instrs =
+            state.instrsExecuted == nullptr
+                ? 0
+                : state.instrsExecuted->load(std::memory_order_relaxed);
+        RV64UDWord hartTime = this->toTime(instrs);
+        RV64UDWord now = hartTime + timeOffset_;
+        if (state.mtimecmp <= now) {
+            deadline = 0;
+        } else {
+            unsigned __int128 target =
+                static_cast<unsigned __int128>(hartTime) +
+                (state.mtimecmp - now);
+            deadline = target >= kNoDeadline
+                           ? kNoDeadline
+                           : this->toInstrs(static_cast<RV64UDWord>(target));
+        }
+    }
+    state.deadline.store(deadline, std::memory_order_relaxed);
+}
+
+void CLINT::setPending(HartState &state, RV64UDWord mask, bool pending) {
+    if (state.mip == nullptr) {
+        return;
+    }
+    if (pending) {
+        state.mip->raise(mask);
+    } else {
+        state.mip->clear(mask);
+    }
+}
+
+RV64UDWord CLINT::readRegister(RV64Ptr address, size_t size) const {
+    this->countAccess();
+    if (address % size != 0) {
+        throw IPhysMemDevice::UnalignedAddressError("CLINT unaligned access");
+    }
+
+    RV64Ptr base;
+    RV64UDWord value;
+    if (address < kMSIPBase + numHarts_ * sizeof(RV64UWord)) {
+        base = address & ~static_cast<RV64Ptr>(sizeof(RV64UWord) - 1);
+        value = this->hart((base - kMSIPBase) / sizeof(RV64UWord))
+                    .msip.load(std::memory_order_acquire);
+    } else if (address >= kMTimeCmpBase &&
+               address < kMTimeCmpBase + numHarts_ * sizeof(RV64UDWord)) {
+        base = address & ~static_cast<RV64Ptr>(sizeof(RV64UDWord) - 1);
+        value = this->hart((base - kMTimeCmpBase) / sizeof(RV64UDWord))
+                    .mtimecmp;
+    } else if (address >= kMTime && address < kMTime + sizeof(RV64UDWord)) {
+        base = kMTime;
+        value = this->getTime();
+    } else if (address < kSize) {
+        return 0;
+    } else {
+        throw IPhysMemDevice::InvalidAddressError("CLINT out of bounds");
+    }
+
+    RV64UDWord mask = size == sizeof(RV64UDWord)
+                          ? ~static_cast<RV64UDWord>(0)
+                          : (static_cast<RV64UDWord>(1) << (8 * size)) - 1;
+    return (value >> (8 * (address - base))) & mask;
+}
+
+void CLINT::writeRegister(RV64Ptr address, size_t size, RV64UDWord value) {
+    this->countAccess();
+    if (address % size != 0) {
+        throw IPhysMemDevice::UnalignedAddressError("CLINT unaligned access");
+    }
+
+    // Narrow stores update a part of the register
+    auto merge = [&](RV64UDWord old, RV64Ptr base) {
+        RV64UDWord mask = size == sizeof(RV64UDWord)
+                              ? ~static_cast<RV64UDWord>(0)
+                              : (static_cast<RV64UDWord>(1) << (8 * size)) - 1;
+        size_t shift = 8 * (address - base);
+        return (old & ~(mask << shift)) | ((value & mask) << shift);
+    };
+
+    if (address < kMSIPBase + numHarts_ * sizeof(RV64UWord)) {
+        RV64Ptr base = address & ~static_cast<RV64Ptr>(sizeof(RV64UWord) - 1);
+        HartState &state = this->hart((base - kMSIPBase) / sizeof(RV64UWord));
+        bool msip = merge(state.msip, base) & 1;
+        state.msip.store(msip, std::memory_order_release);
+        this->setPending(state, MIP_MSIP, msip);
+    } else if (address >= kMTimeCmpBase &&
+               address < kMTimeCmpBase + numHarts_ * sizeof(RV64UDWord)) {
+        RV64Ptr base =
+            address & ~static_cast<RV64Ptr>(sizeof(RV64UDWord) - 1);
+        size_t hartId = (base - kMTimeCmpBase) / sizeof(RV64UDWord);
+        HartState &state = this->hart(hartId);
+        state.mtimecmp = merge(state.mtimecmp, base);
+        this->updateDeadline(hartId);
+    } else if (address >= kMTime && address < kMTime + sizeof(RV64UDWord)) {
+        RV64UDWord now = this->getTime();
+        // Modulo 2^64, so mtime may be moved backward
+        timeOffset_ += merge(now, kMTime) - now;
+        for (size_t hartId = 0; hartId < numHarts_; ++hartId) {
+            this->updateDeadline(hartId);
+        }
+    } else if (address >= kSize) {
+        throw IPhysMemDevice::InvalidAddressError("CLINT out of bounds");
+    }
+}
+
+} // namespace besm::mem
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <unistd.h>
+
+#include "besm-666/memory/htif.hpp"
+
+namespace besm::mem {
+
+HTIF::SPtr HTIF::Create(RV64Ptr tohost, std::optional<RV64Ptr> fromhost) {
+    return std::shared_ptr<HTIF>(
+        new HTIF(tohost, fromhost.value_or(tohost + sizeof(RV64UDWord))));
+}
+
+HTIF::HTIF(RV64Ptr tohost, RV64Ptr fromhost)
+    : IPhysMemDevice(IPhysMemDevice::HTIF),
+      baseAddress_(std::min(tohost, fromhost)), exited_(false), exitCode_(0) {
+    if (tohost % sizeof(RV64UDWord) != 0 ||
+        fromhost % sizeof(RV64UDWord) != 0) {
+        throw IPhysMemDevice::UnalignedAddressError(
+            "HTIF registers must be 8-byte aligned");
+    }
+    if (tohost == fromhost) {
+        throw IPhysMemDevice::InvalidAddressError(
+            "HTIF tohost and fromhost can't share an address");
+    }
+
+    tohostIdx_ = (tohost - baseAddress_) / sizeof(RV64UDWord);
+    fromhostIdx_ = (fromhost - baseAddress_) / sizeof(RV64UDWord);
+    regs_.assign(std::max(tohostIdx_, fromhostIdx_) + 1, 0);
+}
+
+RV64UChar HTIF::loadByte(RV64Ptr address) const {
+    return this->load<RV64UChar>(address);
+}
+RV64UHWord HTIF::loadHWord(RV64Ptr address) const {
+    return this->load<RV64UHWord>(address);
+}
+RV64UWord HTIF::loadWord(RV64Ptr address) const {
+    return this->load<RV64UWord>(address);
+}
+RV64UDWord HTIF::loadDWord(RV64Ptr address) const {
+    return this->load<RV64UDWord>(address);
+}
+
+void HTIF::storeByte(RV64Ptr address, RV64UChar value) {
+    this->store<RV64UChar>(address, value);
+}
+void HTIF::storeHWord(RV64Ptr address, RV64UHWord value) {
+    this->store<RV64UHWord>(address, value);
+}
+void HTIF::storeWord(RV64Ptr address, RV64UWord value) {
+    this->store<RV64UWord>(address, value);
+}
+void HTIF::storeDWord(RV64Ptr address, RV64UDWord value) {
+    this->store<RV64UDWord>(address, value);
+}
+
+std::pair<void const *, size_t> HTIF::getHostAddress(RV64Ptr address) const {
+    if (address >= this->getSize()) {
+        throw IPhysMemDevice::InvalidAddressError("HTIF out of bounds");
+    }
+    return std::make_pair(
+        reinterpret_cast<char const *>(regs_.data()) + address,
+        this->getSize() - address);
+}
+std::pair<void *, size_t> HTIF::touchHostAddress(RV64Ptr address) {
+    if (address >= this->getSize()) {
+        throw IPhysMemDevice::InvalidAddressError("HTIF out of bounds");
+    }
+    return std::make_pair(reinterpret_cast<char *>(regs_.data()) + address,
+                          this->getSize() - address);
+}
+
+size_t HTIF::getSize() const noexcept {
+    return regs_.size() * sizeof(RV64UDWord);
+}
+
+bool HTIF::process(PhysMem &pMem) {
+    RV64UDWord tohost =
+        __atomic_exchange_n(&regs_[tohostIdx_], 0, __ATOMIC_ACQ_REL);
+    if (tohost == 0) {
+        return true;
+    }
+
+    RV64UDWord device = tohost >> 56;
+    RV64UDWord cmd = (tohost >> 48) & 0xFF;
+    RV64UDWord payload = tohost & ((1ull << 48) - 1);
+
+    if (device == 0 && cmd == 0) {
+        if (payload & 1) {
+            exited_ = true;
+            exitCode_ = static_cast<int>(payload >> 1);
+            return false;
+        }
+
+        RV64DWord result = this->doSyscall(pMem, payload);
+        pMem.storeDWord(payload, static_cast<RV64UDWord>(result));
+        __atomic_store_n(&regs_[fromhostIdx_], 1, __ATOMIC_RELEASE);
+    } else if (device == 1 && cmd == 1) {
+        char c = static_cast<char>(payload & 0xFF);
+        ::write(STDOUT_FILENO, &c, 1);
+        __atomic_store_n(&regs_[fromhostIdx_], (device << 56) | (cmd << 48),
+                         __ATOMIC_RELEASE);
+    } else {
+        std::clog << "[BESM] HTIF: unsupported command: device " << device
+                  << ", cmd " << cmd << std::endl;
+    }
+
+    return true;
+}
+
+RV64DWord HTIF::doSyscall(PhysMem &pMem, RV64Ptr magicMem) {
+    RV64UDWord num = pMem.loadDWord(magicMem);
+    if (num != kSyscallWrite) {
+        std::clog << "[BESM] HTIF: unsupported syscall " << num << std::endl;
+        return -ENOSYS;
+    }
+
+    RV64UDWord fd = pMem.loadDWord(magicMem + sizeof(RV64UDWord));
+    RV64Ptr buf = pMem.loadDWord(magicMem + 2 * sizeof(RV64UDWord));
+    RV64Size count = pMem.loadDWord(magicMem + 3 * sizeof(RV64UDWord));
+    if (fd != STDOUT_FILENO && fd != STDERR_FILENO) {
+        return -EBADF;
+    }
+
+    RV64Size written = 0;
+    while (written < count) {
+        auto [hostAddress, hostSize] = pMem.getHostAddress(buf + written);
+        if (hostAddress == nullptr) {
+            // Untouched RAM page, it reads as zeroes
+            static char const zeroes[256] = {};
+            hostAddress = zeroes;
+            hostSize = sizeof(zeroes);
+        }
+        RV64Size chunk = std::min(count - written, hostSize);
+        if (::write(fd, hostAddress, chunk) < 0) {
+            return written == 0 ? -errno : written;
+        }
+        written += chunk;
+    }
+
+    return written;
+}
+
+/**
+ * The registers are accessed atomically: process() may run on the thread
+ * of another hart
+ */
+template <typename DataType> DataType HTIF::load(RV64Ptr address) const {
+    this->countAccess();
+    if (address % sizeof(DataType) != 0) {
+        throw IPhysMemDevice::UnalignedAddressError("HTIF unaligned access");
+    }
+    return __atomic_load_n(
+        static_cast<DataType const *>(this->getHostAddress(address).first),
+        __ATOMIC_ACQUIRE);
+}
+
+template <typename DataType>
+void HTIF::store(RV64Ptr address, DataType value) {
+    this->countAccess();
+    if (address % sizeof(DataType) != 0) {
+        throw IPhysMemDevice::UnalignedAddressError("HTIF unaligned access");
+    }
+    __atomic_store_n(
+        static_cast<DataType *>(this->touchHostAddress(address).first), value,
+        __ATOMIC_RELEASE);
+}
+
+} // namespace besm::mem
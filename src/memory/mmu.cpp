@@ -40,6 +40,10 @@ void MMU::storeDWord(RV64Ptr address, RV64DWord value) {
     pMem_->storeDWord(paddr, value);
 }
 
+std::pair<void *, RV64Size> MMU::touchHostAddress(RV64Ptr vaddress) {
+    return pMem_->touchHostAddress(this->translateAddress(vaddress));
+}
+
 RV64Ptr MMU::translateAddress(RV64Ptr address) const { return address; }
 
 } // namespace besm::mem
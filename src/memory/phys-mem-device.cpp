@@ -2,12 +2,12 @@
 
 namespace besm::mem {
 
-IPhysMemDevice::IPhysMemDevice(Type type) : type_(type) {}
+IPhysMemDevice::IPhysMemDevice(Type type) : type_(type), accessesNum_(0) {}
 
 IPhysMemDevice::Type IPhysMemDevice::getType() const noexcept { return type_; }
 
 std::string IPhysMemDevice::getTypeName() const {
-    char const *TABLE[NUM_TYPES] = {"RAM", "UART", "TIMER"};
+    char const *TABLE[NUM_TYPES] = {"RAM", "UART", "TIMER", "HTIF"};
 
     char const *result = "Undefined";
     if (type_ < NUM_TYPES) {
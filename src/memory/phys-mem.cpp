@@ -3,10 +3,15 @@
 #include <stdexcept>
 #include <string.h>
 
+#include "besm-666/memory/clint.hpp"
+#include "besm-666/memory/htif.hpp"
 #include "besm-666/memory/phys-mem.hpp"
 #include "besm-666/memory/ram.hpp"
+#include "besm-666/memory/shared-image.hpp"
+#include "besm-666/memory/uart.hpp"
 #include "besm-666/util/elf-parser.hpp"
 #include "besm-666/util/math.hpp"
+#include "besm-666/util/tracer.hpp"
 
 namespace besm::mem {
 
@@ -69,18 +74,24 @@ std::pair<void *, size_t> PhysMem::touchHostAddress(RV64Ptr address) {
     return device->touchHostAddress(address - range.leftBorder());
 }
 
-std::pair<util::Range<RV64Ptr>, std::shared_ptr<IPhysMemDevice>>
-PhysMem::findDevice(RV64Ptr address) const {
-    if (lastAccessedRange_.contains(address)) {
-        return std::make_pair(lastAccessedRange_, lastAccessedDevice_);
+bool PhysMem::mapFile(RV64Ptr address, size_t size, int fd, size_t offset) {
+    auto [range, device] = this->findDevice(address);
+    if (device->getType() != IPhysMemDevice::RAM ||
+        address + size > range.rightBorder()) {
+        return false;
     }
+    return static_cast<RAM *>(device)->mapFile(address - range.leftBorder(),
+                                               size, fd, offset);
+}
 
-    for (auto [range, device] : devices_) {
-        if (range.contains(address)) {
-            lastAccessedRange_ = range;
-            lastAccessedDevice_ = device;
-
-            return std::make_pair(range, device);
+std::pair<util::Range<RV64Ptr>, IPhysMemDevice *>
+PhysMem::findDevice(RV64Ptr address) const {
+    // Ranges are ordered by the left border and don't intersect
+    auto itr = devices_.upper_bound(util::Range<RV64Ptr>(address, address));
+    if (itr != devices_.begin()) {
+        --itr;
+        if (itr->first.contains(address)) {
+            return std::make_pair(itr->first, itr->second.get());
         }
     }
 
@@ -103,10 +114,35 @@ std::vector<PhysMem::DeviceDescriptor> PhysMem::getDevices() const {
 PhysMemBuilder &PhysMemBuilder::mapRAM(RV64Ptr address, size_t ramSize,
                                        size_t ramPageSize,
                                        size_t ramChunkSize) {
-    std::shared_ptr<IPhysMemDevice> ram =
-        std::make_shared<RAM>(ramSize, ramPageSize, ramChunkSize);
+    util::Range<RV64Ptr> range(address, address + ramSize);
+
+    for (auto const &ram : rams_) {
+        if (Intersect(range, ram.range)) {
+            throw MappingIntersection("Invalid mapping");
+        }
+    }
+
+    rams_.push_back(RAMDescriptor{range, ramPageSize, ramChunkSize});
+
+    return *this;
+}
+
+PhysMemBuilder &PhysMemBuilder::mapHTIF(std::shared_ptr<HTIF> const &htif) {
+    this->mapDevice(htif, htif->getBaseAddress());
+
+    return *this;
+}
+
+PhysMemBuilder &PhysMemBuilder::mapUART(RV64Ptr address,
+                                        std::shared_ptr<UART> const &uart) {
+    this->mapDevice(uart, address);
+
+    return *this;
+}
 
-    this->mapDevice(ram, address);
+PhysMemBuilder &PhysMemBuilder::mapTimer(RV64Ptr address,
+                                         std::shared_ptr<CLINT> const &clint) {
+    this->mapDevice(clint, address);
 
     return *this;
 }
@@ -116,7 +152,7 @@ void PhysMemBuilder::mapDevice(std::shared_ptr<IPhysMemDevice> const &device,
     util::Range<RV64Ptr> range(address, address + device->getSize());
 
     for (auto const &device : devices_) {
-        if (range.contains(device.first)) {
+        if (Intersect(range, device.first)) {
             throw MappingIntersection("Invalid mapping");
         }
     }
@@ -124,7 +160,44 @@ void PhysMemBuilder::mapDevice(std::shared_ptr<IPhysMemDevice> const &device,
     devices_.insert(std::make_pair(range, device));
 }
 
+PhysMemBuilder &
+PhysMemBuilder::setRAMChunkPool(std::shared_ptr<RAMChunkPool> pool) {
+    ramChunkPool_ = std::move(pool);
+    return *this;
+}
+
+bool PhysMemBuilder::Intersect(util::Range<RV64Ptr> lhs,
+                               util::Range<RV64Ptr> rhs) noexcept {
+    return lhs.leftBorder() < rhs.rightBorder() &&
+           rhs.leftBorder() < lhs.rightBorder();
+}
+
 std::shared_ptr<PhysMem> PhysMemBuilder::build() {
+    PhysMemDeviceMap rams;
+
+    for (auto const &ram : rams_) {
+        RV64Ptr left = ram.range.leftBorder();
+
+        // devices_ is ordered by address, so holes are cut left to right
+        auto mapPiece = [&](RV64Ptr right) {
+            if (left < right) {
+                rams.insert(std::make_pair(
+                    util::Range<RV64Ptr>(left, right),
+                    std::make_shared<RAM>(right - left, ram.pageSize,
+                                          ram.chunkSize, ramChunkPool_)));
+            }
+        };
+        for (auto const &[range, device] : devices_) {
+            if (Intersect(range, ram.range)) {
+                mapPiece(std::max(left, range.leftBorder()));
+                left = std::max(left, range.rightBorder());
+            }
+        }
+        mapPiece(ram.range.rightBorder());
+    }
+    rams_.clear();
+
+    devices_.merge(rams);
     return std::shared_ptr<PhysMem>(new PhysMem(std::move(devices_)));
 }
 
@@ -133,9 +206,48 @@ PhysMemLoader::PhysMemLoader(std::shared_ptr<PhysMem> const &physMem)
 
 void PhysMemLoader::loadElf(std::filesystem::path const &elfPath) {
     std::unique_ptr<util::IElfParser> parser = util::createParser(elfPath);
-    for (auto const &segment : parser->getLoadableSegments()) {
+    this->loadElf(*parser);
+}
+
+void PhysMemLoader::loadElf(util::IElfParser &parser) {
+    util::TraceSpan span("phys_mem.load_elf");
+    for (auto const &segment : parser.getLoadableSegments()) {
         physMem_->storeContArea(segment.address, segment.data, segment.size);
     }
 }
 
+void PhysMemLoader::loadElf(util::IElfParser &parser,
+                            SharedImage const &image) {
+    util::TraceSpan span("phys_mem.load_elf");
+    std::vector<util::Range<RV64Ptr>> mapped;
+    for (auto const &range : image.getRanges()) {
+        if (physMem_->mapFile(range.address, range.size, image.getFd(),
+                              range.offset)) {
+            mapped.emplace_back(range.address, range.address + range.size);
+        }
+    }
+
+    // The mapped pages already hold the data, writing them would copy them
+    for (auto const &segment : parser.getLoadableSegments()) {
+        RV64Ptr left = segment.address;
+        RV64Ptr right = segment.address + segment.size;
+        auto store = [&](RV64Ptr to) {
+            if (left < to) {
+                physMem_->storeContArea(
+                    left,
+                    static_cast<char const *>(segment.data) +
+                        (left - segment.address),
+                    to - left);
+            }
+        };
+        for (auto const &range : mapped) {
+            if (range.leftBorder() < right && left < range.rightBorder()) {
+                store(std::max(left, range.leftBorder()));
+                left = std::max(left, range.rightBorder());
+            }
+        }
+        store(right);
+    }
+}
+
 } // namespace besm::mem
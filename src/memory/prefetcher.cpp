@@ -4,7 +4,8 @@
 namespace besm::mem {
 
 Prefetcher::Prefetcher(mem::MMU::SPtr mmu)
-    : mmu_(mmu), saved_(nullptr), start_(-1), len_(0) {}
+    : mmu_(mmu), saved_(nullptr), start_(-1), len_(0),
+      translationsNum_(0) {}
 
 RV64UWord Prefetcher::loadWord(RV64Ptr vaddress) {
     if (vaddress > start_ && vaddress < start_ + len_) {
@@ -13,6 +14,7 @@ RV64UWord Prefetcher::loadWord(RV64Ptr vaddress) {
         return *(saved_ + (vaddress - start_) / sizeof(RV64UWord));
     } else {
         // load address
+        ++translationsNum_;
         auto pair = mmu_->getHostAddress(vaddress);
         if (pair.second > 0) {
             start_ = vaddress;
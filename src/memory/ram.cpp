@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 #include <string.h>
@@ -7,11 +8,53 @@
 #include "besm-666/memory/mmap-wrapper.hpp"
 #include "besm-666/memory/ram.hpp"
 #include "besm-666/util/math.hpp"
+#include "besm-666/util/tracer.hpp"
 
 namespace besm::mem {
 
-RAMPageAllocator::Chunk::Chunk(size_t pageSize, size_t chunkSize)
-    : data_(nullptr), size_(0), rower_(nullptr), pageSize_(pageSize) {
+RAMChunkPool::SPtr RAMChunkPool::Create() {
+    return std::shared_ptr<RAMChunkPool>(new RAMChunkPool());
+}
+
+RAMChunkPool::~RAMChunkPool() {
+    for (auto [data, size] : chunks_) {
+        besm666_munmap(data, size);
+    }
+}
+
+char *RAMChunkPool::take(size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(chunks_.begin(), chunks_.end(),
+                           [size](auto const &chunk) {
+                               return chunk.second == size;
+                           });
+    if (it == chunks_.end()) {
+        return nullptr;
+    }
+
+    char *data = it->first;
+    *it = chunks_.back();
+    chunks_.pop_back();
+    return data;
+}
+
+void RAMChunkPool::give(char *data, size_t size, size_t used) {
+    // Zeroed by the releasing thread, out of the lock
+    memset(data, 0, std::min(used, size));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    chunks_.emplace_back(data, size);
+}
+
+size_t RAMChunkPool::getChunksNum() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return chunks_.size();
+}
+
+RAMPageAllocator::Chunk::Chunk(size_t pageSize, size_t chunkSize,
+                               RAMChunkPool *pool)
+    : data_(nullptr), size_(0), rower_(nullptr), pageSize_(pageSize),
+      pool_(pool) {
     assert(chunkSize != 0);
     assert(pageSize != 0);
     assert(Is2Pow(pageSize));
@@ -20,8 +63,11 @@ RAMPageAllocator::Chunk::Chunk(size_t pageSize, size_t chunkSize)
     size_t hostPageSize = getpagesize();
     size_t hostMmapSize = Nearest2PowDivident(chunkSize, hostPageSize);
 
-    void *data = besm666_mmap(nullptr, hostMmapSize, PROT_READ | PROT_WRITE,
-                              MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+    void *data = pool_ == nullptr ? nullptr : pool_->take(hostMmapSize);
+    if (data == nullptr) {
+        data = besm666_mmap(nullptr, hostMmapSize, PROT_READ | PROT_WRITE,
+                            MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+    }
 
     if (data == nullptr) {
         throw std::bad_alloc();
@@ -33,16 +79,22 @@ RAMPageAllocator::Chunk::Chunk(size_t pageSize, size_t chunkSize)
 }
 
 RAMPageAllocator::Chunk::Chunk(Chunk &&other) noexcept
-    : data_(nullptr), rower_(nullptr), size_(0), pageSize_(0) {
+    : data_(nullptr), rower_(nullptr), size_(0), pageSize_(0),
+      pool_(nullptr) {
     std::swap(other.data_, data_);
     std::swap(other.rower_, rower_);
     std::swap(other.size_, size_);
     std::swap(other.pageSize_, pageSize_);
+    std::swap(other.pool_, pool_);
 }
 
 RAMPageAllocator::Chunk::~Chunk() {
     if (data_ != nullptr) {
-        besm666_munmap(data_, size_);
+        if (pool_ != nullptr) {
+            pool_->give(data_, size_, rower_ - data_);
+        } else {
+            besm666_munmap(data_, size_);
+        }
         data_ = rower_ = nullptr;
         size_ = pageSize_ = 0;
     }
@@ -58,8 +110,9 @@ void *RAMPageAllocator::Chunk::allocPage() noexcept {
     }
 }
 
-RAMPageAllocator::RAMPageAllocator(size_t pageSize, size_t chunkSize)
-    : chunkSize_(chunkSize), pageSize_(pageSize) {
+RAMPageAllocator::RAMPageAllocator(size_t pageSize, size_t chunkSize,
+                                   RAMChunkPool::SPtr pool)
+    : chunkSize_(chunkSize), pageSize_(pageSize), pool_(std::move(pool)) {
     assert(chunkSize != 0);
     assert(pageSize != 0);
     assert(Is2Pow(pageSize));
@@ -67,22 +120,25 @@ RAMPageAllocator::RAMPageAllocator(size_t pageSize, size_t chunkSize)
 }
 
 RAMPageAllocator::RAMPageAllocator(RAMPageAllocator &&other) noexcept
-    : chunks_(std::move(other.chunks_)), chunkSize_(other.chunkSize_),
-      pageSize_(other.pageSize_) {}
+    : chunkSize_(other.chunkSize_), pageSize_(other.pageSize_),
+      pool_(std::move(other.pool_)), chunks_(std::move(other.chunks_)) {}
 
 void *RAMPageAllocator::allocPage() {
     void *page = chunks_.empty() ? nullptr : chunks_.back().allocPage();
     if (page == nullptr) {
-        chunks_.emplace_back(pageSize_, chunkSize_);
+        chunks_.emplace_back(pageSize_, chunkSize_, pool_.get());
         return chunks_.back().allocPage();
     } else {
         return page;
     }
 }
 
-RAM::RAM(size_t ramSize, size_t pageSize, size_t chunkSize)
+RAM::RAM(size_t ramSize, size_t pageSize, size_t chunkSize,
+         RAMChunkPool::SPtr pool)
     : IPhysMemDevice(IPhysMemDevice::RAM), ramSize_(ramSize),
-      pageSize_(pageSize), allocator_(pageSize, chunkSize) {
+      pageSize_(pageSize), allocator_(pageSize, chunkSize, std::move(pool)),
+      pagesTouched_(0),
+      firstTouches_("ram.first_touch", "pages", kTraceBurstGap) {
 
     if (ramSize == 0) {
         throw std::invalid_argument("Invalid RAM size");
@@ -93,12 +149,26 @@ RAM::RAM(size_t ramSize, size_t pageSize, size_t chunkSize)
     if (chunkSize / pageSize == 0) {
         throw std::invalid_argument("Invalid RAM chunk size");
     }
+
+    size_t pagesNum = (ramSize - 1) / pageSize + 1;
+    directory_.reset(new std::atomic<std::atomic<char *> *>[
+        (pagesNum - 1) / kPageTableSize + 1]());
 }
 
 RAM::RAM(RAM &&other)
     : IPhysMemDevice(other.getType()), ramSize_(other.ramSize_),
       pageSize_(other.pageSize_), allocator_(std::move(other.allocator_)),
-      pagemap_(std::move(other.pagemap_)) {}
+      directory_(std::move(other.directory_)),
+      pageTables_(std::move(other.pageTables_)),
+      fileMappings_(std::move(other.fileMappings_)),
+      pagesTouched_(other.pagesTouched_.load(std::memory_order_relaxed)),
+      firstTouches_("ram.first_touch", "pages", kTraceBurstGap) {}
+
+RAM::~RAM() {
+    for (auto [data, size] : fileMappings_) {
+        besm666_munmap(data, size);
+    }
+}
 
 RV64UChar RAM::loadByte(RV64Ptr address) const {
     return this->load<RV64UChar>(address);
@@ -135,50 +205,116 @@ std::pair<void const *, size_t> RAM::getHostAddress(RV64Ptr address) const {
     }
 
     return std::make_pair(reinterpret_cast<char const *>(hostAddress) + offset,
-                          pageSize_ - offset);
+                          this->getSpanSize(address, offset));
 }
 
 std::pair<void *, size_t> RAM::touchHostAddress(RV64Ptr address) {
     size_t offset = this->getPageOffset(address);
     return std::make_pair(
         reinterpret_cast<char *>(this->touchPageAddress(address)) + offset,
-        pageSize_ - offset);
+        this->getSpanSize(address, offset));
 }
 
 size_t RAM::getSize() const noexcept { return ramSize_; }
 
-bool operator<(RAM::Page left, RAM::Page right) noexcept {
-    return left.id < right.id;
+size_t RAM::getChunksNum() const {
+    std::lock_guard<std::mutex> lock(allocationMutex_);
+    return allocator_.getChunksNum();
 }
-bool operator<(RAM::Page left, RAM::PageId right) noexcept {
-    return left.id < right;
+
+bool RAM::mapFile(RV64Ptr address, size_t size, int fd, size_t offset) {
+    size_t hostPageSize = getpagesize();
+    if (pageSize_ % hostPageSize != 0 || address % pageSize_ != 0 ||
+        size % pageSize_ != 0 || offset % hostPageSize != 0 || size == 0 ||
+        address + size > ramSize_) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(allocationMutex_);
+
+    PageId first = this->getPageId(address);
+    PageId last = this->getPageId(address + size - 1);
+    for (PageId pageId = first; pageId <= last; ++pageId) {
+        std::atomic<char *> *entry = this->findPageEntry(pageId);
+        if (entry != nullptr &&
+            entry->load(std::memory_order_relaxed) != nullptr) {
+            return false;
+        }
+    }
+
+    void *data = besm666_mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE, fd, offset);
+    if (data == MAP_FAILED || data == nullptr) {
+        return false;
+    }
+    fileMappings_.emplace_back(reinterpret_cast<char *>(data), size);
+
+    char *page = reinterpret_cast<char *>(data);
+    for (PageId pageId = first; pageId <= last; ++pageId) {
+        std::atomic<std::atomic<char *> *> &tableEntry =
+            directory_[pageId / kPageTableSize];
+        std::atomic<char *> *table =
+            tableEntry.load(std::memory_order_relaxed);
+        if (table == nullptr) {
+            pageTables_.emplace_back(
+                new std::atomic<char *>[kPageTableSize]());
+            table = pageTables_.back().get();
+            tableEntry.store(table, std::memory_order_release);
+        }
+        table[pageId % kPageTableSize].store(page, std::memory_order_release);
+        page += pageSize_;
+    }
+    pagesTouched_.fetch_add(last - first + 1, std::memory_order_relaxed);
+    return true;
 }
-bool operator<(RAM::PageId left, RAM::Page right) noexcept {
-    return left < right.id;
+
+std::atomic<char *> *RAM::findPageEntry(PageId pageId) const noexcept {
+    std::atomic<char *> *table =
+        directory_[pageId / kPageTableSize].load(std::memory_order_acquire);
+    return table == nullptr ? nullptr : &table[pageId % kPageTableSize];
 }
 
 void const *RAM::getPageAddress(RV64Ptr address) const noexcept {
-    auto itr = pagemap_.find(this->getPageId(address));
-    if (itr == pagemap_.end()) {
-        return nullptr;
-    } else {
-        return itr->mem;
-    }
+    std::atomic<char *> *entry =
+        this->findPageEntry(this->getPageId(address));
+    return entry == nullptr ? nullptr
+                            : entry->load(std::memory_order_acquire);
 }
 
 void *RAM::touchPageAddress(RV64Ptr address) {
     PageId pageId = this->getPageId(address);
-    auto itr = pagemap_.find(pageId);
-
-    if (itr == pagemap_.end()) {
-        void *newPageAddress = allocator_.allocPage();
-        Page newPage = {.id = pageId,
-                        .mem = reinterpret_cast<char *>(newPageAddress)};
-        pagemap_.insert(newPage);
-        return newPageAddress;
-    } else {
-        return itr->mem;
+
+    std::atomic<char *> *entry = this->findPageEntry(pageId);
+    if (entry != nullptr) {
+        if (char *page = entry->load(std::memory_order_acquire)) {
+            return page;
+        }
     }
+
+    // Slow path, another hart may have allocated the page meanwhile
+    std::lock_guard<std::mutex> lock(allocationMutex_);
+
+    std::atomic<std::atomic<char *> *> &tableEntry =
+        directory_[pageId / kPageTableSize];
+    std::atomic<char *> *table = tableEntry.load(std::memory_order_relaxed);
+    if (table == nullptr) {
+        pageTables_.emplace_back(new std::atomic<char *>[kPageTableSize]());
+        table = pageTables_.back().get();
+        tableEntry.store(table, std::memory_order_release);
+    }
+
+    entry = &table[pageId % kPageTableSize];
+    char *page = entry->load(std::memory_order_relaxed);
+    if (page == nullptr) {
+        uint64_t start = util::Tracer::Enabled() ? util::Tracer::Now() : 0;
+        page = reinterpret_cast<char *>(allocator_.allocPage());
+        entry->store(page, std::memory_order_release);
+        pagesTouched_.fetch_add(1, std::memory_order_relaxed);
+        if (start != 0) {
+            firstTouches_.add(start, util::Tracer::Now());
+        }
+    }
+    return page;
 }
 
 void RAM::validateAddressBounds(RV64Ptr address) const {
@@ -193,5 +329,10 @@ RAM::PageId RAM::getPageId(RV64Ptr address) const noexcept {
 size_t RAM::getPageOffset(RV64Ptr address) const noexcept {
     return static_cast<size_t>(address) % pageSize_;
 }
+size_t RAM::getSpanSize(RV64Ptr address, size_t offset) const noexcept {
+    // RAM size may be not a multiple of the page size when a device is
+    // mapped over a part of RAM range
+    return std::min(pageSize_ - offset, ramSize_ - address);
+}
 
 } // namespace besm::mem
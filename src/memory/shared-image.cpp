@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <mutex>
+#include <sys/mman.h>
+#include <tuple>
+#include <unistd.h>
+#include <utility>
+
+#include "besm-666/memory/shared-image.hpp"
+
+namespace besm::mem {
+
+SharedImage::SPtr SharedImage::Get(util::IElfParser &elf, uint64_t imageHash,
+                                   size_t pageSize) {
+    // The shared pages depend on the segment bounds in memory as well, the
+    // hash may only cover the loaded bytes
+    using Layout = std::vector<std::tuple<RV64Ptr, RV64Size, bool>>;
+    using Key = std::tuple<uint64_t, size_t, Layout>;
+    static std::mutex mutex;
+    static std::map<Key, std::weak_ptr<SharedImage>> images;
+
+    Layout layout;
+    for (auto const &segment : elf.getLoadableSegments()) {
+        layout.emplace_back(segment.address, segment.memSize, segment.writable);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Images no machine holds any more
+    for (auto it = images.begin(); it != images.end();) {
+        it = it->second.expired() ? images.erase(it) : std::next(it);
+    }
+
+    std::weak_ptr<SharedImage> &cached =
+        images[Key{imageHash, pageSize, std::move(layout)}];
+    SPtr image = cached.lock();
+    if (image == nullptr) {
+        image = Build(elf, pageSize);
+        cached = image;
+    }
+    return image;
+}
+
+SharedImage::~SharedImage() { close(fd_); }
+
+SharedImage::SPtr SharedImage::Build(util::IElfParser &elf, size_t pageSize) {
+#ifdef __linux__
+    using PageId = RV64Ptr;
+    auto const &segments = elf.getLoadableSegments();
+
+    std::vector<PageId> pages;
+    for (auto const &segment : segments) {
+        if (!segment.writable && segment.memSize != 0) {
+            for (PageId page = segment.address / pageSize;
+                 page <= (segment.address + segment.memSize - 1) / pageSize;
+                 ++page) {
+                pages.push_back(page);
+            }
+        }
+    }
+    std::sort(pages.begin(), pages.end());
+    pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+    pages.erase(std::remove_if(pages.begin(), pages.end(),
+                               [&](PageId page) {
+                                   RV64Ptr left = page * pageSize;
+                                   return std::any_of(
+                                       segments.begin(), segments.end(),
+                                       [&](auto const &segment) {
+                                           return segment.writable &&
+                                                  segment.address <
+                                                      left + pageSize &&
+                                                  left < segment.address +
+                                                             segment.memSize;
+                                       });
+                               }),
+                pages.end());
+    if (pages.empty()) {
+        return nullptr;
+    }
+
+    int fd = memfd_create("besm666-image", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        return nullptr;
+    }
+    if (ftruncate(fd, pages.size() * pageSize) != 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    std::vector<Range> ranges;
+    std::vector<char> buffer(pageSize);
+    for (size_t i = 0; i < pages.size(); ++i) {
+        RV64Ptr left = pages[i] * pageSize;
+
+        std::fill(buffer.begin(), buffer.end(), 0);
+        for (auto const &segment : segments) {
+            RV64Ptr from = std::max(left, segment.address);
+            RV64Ptr to = std::min(left + pageSize,
+                                  segment.address + segment.size);
+            if (from < to) {
+                memcpy(buffer.data() + (from - left),
+                       static_cast<char const *>(segment.data) +
+                           (from - segment.address),
+                       to - from);
+            }
+        }
+        if (pwrite(fd, buffer.data(), pageSize, i * pageSize) !=
+            static_cast<ssize_t>(pageSize)) {
+            close(fd);
+            return nullptr;
+        }
+
+        if (!ranges.empty() &&
+            ranges.back().address + ranges.back().size == left) {
+            ranges.back().size += pageSize;
+        } else {
+            ranges.push_back(Range{left, i * pageSize, pageSize});
+        }
+    }
+
+    // The instances only map the file privately, so it is never written
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE);
+
+    return std::shared_ptr<SharedImage>(new SharedImage(fd, std::move(ranges)));
+#else
+    return nullptr;
+#endif
+}
+
+} // namespace besm::mem
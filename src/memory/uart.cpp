@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <unistd.h>
+
+#include "besm-666/memory/uart.hpp"
+#include "besm-666/util/tracer.hpp"
+
+namespace besm::mem {
+
+UART::SPtr UART::Create(std::filesystem::path const &inputPath) {
+    return std::shared_ptr<UART>(new UART(inputPath));
+}
+
+UART::UART(std::filesystem::path const &inputPath)
+    : IPhysMemDevice(IPhysMemDevice::UART), inputFd_(STDIN_FILENO),
+      ownsInput_(false), ier_(0), fcr_(0), lcr_(0), mcr_(0),
+      scr_(0), dll_(0), dlm_(0), rbr_(0), rbrValid_(false), mip_(nullptr),
+      started_(false), startedPid_(0), direct_(false), rxPolled_(false),
+      stop_(false), writerIdle_(false) {
+    if (!inputPath.empty()) {
+        inputFd_ = ::open(inputPath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (inputFd_ < 0) {
+            throw std::invalid_argument("Can't open UART input " +
+                                        inputPath.string());
+        }
+        ownsInput_ = true;
+    }
+}
+
+UART::~UART() {
+    if (started_) {
+        stop_.store(true, std::memory_order_release);
+        wakeUp_.notify_one();
+
+        if (startedPid_ == ::getpid()) {
+            writer_.join();
+            if (reader_.joinable()) {
+                reader_.join();
+            }
+        } else {
+            // Forked after the threads were started, they don't exist here
+            this->releaseThreads();
+
+            char buffer[kBatchSize];
+            while (size_t count = tx_.pop(buffer, sizeof(buffer))) {
+                ::write(STDOUT_FILENO, buffer, count);
+            }
+        }
+    }
+
+    if (ownsInput_) {
+        ::close(inputFd_);
+    }
+}
+
+RV64UChar UART::loadByte(RV64Ptr address) const {
+    // Reads of RBR pop the RX queue
+    UART *self = const_cast<UART *>(this);
+    std::lock_guard<std::mutex> lock(self->guestMutex_);
+    RV64UChar value = self->readRegister(address);
+    self->updateInterrupt();
+    return value;
+}
+RV64UHWord UART::loadHWord(RV64Ptr address) const {
+    return this->loadByte(address);
+}
+RV64UWord UART::loadWord(RV64Ptr address) const {
+    return this->loadByte(address);
+}
+RV64UDWord UART::loadDWord(RV64Ptr address) const {
+    return this->loadByte(address);
+}
+
+void UART::storeByte(RV64Ptr address, RV64UChar value) {
+    this->writeRegister(address, value);
+}
+void UART::storeHWord(RV64Ptr address, RV64UHWord value) {
+    this->writeRegister(address, static_cast<RV64UChar>(value));
+}
+void UART::storeWord(RV64Ptr address, RV64UWord value) {
+    this->writeRegister(address, static_cast<RV64UChar>(value));
+}
+void UART::storeDWord(RV64Ptr address, RV64UDWord value) {
+    this->writeRegister(address, static_cast<RV64UChar>(value));
+}
+
+std::pair<void const *, size_t> UART::getHostAddress(RV64Ptr) const {
+    return std::make_pair(nullptr, 0);
+}
+std::pair<void *, size_t> UART::touchHostAddress(RV64Ptr) {
+    return std::make_pair(nullptr, 0);
+}
+
+size_t UART::getSize() const noexcept { return kSize; }
+
+RV64UChar UART::readRegister(RV64Ptr address) {
+    this->countAccess();
+    this->start();
+
+    switch (address) {
+    case RBR_THR_DLL:
+        if (lcr_ & kLCRDivisorLatch) {
+            return dll_;
+        }
+        if (this->dataReady()) {
+            rbrValid_ = false;
+            return rbr_;
+        }
+        return 0;
+    case IER_DLM:
+        return (lcr_ & kLCRDivisorLatch) ? dlm_
+                                         : ier_.load(std::memory_order_relaxed);
+    case IIR_FCR: {
+        RV64UChar ier = ier_.load(std::memory_order_relaxed);
+        RV64UChar fifo = (fcr_ & kFCREnable) ? 0xC0 : 0x00;
+        if ((ier & kIERRxAvailable) && this->dataReady()) {
+            return fifo | 0x04;
+        }
+        if (ier & kIERTxEmpty) {
+            return fifo | 0x02;
+        }
+        return fifo | 0x01;
+    }
+    case LCR:
+        return lcr_;
+    case MCR:
+        return mcr_;
+    case LSR:
+        return kLSRTxEmpty | (this->dataReady() ? kLSRDataReady : 0);
+    case MSR:
+        return kMSRConnected;
+    case SCR:
+        return scr_;
+    default:
+        throw IPhysMemDevice::InvalidAddressError("UART out of bounds");
+    }
+}
+
+void UART::writeRegister(RV64Ptr address, RV64UChar value) {
+    this->countAccess();
+    std::lock_guard<std::mutex> lock(guestMutex_);
+    this->start();
+
+    switch (address) {
+    case RBR_THR_DLL:
+        if (lcr_ & kLCRDivisorLatch) {
+            dll_ = value;
+        } else {
+            this->transmit(static_cast<char>(value));
+        }
+        break;
+    case IER_DLM:
+        if (lcr_ & kLCRDivisorLatch) {
+            dlm_ = value;
+        } else {
+            ier_.store(value & 0x0F, std::memory_order_release);
+            if (value & kIERRxAvailable) {
+                this->startReader();
+            }
+        }
+        break;
+    case IIR_FCR:
+        fcr_ = value;
+        if (value & 0x02) {
+            // RX FIFO reset, the bytes queued by the reader are dropped too
+            char buffer[kBatchSize];
+            while (rx_.pop(buffer, sizeof(buffer)) != 0) {
+            }
+            rbrValid_ = false;
+        }
+        break;
+    case LCR:
+        lcr_ = value;
+        break;
+    case MCR:
+        mcr_ = value;
+        break;
+    case SCR:
+        scr_ = value;
+        break;
+    case LSR:
+    case MSR:
+        break;
+    default:
+        throw IPhysMemDevice::InvalidAddressError("UART out of bounds");
+    }
+
+    this->updateInterrupt();
+}
+
+void UART::updateInterrupt() {
+    if (mip_ == nullptr) {
+        return;
+    }
+
+    RV64UChar ier = ier_.load(std::memory_order_relaxed);
+    if ((ier & kIERTxEmpty) || ((ier & kIERRxAvailable) && this->dataReady())) {
+        mip_->raise(MIP_MEIP);
+        return;
+    }
+
+    mip_->clear(MIP_MEIP);
+    // The reader may have queued data and raised MEIP right before the clear
+    if ((ier & kIERRxAvailable) && this->dataReady()) {
+        mip_->raise(MIP_MEIP);
+    }
+}
+
+void UART::start() {
+    if (started_) {
+        return;
+    }
+    started_ = true;
+    startedPid_ = ::getpid();
+
+    writer_ = std::thread(&UART::writerLoop, this);
+    if (ownsInput_) {
+        this->startReader();
+    }
+}
+
+void UART::startReader() {
+    if (direct_) {
+        rxPolled_ = true;
+    } else if (!reader_.joinable()) {
+        reader_ = std::thread(&UART::readerLoop, this);
+    }
+}
+
+void UART::afterFork() {
+    if (!started_ || startedPid_ == ::getpid()) {
+        return;
+    }
+
+    direct_ = true;
+    rxPolled_ = reader_.joinable();
+    this->releaseThreads();
+
+    // The bytes the parent writer has not taken yet
+    char buffer[kBatchSize];
+    while (size_t count = tx_.pop(buffer, sizeof(buffer))) {
+        ::write(STDOUT_FILENO, buffer, count);
+    }
+}
+
+void UART::releaseThreads() {
+    // Intentionally leaked, the handles are never joined nor detached
+    if (writer_.joinable()) {
+        new std::thread(std::move(writer_));
+    }
+    if (reader_.joinable()) {
+        new std::thread(std::move(reader_));
+    }
+}
+
+void UART::transmit(char c) {
+    if (direct_) {
+        while (::write(STDOUT_FILENO, &c, 1) < 0 && errno == EINTR) {
+        }
+        return;
+    }
+
+    while (!tx_.push(c)) {
+        wakeUp_.notify_one();
+        std::this_thread::yield();
+    }
+
+    if (writerIdle_.load(std::memory_order_relaxed)) {
+        wakeUp_.notify_one();
+    }
+}
+
+bool UART::dataReady() {
+    if (!rbrValid_ && rxPolled_ && rx_.empty()) {
+        this->pollInput();
+    }
+    if (!rbrValid_) {
+        rbrValid_ = rx_.pop(&rbr_, 1) != 0;
+    }
+    return rbrValid_;
+}
+
+void UART::pollInput() {
+    pollfd pfd = {.fd = inputFd_, .events = POLLIN, .revents = 0};
+    if (::poll(&pfd, 1, 0) <= 0) {
+        return;
+    }
+
+    char c;
+    if (::read(inputFd_, &c, 1) == 1) {
+        rx_.push(c);
+    }
+}
+
+void UART::writerLoop() {
+    util::Tracer::SetThreadName("uart writer");
+    char buffer[kBatchSize];
+
+    while (true) {
+        bool stopping = stop_.load(std::memory_order_acquire);
+
+        size_t count = tx_.pop(buffer, sizeof(buffer));
+        uint64_t start =
+            count != 0 && util::Tracer::Enabled() ? util::Tracer::Now() : 0;
+        for (size_t written = 0; written < count;) {
+            ssize_t result =
+                ::write(STDOUT_FILENO, buffer + written, count - written);
+            if (result < 0 && errno != EINTR && errno != EAGAIN) {
+                std::clog << "[BESM] UART: output error, errno " << errno
+                          << std::endl;
+                break;
+            }
+            written += std::max<ssize_t>(result, 0);
+        }
+        if (start != 0) {
+            util::Tracer::Record("uart.write", start, util::Tracer::Now(),
+                                 "bytes", count);
+        }
+        if (count != 0) {
+            continue;
+        }
+        if (stopping) {
+            return;
+        }
+
+        // The guest notifies only an idle writer, the timeout covers a
+        // notification racing with going idle
+        std::unique_lock<std::mutex> lock(mutex_);
+        writerIdle_.store(true, std::memory_order_seq_cst);
+        wakeUp_.wait_for(lock, kIdleTimeout, [this] {
+            return !tx_.empty() || stop_.load(std::memory_order_acquire);
+        });
+        writerIdle_.store(false, std::memory_order_relaxed);
+    }
+}
+
+void UART::readerLoop() {
+    util::Tracer::SetThreadName("uart reader");
+    char buffer[kBatchSize];
+
+    while (!stop_.load(std::memory_order_acquire)) {
+        pollfd pfd = {.fd = inputFd_, .events = POLLIN, .revents = 0};
+        if (::poll(&pfd, 1, kIdleTimeout.count()) <= 0) {
+            continue;
+        }
+
+        uint64_t start = util::Tracer::Enabled() ? util::Tracer::Now() : 0;
+        ssize_t count = ::read(inputFd_, buffer, sizeof(buffer));
+        if (count == 0) {
+            return;
+        }
+        if (count < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        for (ssize_t i = 0; i < count; ++i) {
+            while (!rx_.push(buffer[i])) {
+                if (stop_.load(std::memory_order_acquire)) {
+                    return;
+                }
+                std::this_thread::sleep_for(kIdleTimeout);
+            }
+        }
+
+        if (mip_ != nullptr &&
+            (ier_.load(std::memory_order_acquire) & kIERRxAvailable)) {
+            mip_->raise(MIP_MEIP);
+        }
+        if (start != 0) {
+            util::Tracer::Record("uart.read", start, util::Tracer::Now(),
+                                 "bytes", count);
+        }
+    }
+}
+
+} // namespace besm::mem
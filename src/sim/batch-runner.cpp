@@ -0,0 +1,305 @@
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include "besm-666/sim/batch-runner.hpp"
+#include "besm-666/sim/machine.hpp"
+
+namespace besm::sim {
+
+namespace {
+
+char const *StatusName(BatchRunner::Status status) {
+    switch (status) {
+    case BatchRunner::STATUS_EXITED:
+        return "exited";
+    case BatchRunner::STATUS_STOPPED:
+        return "stopped";
+    case BatchRunner::STATUS_BUDGET:
+        return "budget";
+    case BatchRunner::STATUS_TIMEOUT:
+        return "timeout";
+    case BatchRunner::STATUS_ERROR:
+        return "error";
+    }
+    return "error";
+}
+
+void WriteJSONString(std::ostream &output, std::string const &string) {
+    output << '"';
+    for (unsigned char c : string) {
+        switch (c) {
+        case '"':
+            output << "\\\"";
+            break;
+        case '\\':
+            output << "\\\\";
+            break;
+        case '\n':
+            output << "\\n";
+            break;
+        default:
+            if (c < 0x20) {
+                output << "\\u" << std::hex << std::setw(4)
+                       << std::setfill('0') << static_cast<int>(c) << std::dec
+                       << std::setfill(' ');
+            } else {
+                output << c;
+            }
+        }
+    }
+    output << '"';
+}
+
+util::Range<RV64Ptr> ParseRAMRange(std::string const &string) {
+    size_t comma = string.find(',');
+    if (comma == std::string::npos) {
+        throw std::invalid_argument("RAM range must be 'address,size'");
+    }
+    RV64Ptr address = std::stoull(string.substr(0, comma), nullptr, 0);
+    RV64Size size = std::stoull(string.substr(comma + 1), nullptr, 0);
+    return util::Range<RV64Ptr>(address, address + size);
+}
+
+} // namespace
+
+std::vector<BatchRunner::Job> BatchRunner::ParseManifest(std::istream &manifest) {
+    std::vector<Job> jobs;
+
+    std::string line;
+    for (size_t lineNum = 1; std::getline(manifest, line); ++lineNum) {
+        std::istringstream tokens(line);
+        std::string token;
+        if (!(tokens >> token) || token.front() == '#') {
+            continue;
+        }
+
+        Job job;
+        job.executablePath = token;
+        try {
+            while (tokens >> token) {
+                if (token == "--") {
+                    while (tokens >> token) {
+                        job.guestArgs.push_back(token);
+                    }
+                    break;
+                }
+                if (token == "user-mode") {
+                    job.userMode = true;
+                    continue;
+                }
+
+                size_t equals = token.find('=');
+                if (equals == std::string::npos) {
+                    throw std::invalid_argument("unknown option " + token);
+                }
+                std::string key = token.substr(0, equals);
+                std::string value = token.substr(equals + 1);
+
+                if (key == "ram") {
+                    job.ramRanges.push_back(ParseRAMRange(value));
+                } else if (key == "ram-page-size") {
+                    job.ramPageSize = std::stoull(value, nullptr, 0);
+                } else if (key == "ram-chunk-size") {
+                    job.ramChunkSize = std::stoull(value, nullptr, 0);
+                } else if (key == "max-instrs") {
+                    job.maxInstrs = std::stoull(value, nullptr, 0);
+                } else if (key == "timeout") {
+                    job.timeout = std::chrono::duration<double>(std::stod(value));
+                } else {
+                    throw std::invalid_argument("unknown option " + key);
+                }
+            }
+        } catch (std::exception const &error) {
+            throw InvalidConfiguration("Manifest line " +
+                                       std::to_string(lineNum) + ": " +
+                                       error.what());
+        }
+
+        jobs.push_back(std::move(job));
+    }
+
+    return jobs;
+}
+
+void BatchRunner::WriteResults(std::ostream &output,
+                               std::vector<Job> const &jobs,
+                               std::vector<Result> const &results) {
+    output << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        Result const &result = results[i];
+        double seconds = result.runTime.count();
+
+        output << "  {\"executable\": ";
+        WriteJSONString(output, jobs[i].executablePath.string());
+        output << ", \"status\": \"" << StatusName(result.status) << '"';
+        if (result.exitCode.has_value()) {
+            output << ", \"exit_code\": " << *result.exitCode;
+        }
+        output << ", \"instructions\": " << result.instrsExecuted
+               << ", \"seconds\": " << seconds << ", \"mips\": "
+               << (seconds > 0 ? result.instrsExecuted * 1e-6 / seconds : 0);
+        if (!result.error.empty()) {
+            output << ", \"error\": ";
+            WriteJSONString(output, result.error);
+        }
+        output << (i + 1 == results.size() ? "}\n" : "},\n");
+    }
+    output << "]" << std::endl;
+}
+
+BatchRunner::BatchRunner(ConfigBuilder const &base, size_t numThreads)
+    : base_(base), numThreads_(numThreads),
+      ramChunkPool_(mem::RAMChunkPool::Create()), finished_(false) {
+    if (numThreads_ == 0) {
+        throw InvalidConfiguration("Invalid batch threads number");
+    }
+
+    // Every job sets the executable, the rest is checked before any runs
+    ConfigBuilder probe = base_;
+    probe.setExecutablePath("job");
+    Config config = probe.build();
+    if (config.numHarts() != 1) {
+        throw InvalidConfiguration("Batch jobs support a single hart only");
+    }
+    // The jobs share the process streams: their setup isn't logged and a
+    // UART reads no input unless the base names a file
+    base_.setVerbose(false);
+    if (config.uartAddress().has_value() && config.uartInputPath().empty()) {
+        base_.setUartInputPath("/dev/null");
+    }
+
+    slots_.reset(new Slot[numThreads_]);
+}
+
+std::vector<BatchRunner::Result>
+BatchRunner::run(std::vector<Job> const &jobs) {
+    std::vector<Result> results(jobs.size());
+    std::atomic<size_t> nextJob{0};
+
+    finished_.store(false, std::memory_order_relaxed);
+    std::thread watchdog(&BatchRunner::watchdogLoop, this);
+
+    std::vector<std::thread> threads;
+    for (size_t threadId = 0; threadId < numThreads_; ++threadId) {
+        threads.emplace_back([&, threadId] {
+            for (size_t job = nextJob++; job < jobs.size(); job = nextJob++) {
+                results[job] = this->runJob(jobs[job], slots_[threadId]);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    finished_.store(true, std::memory_order_relaxed);
+    watchdog.join();
+
+    return results;
+}
+
+Config BatchRunner::makeConfig(Job const &job) const {
+    ConfigBuilder builder = base_;
+    builder.setExecutablePath(job.executablePath);
+    for (auto const &arg : job.guestArgs) {
+        builder.addGuestArg(arg);
+    }
+    if (!job.ramRanges.empty()) {
+        builder.clearRamRanges();
+        for (auto range : job.ramRanges) {
+            builder.addRamRange(range);
+        }
+    }
+    if (job.ramPageSize.has_value()) {
+        builder.setRamPageSize(*job.ramPageSize);
+    }
+    if (job.ramChunkSize.has_value()) {
+        builder.setRamChunkSize(*job.ramChunkSize);
+    }
+    if (job.userMode) {
+        builder.setUserMode(true);
+    }
+    return builder.build();
+}
+
+BatchRunner::Result BatchRunner::runJob(Job const &job, Slot &slot) {
+    Result result;
+
+    try {
+        Machine machine(this->makeConfig(job), ramChunkPool_);
+
+        {
+            std::lock_guard<std::mutex> lock(slot.mutex);
+            slot.machine = &machine;
+            slot.timedOut = false;
+            slot.deadline =
+                job.timeout.has_value()
+                    ? std::chrono::steady_clock::now() +
+                          std::chrono::duration_cast<
+                              std::chrono::steady_clock::duration>(
+                              *job.timeout)
+                    : std::chrono::steady_clock::time_point::max();
+        }
+
+        bool stopped = true;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            if (job.maxInstrs.has_value()) {
+                stopped = machine.runFor(*job.maxInstrs);
+            } else {
+                machine.run();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(slot.mutex);
+            slot.machine = nullptr;
+            throw;
+        }
+        result.runTime = std::chrono::steady_clock::now() - start;
+
+        bool timedOut;
+        {
+            std::lock_guard<std::mutex> lock(slot.mutex);
+            slot.machine = nullptr;
+            timedOut = slot.timedOut;
+        }
+
+        result.instrsExecuted = machine.getInstrsExecuted();
+        result.exitCode = machine.getExitCode();
+        if (result.exitCode.has_value()) {
+            result.status = STATUS_EXITED;
+        } else if (timedOut) {
+            result.status = STATUS_TIMEOUT;
+        } else if (!stopped) {
+            result.status = STATUS_BUDGET;
+        } else {
+            result.status = STATUS_STOPPED;
+        }
+    } catch (std::exception const &error) {
+        result.status = STATUS_ERROR;
+        result.error = error.what();
+    } catch (...) {
+        result.status = STATUS_ERROR;
+        result.error = "unknown exception";
+    }
+
+    return result;
+}
+
+void BatchRunner::watchdogLoop() {
+    while (!finished_.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_for(kWatchdogPeriod);
+
+        auto now = std::chrono::steady_clock::now();
+        for (size_t threadId = 0; threadId < numThreads_; ++threadId) {
+            Slot &slot = slots_[threadId];
+            std::lock_guard<std::mutex> lock(slot.mutex);
+            if (slot.machine != nullptr && !slot.timedOut &&
+                now >= slot.deadline) {
+                slot.machine->requestStop();
+                slot.timedOut = true;
+            }
+        }
+    }
+}
+
+} // namespace besm::sim
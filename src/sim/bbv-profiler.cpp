@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "besm-666/exec/gprf.hpp"
+#include "besm-666/memory/ram.hpp"
+#include "besm-666/sim/bbv-profiler.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/util/tracer.hpp"
+
+namespace besm::sim {
+
+BBVProfiler::BBVProfiler(std::ostream &output, size_t intervalSize)
+    : output_(output), intervalSize_(intervalSize), intervalEnd_(intervalSize),
+      interval_(0), started_(false), lastId_(0), lastInstrs_(0) {
+    if (intervalSize_ == 0) {
+        throw std::invalid_argument("Invalid BBV interval size");
+    }
+}
+
+void BBVProfiler::setSimPoints(std::set<size_t> intervals,
+                               std::filesystem::path dumpDir,
+                               std::shared_ptr<mem::PhysMem const> pMem) {
+    simPoints_ = std::move(intervals);
+    dumpDir_ = std::move(dumpDir);
+    pMem_ = std::move(pMem);
+}
+
+std::set<size_t> BBVProfiler::ReadSimPoints(std::istream &simPoints) {
+    std::set<size_t> intervals;
+
+    std::string line;
+    while (std::getline(simPoints, line)) {
+        std::istringstream fields(line);
+        size_t interval;
+        if (fields >> interval) {
+            intervals.insert(interval);
+        }
+    }
+    return intervals;
+}
+
+void BBVProfiler::onBlockFetch(Hart const &hart, exec::BasicBlock const &bb) {
+    size_t instrsExecuted = hart.getInstrsExecuted();
+    this->account(instrsExecuted);
+
+    if (!started_) {
+        started_ = true;
+        this->startInterval(hart);
+    } else if (instrsExecuted >= intervalEnd_) {
+        this->writeInterval();
+        intervalEnd_ = (instrsExecuted / intervalSize_ + 1) * intervalSize_;
+        this->startInterval(hart);
+    }
+
+    lastId_ = bb.getId();
+    if (lastId_ >= counts_.size()) {
+        counts_.resize(std::max(lastId_ + 1, counts_.size() * 2));
+    }
+}
+
+void BBVProfiler::finish(Hart const &hart) {
+    this->account(hart.getInstrsExecuted());
+    if (!touched_.empty()) {
+        this->writeInterval();
+    }
+    lastId_ = 0;
+    output_.flush();
+}
+
+void BBVProfiler::account(size_t instrsExecuted) {
+    size_t instrs = instrsExecuted - lastInstrs_;
+    lastInstrs_ = instrsExecuted;
+    if (lastId_ == 0 || instrs == 0) {
+        return;
+    }
+
+    if (counts_[lastId_] == 0) {
+        touched_.push_back(lastId_);
+    }
+    counts_[lastId_] += instrs;
+}
+
+void BBVProfiler::startInterval(Hart const &hart) {
+    if (pMem_ != nullptr && simPoints_.count(interval_) != 0) {
+        DumpState(dumpDir_ / std::to_string(interval_), hart, *pMem_);
+    }
+}
+
+void BBVProfiler::writeInterval() {
+    std::sort(touched_.begin(), touched_.end());
+
+    output_ << 'T';
+    for (size_t id : touched_) {
+        output_ << ':' << id << ':' << counts_[id] << ' ';
+        counts_[id] = 0;
+    }
+    output_ << '\n';
+
+    touched_.clear();
+    ++interval_;
+}
+
+void BBVProfiler::DumpState(std::filesystem::path const &dir,
+                            Hart const &hart, mem::PhysMem const &pMem) {
+    util::TraceSpan span("bbv.dump_state");
+    std::filesystem::create_directories(dir);
+
+    std::ofstream regs(dir / "regs");
+    exec::GPRF const &gprf = hart.getGPRF();
+    exec::CSRF const &csrf = hart.getCSRF();
+    regs << std::hex;
+    for (Register reg = exec::GPRF::X1; reg < exec::GPRF::PC; ++reg) {
+        regs << 'x' << std::dec << reg << std::hex << " 0x" << gprf.read(reg)
+             << '\n';
+    }
+    regs << "pc 0x" << gprf.read(exec::GPRF::PC) << '\n';
+    regs << "privilege " << csrf.getPrivillege() << '\n';
+    regs << "mstatus 0x" << csrf.mstatus.read() << '\n';
+    regs << "mie 0x" << csrf.mie.read() << '\n';
+    regs << "mip 0x" << csrf.mip.read() << '\n';
+    regs << "mtvec 0x" << csrf.mtvec.read() << '\n';
+    regs << "mepc 0x" << csrf.mepc.read() << '\n';
+    regs << "mcause 0x" << csrf.mcause.read() << '\n';
+    regs << "instret " << std::dec << hart.getInstrsExecuted() << '\n';
+
+    // Contiguous runs of touched pages, loadable with PhysMemLoader::loadBin
+    for (auto const &[range, device] : pMem.getDevices()) {
+        if (device->getType() != mem::IPhysMemDevice::RAM) {
+            continue;
+        }
+        size_t pageSize = static_cast<mem::RAM const &>(*device).getPageSize();
+
+        std::ofstream bin;
+        for (RV64Ptr address = 0; address < range.size();) {
+            auto [hostAddress, size] = device->getHostAddress(address);
+            if (hostAddress == nullptr) {
+                bin.close();
+                address += pageSize - address % pageSize;
+                continue;
+            }
+            if (!bin.is_open()) {
+                std::ostringstream name;
+                name << "ram-" << std::hex << range.leftBorder() + address
+                     << ".bin";
+                bin.open(dir / name.str(), std::ios::binary);
+            }
+            bin.write(static_cast<char const *>(hostAddress), size);
+            address += size;
+        }
+    }
+}
+
+} // namespace besm::sim
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "besm-666/exec/gprf.hpp"
+#include "besm-666/sim/call-graph-profiler.hpp"
+#include "besm-666/sim/hart.hpp"
+
+namespace besm::sim {
+
+std::vector<CallGraphProfiler::Entry>
+CallGraphProfiler::Symbolize(util::Symtab const &symtab,
+                             Counts const &counts) {
+    std::map<std::string, Entry> paths;
+    for (auto const &[path, instrs] : counts) {
+        std::string stack;
+        for (size_t depth = 0; depth < path.size(); ++depth) {
+            util::Symtab::Entry const *symbol = symtab.lookup(path[depth]);
+            if (depth != 0) {
+                stack += ';';
+            }
+            if (symbol != nullptr) {
+                stack += symbol->name;
+            } else {
+                std::ostringstream address;
+                address << "0x" << std::hex << path[depth];
+                stack += address.str();
+            }
+
+            auto [it, inserted] = paths.try_emplace(
+                stack, Entry{.stack = stack, .self = 0, .total = 0});
+            it->second.total += instrs;
+        }
+        paths[stack].self += instrs;
+    }
+
+    std::vector<Entry> profile;
+    profile.reserve(paths.size());
+    for (auto &[stack, entry] : paths) {
+        profile.push_back(std::move(entry));
+    }
+    std::stable_sort(profile.begin(), profile.end(),
+                     [](Entry const &lhs, Entry const &rhs) {
+                         return lhs.total > rhs.total;
+                     });
+    return profile;
+}
+
+void CallGraphProfiler::Print(std::ostream &output,
+                              std::vector<Entry> const &profile, size_t topN) {
+    uint64_t total = 0;
+    for (Entry const &entry : profile) {
+        total += entry.self;
+    }
+    auto ratio = [total](uint64_t count) {
+        return total == 0 ? 0 : static_cast<double>(count) / total;
+    };
+
+    size_t shown = std::min(topN, profile.size());
+    output << "[BESM-666] Call graph of " << total << " instructions, top "
+           << shown << " of " << profile.size() << " call paths:\n"
+           << "[BESM-666]    total     self  call path\n"
+           << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < shown; ++i) {
+        Entry const &entry = profile[i];
+        output << "[BESM-666] " << std::setw(7) << ratio(entry.total) * 100
+               << "% " << std::setw(7) << ratio(entry.self) * 100 << "%  "
+               << entry.stack << '\n';
+    }
+    output << std::defaultfloat << std::setprecision(6);
+    output.flush();
+}
+
+void CallGraphProfiler::WriteFolded(std::ostream &output,
+                                    std::vector<Entry> const &profile) {
+    for (Entry const &entry : profile) {
+        if (entry.self != 0) {
+            output << entry.stack << ' ' << entry.self << '\n';
+        }
+    }
+}
+
+CallGraphProfiler::CallGraphProfiler(size_t maxDepth)
+    : maxDepth_(maxDepth), truncated_(0), last_(nullptr), lastInstrs_(0),
+      lastCompleted_(false) {
+    if (maxDepth_ == 0) {
+        throw std::invalid_argument("Invalid call graph depth");
+    }
+}
+
+void CallGraphProfiler::onBlockFetch(Hart const &hart,
+                                     exec::BasicBlock const &bb) {
+    this->account(hart.getInstrsExecuted());
+
+    if (stack_.empty()) {
+        nodes_.push_back(Node{.entry = bb.getPC(), .parent = 0, .self = 0});
+        stack_.push_back(Frame{.node = 0, .returnAddress = kNoReturn});
+    } else if (lastCompleted_) {
+        Instruction const &exit =
+            last_->getInstructions()[last_->getSize() - 1];
+        if ((exit.operation == JAL || exit.operation == JALR) &&
+            exit.rd == exec::GPRF::X1) {
+            this->call(bb.getPC(), last_->getPC() + 4 * last_->getSize());
+        } else if (exit.operation == JALR && exit.rd == exec::GPRF::X0 &&
+                   exit.rs1 == exec::GPRF::X1) {
+            this->ret(bb.getPC());
+        }
+    }
+
+    last_ = &bb;
+    lastCompleted_ = false;
+}
+
+void CallGraphProfiler::finish(Hart const &hart) {
+    this->account(hart.getInstrsExecuted());
+    last_ = nullptr;
+}
+
+void CallGraphProfiler::account(size_t instrsExecuted) {
+    size_t instrs = instrsExecuted - lastInstrs_;
+    lastInstrs_ = instrsExecuted;
+    if (last_ == nullptr || instrs == 0) {
+        return;
+    }
+
+    nodes_[stack_.back().node].self += instrs;
+    lastCompleted_ = instrs >= last_->getSize();
+}
+
+void CallGraphProfiler::call(RV64Ptr entry, RV64Ptr returnAddress) {
+    if (stack_.size() >= maxDepth_) {
+        ++truncated_;
+        return;
+    }
+
+    size_t parent = stack_.back().node;
+    auto [it, inserted] =
+        children_.try_emplace(std::make_pair(parent, entry), nodes_.size());
+    if (inserted) {
+        nodes_.push_back(Node{.entry = entry, .parent = parent, .self = 0});
+    }
+    stack_.push_back(Frame{.node = it->second, .returnAddress = returnAddress});
+}
+
+void CallGraphProfiler::ret(RV64Ptr target) {
+    for (size_t depth = stack_.size() - 1; depth != 0; --depth) {
+        if (stack_[depth].returnAddress == target) {
+            stack_.resize(depth);
+            truncated_ = 0;
+            return;
+        }
+    }
+    // A return from a call beyond the maximum depth
+    if (truncated_ != 0) {
+        --truncated_;
+    }
+}
+
+void CallGraphProfiler::addCounts(Counts &counts) const {
+    for (size_t id = 0; id < nodes_.size(); ++id) {
+        if (nodes_[id].self == 0) {
+            continue;
+        }
+        std::vector<RV64Ptr> path;
+        for (size_t node = id;; node = nodes_[node].parent) {
+            path.push_back(nodes_[node].entry);
+            if (node == 0) {
+                break;
+            }
+        }
+        std::reverse(path.begin(), path.end());
+        counts[path] += nodes_[id].self;
+    }
+}
+
+} // namespace besm::sim
@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <sched.h>
+
 #include "besm-666/sim/config.hpp"
+#include "besm-666/memory/clint.hpp"
 
 namespace besm::sim {
 
@@ -11,6 +15,22 @@ std::filesystem::path Config::executablePath() const {
     return data_.executablePath;
 }
 
+std::vector<std::string> const &Config::guestArgs() const {
+    return data_.guestArgs;
+}
+bool Config::userMode() const { return data_.userMode; }
+bool Config::verbose() const { return data_.verbose; }
+
+size_t Config::numHarts() const { return data_.numHarts; }
+std::vector<int> const &Config::hartAffinity() const {
+    return data_.hartAffinity;
+}
+size_t Config::hostThreads() const { return data_.hostThreads; }
+size_t Config::hartQuantum() const { return data_.hartQuantum; }
+bool Config::deterministic() const { return data_.deterministic; }
+uint64_t Config::schedulerSeed() const { return data_.schedulerSeed; }
+bool Config::sharedCodeCache() const { return data_.sharedCodeCache; }
+
 std::vector<util::Range<RV64Ptr>> const &Config::ramRanges() const {
     return data_.ramRanges;
 }
@@ -18,13 +38,54 @@ std::vector<util::Range<RV64Ptr>> const &Config::ramRanges() const {
 size_t Config::ramPageSize() const { return data_.ramPageSize; }
 size_t Config::ramChunkSize() const { return data_.ramChunkSize; }
 
+std::optional<RV64Ptr> Config::uartAddress() const {
+    return data_.uartAddress;
+}
+std::filesystem::path Config::uartInputPath() const {
+    return data_.uartInputPath;
+}
+std::optional<RV64Ptr> Config::timerAddress() const {
+    return data_.timerAddress;
+}
+RV64UDWord Config::timerFrequency() const { return data_.timerFrequency; }
+
 void ConfigBuilder::setExecutablePath(std::filesystem::path path) {
     data_.executablePath = path;
 }
 
+void ConfigBuilder::addGuestArg(std::string arg) {
+    data_.guestArgs.push_back(std::move(arg));
+}
+void ConfigBuilder::setUserMode(bool userMode) { data_.userMode = userMode; }
+void ConfigBuilder::setVerbose(bool verbose) { data_.verbose = verbose; }
+
+void ConfigBuilder::setNumHarts(size_t numHarts) {
+    data_.numHarts = numHarts;
+}
+void ConfigBuilder::addHartAffinity(int cpu) {
+    data_.hartAffinity.push_back(cpu);
+}
+void ConfigBuilder::setHostThreads(size_t hostThreads) {
+    data_.hostThreads = hostThreads;
+}
+void ConfigBuilder::setHartQuantum(size_t quantum) {
+    data_.hartQuantum = quantum;
+}
+void ConfigBuilder::setDeterministic(bool deterministic) {
+    data_.deterministic = deterministic;
+}
+void ConfigBuilder::setSchedulerSeed(uint64_t seed) {
+    data_.schedulerSeed = seed;
+}
+
+void ConfigBuilder::setSharedCodeCache(bool sharedCodeCache) {
+    data_.sharedCodeCache = sharedCodeCache;
+}
+
 void ConfigBuilder::addRamRange(util::Range<RV64Ptr> range) {
     data_.ramRanges.push_back(range);
 }
+void ConfigBuilder::clearRamRanges() { data_.ramRanges.clear(); }
 void ConfigBuilder::setRamPageSize(size_t pageSize) {
     data_.ramPageSize = pageSize;
 }
@@ -32,6 +93,20 @@ void ConfigBuilder::setRamChunkSize(size_t chunkSize) {
     data_.ramChunkSize = chunkSize;
 }
 
+void ConfigBuilder::setUartAddress(RV64Ptr address) {
+    data_.uartAddress = address;
+}
+void ConfigBuilder::setUartInputPath(std::filesystem::path path) {
+    data_.uartInputPath = path;
+}
+
+void ConfigBuilder::setTimerAddress(RV64Ptr address) {
+    data_.timerAddress = address;
+}
+void ConfigBuilder::setTimerFrequency(RV64UDWord frequency) {
+    data_.timerFrequency = frequency;
+}
+
 Config ConfigBuilder::build() {
     this->validateState();
     return Config(std::move(data_));
@@ -41,5 +116,34 @@ void ConfigBuilder::validateState() const {
     if (data_.executablePath.empty()) {
         throw InvalidConfiguration("Invalid executable path");
     }
+    if (data_.numHarts == 0 || data_.numHarts > mem::CLINT::kMaxHarts) {
+        throw InvalidConfiguration("Invalid harts number");
+    }
+    if (data_.userMode && data_.numHarts != 1) {
+        throw InvalidConfiguration("User mode supports a single hart only");
+    }
+    if (!data_.hartAffinity.empty() &&
+        data_.hartAffinity.size() != data_.numHarts) {
+        throw InvalidConfiguration("Hart affinity must list a CPU per hart");
+    }
+    if (std::any_of(data_.hartAffinity.begin(), data_.hartAffinity.end(),
+                    [](int cpu) { return cpu < 0 || cpu >= CPU_SETSIZE; })) {
+        throw InvalidConfiguration("Invalid hart affinity CPU");
+    }
+    if ((data_.hostThreads != 0 || data_.deterministic) &&
+        !data_.hartAffinity.empty()) {
+        throw InvalidConfiguration(
+            "Hart affinity requires a host thread per hart");
+    }
+    if (data_.hartQuantum == 0) {
+        throw InvalidConfiguration("Invalid hart quantum");
+    }
+    if (!data_.uartInputPath.empty() && !data_.uartAddress.has_value()) {
+        throw InvalidConfiguration("UART input is set, but UART is not mapped");
+    }
+    if (data_.timerFrequency == 0 ||
+        data_.timerFrequency > mem::CLINT::kHartFrequency) {
+        throw InvalidConfiguration("Invalid timer frequency");
+    }
 }
 } // namespace besm::sim
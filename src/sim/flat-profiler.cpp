@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <iomanip>
+#include <map>
+
+#include "besm-666/sim/flat-profiler.hpp"
+#include "besm-666/sim/hart.hpp"
+
+namespace besm::sim {
+
+std::vector<FlatProfiler::Entry>
+FlatProfiler::Symbolize(util::Symtab const &symtab, Counts const &counts) {
+    // Keyed by the symbol address, unknown code is gathered at 0
+    std::map<RV64Ptr, Entry> functions;
+    for (auto [pc, instrs] : counts) {
+        util::Symtab::Entry const *symbol = symtab.lookup(pc);
+        RV64Ptr address = symbol == nullptr ? 0 : symbol->address;
+        auto [it, inserted] = functions.try_emplace(
+            address,
+            Entry{.name = symbol == nullptr ? "[unknown]" : symbol->name,
+                  .address = address,
+                  .instrs = 0});
+        it->second.instrs += instrs;
+    }
+
+    std::vector<Entry> profile;
+    profile.reserve(functions.size());
+    for (auto &[address, entry] : functions) {
+        profile.push_back(std::move(entry));
+    }
+    std::stable_sort(profile.begin(), profile.end(),
+                     [](Entry const &lhs, Entry const &rhs) {
+                         return lhs.instrs > rhs.instrs;
+                     });
+    return profile;
+}
+
+void FlatProfiler::Print(std::ostream &output,
+                         std::vector<Entry> const &profile, size_t topN) {
+    uint64_t total = 0;
+    for (Entry const &entry : profile) {
+        total += entry.instrs;
+    }
+    auto ratio = [total](uint64_t count) {
+        return total == 0 ? 0 : static_cast<double>(count) / total;
+    };
+
+    size_t shown = std::min(topN, profile.size());
+    output << "[BESM-666] Flat profile of " << total << " instructions, top "
+           << shown << " of " << profile.size() << " functions:\n"
+           << "[BESM-666]     self      cum    instructions  function\n"
+           << std::fixed << std::setprecision(2);
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < shown; ++i) {
+        Entry const &entry = profile[i];
+        cumulative += entry.instrs;
+        output << "[BESM-666] " << std::setw(7) << ratio(entry.instrs) * 100
+               << "% " << std::setw(7) << ratio(cumulative) * 100 << "% "
+               << std::setw(15) << entry.instrs << "  " << entry.name;
+        if (entry.address != 0) {
+            output << " (0x" << std::hex << entry.address << std::dec << ')';
+        }
+        output << '\n';
+    }
+    output << std::defaultfloat << std::setprecision(6);
+    output.flush();
+}
+
+void FlatProfiler::WriteFolded(std::ostream &output,
+                               std::vector<Entry> const &profile) {
+    for (Entry const &entry : profile) {
+        output << entry.name << ' ' << entry.instrs << '\n';
+    }
+}
+
+FlatProfiler::FlatProfiler() : lastId_(0), lastInstrs_(0) {}
+
+void FlatProfiler::onBlockFetch(Hart const &hart, exec::BasicBlock const &bb) {
+    this->account(hart.getInstrsExecuted());
+
+    lastId_ = bb.getId();
+    if (lastId_ >= instrs_.size()) {
+        size_t size = std::max(lastId_ + 1, instrs_.size() * 2);
+        instrs_.resize(size);
+        pcs_.resize(size);
+    }
+    pcs_[lastId_] = bb.getPC();
+}
+
+void FlatProfiler::finish(Hart const &hart) {
+    this->account(hart.getInstrsExecuted());
+    lastId_ = 0;
+}
+
+void FlatProfiler::account(size_t instrsExecuted) {
+    size_t instrs = instrsExecuted - lastInstrs_;
+    lastInstrs_ = instrsExecuted;
+    if (lastId_ == 0 || instrs == 0) {
+        return;
+    }
+    instrs_[lastId_] += instrs;
+}
+
+void FlatProfiler::addCounts(Counts &counts) const {
+    for (size_t id = 0; id < instrs_.size(); ++id) {
+        if (instrs_[id] != 0) {
+            counts[pcs_[id]] += instrs_[id];
+        }
+    }
+}
+
+} // namespace besm::sim
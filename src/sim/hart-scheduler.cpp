@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#include "besm-666/sim/hart-scheduler.hpp"
+
+namespace besm::sim {
+
+WorkStealingScheduler::WorkStealingScheduler(std::vector<Hart::SPtr> harts,
+                                             size_t numWorkers, size_t quantum)
+    : harts_(std::move(harts)), runTimes_(harts_.size()), quantum_(quantum),
+      numWorkers_(std::min(numWorkers, harts_.size())), parkedNum_(0),
+      runningNum_(0) {
+    if (numWorkers_ == 0) {
+        throw std::invalid_argument("Invalid scheduler workers number");
+    }
+    if (quantum_ == 0) {
+        throw std::invalid_argument("Invalid scheduler quantum");
+    }
+    workers_.reset(new Worker[numWorkers_]);
+}
+
+void WorkStealingScheduler::runUntil(RV64Ptr stopPC) {
+    error_ = nullptr;
+    parked_.clear();
+    parkedNum_.store(0, std::memory_order_relaxed);
+    runningNum_.store(harts_.size(), std::memory_order_relaxed);
+
+    for (size_t hartId = 0; hartId < harts_.size(); ++hartId) {
+        workers_[hartId % numWorkers_].tasks.push_back(
+            {harts_[hartId].get(), hartId});
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t workerId = 1; workerId < numWorkers_; ++workerId) {
+        threads.emplace_back(&WorkStealingScheduler::workerLoop, this,
+                             workerId, stopPC);
+    }
+    this->workerLoop(0, stopPC);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (error_ != nullptr) {
+        std::rethrow_exception(error_);
+    }
+}
+
+std::chrono::duration<double>
+WorkStealingScheduler::getRunTime(size_t hartId) const {
+    return runTimes_.at(hartId);
+}
+
+void WorkStealingScheduler::workerLoop(size_t workerId, RV64Ptr stopPC) {
+    while (runningNum_.load(std::memory_order_acquire) != 0) {
+        if (parkedNum_.load(std::memory_order_relaxed) != 0) {
+            this->wakeUpParked(workerId);
+        }
+
+        Task task;
+        if (this->pop(workerId, task) || this->steal(workerId, task)) {
+            this->runTask(workerId, task, stopPC);
+            continue;
+        }
+
+        // A push racing with going idle is noticed after the timeout, the
+        // timeout also bounds the wake up latency of the parked harts
+        std::unique_lock<std::mutex> lock(idleMutex_);
+        if (runningNum_.load(std::memory_order_acquire) != 0) {
+            wakeUp_.wait_for(lock, kIdleTimeout);
+        }
+    }
+}
+
+void WorkStealingScheduler::runTask(size_t workerId, Task task,
+                                    RV64Ptr stopPC) {
+    Hart &hart = *task.hart;
+
+    Hart::YieldReason reason = Hart::YIELD_NONE;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        reason = hart.runSlice(stopPC, quantum_);
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(errorMutex_);
+            if (error_ == nullptr) {
+                error_ = std::current_exception();
+            }
+        }
+        this->stopAll();
+    }
+    runTimes_[task.hartId] += std::chrono::steady_clock::now() - start;
+
+    switch (reason) {
+    case Hart::YIELD_QUANTUM:
+    case Hart::YIELD_PAUSE:
+        this->push(workerId, task);
+        break;
+    case Hart::YIELD_WFI:
+        this->park(task);
+        break;
+    case Hart::YIELD_NONE:
+        // The guest has finished, the other harts would never stop themselves
+        if (hart.getGPRF().read(exec::GPRF::PC) != stopPC) {
+            this->stopAll();
+        }
+        this->finish();
+        break;
+    }
+}
+
+void WorkStealingScheduler::push(size_t workerId, Task task) {
+    {
+        std::lock_guard<std::mutex> lock(workers_[workerId].mutex);
+        workers_[workerId].tasks.push_back(task);
+    }
+    wakeUp_.notify_one();
+}
+
+bool WorkStealingScheduler::pop(size_t workerId, Task &task) {
+    Worker &worker = workers_[workerId];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = worker.tasks.front();
+    worker.tasks.pop_front();
+    return true;
+}
+
+/**
+ * Takes the hart which has waited the least in the victim's deque
+ */
+bool WorkStealingScheduler::steal(size_t workerId, Task &task) {
+    for (size_t i = 1; i < numWorkers_; ++i) {
+        Worker &victim = workers_[(workerId + i) % numWorkers_];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingScheduler::park(Task task) {
+    std::lock_guard<std::mutex> lock(parkedMutex_);
+    parked_.push_back(task);
+    parkedNum_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WorkStealingScheduler::wakeUpParked(size_t workerId) {
+    // One worker polling the parked harts is enough
+    std::unique_lock<std::mutex> lock(parkedMutex_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return;
+    }
+
+    for (size_t i = 0; i < parked_.size();) {
+        if (!parked_[i].hart->wakeUpPending()) {
+            ++i;
+            continue;
+        }
+        this->push(workerId, parked_[i]);
+        parked_[i] = parked_.back();
+        parked_.pop_back();
+        parkedNum_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void WorkStealingScheduler::finish() {
+    if (runningNum_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        wakeUp_.notify_all();
+    }
+}
+
+void WorkStealingScheduler::stopAll() {
+    for (auto const &hart : harts_) {
+        hart->requestStop();
+    }
+}
+
+} // namespace besm::sim
@@ -1,53 +1,322 @@
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <iterator>
+#include <type_traits>
 #include <utility>
 
 #include "besm-666/exec/gprf.hpp"
 #include "besm-666/memory/phys-mem.hpp"
 #include "besm-666/sim/hart.hpp"
 #include "besm-666/sim/hooks.hpp"
+#include "besm-666/sim/syscall-emulator.hpp"
 
 namespace besm::sim {
 
+namespace {
+std::atomic<RV64UDWord> const NoTimerDeadline{mem::CLINT::kNoDeadline};
+
+template <typename DataType>
+DataType LoadData(mem::MMU &mmu, RV64Ptr address) {
+    if constexpr (sizeof(DataType) == sizeof(RV64UWord)) {
+        return mmu.loadWord(address);
+    } else {
+        return mmu.loadDWord(address);
+    }
+}
+
+template <typename DataType>
+void StoreData(mem::MMU &mmu, RV64Ptr address, DataType value) {
+    if constexpr (sizeof(DataType) == sizeof(RV64UWord)) {
+        mmu.storeWord(address, static_cast<RV64Word>(value));
+    } else {
+        mmu.storeDWord(address, static_cast<RV64DWord>(value));
+    }
+}
+
+/// Word results are sign-extended to XLEN
+template <typename DataType> RV64UDWord ExtendData(DataType value) {
+    if constexpr (sizeof(DataType) == sizeof(RV64UWord)) {
+        return util::SignExtend<RV64UDWord, 32>(value);
+    } else {
+        return value;
+    }
+}
+
+/**
+ * Returns the host memory backing \p address, nullptr if there is no such
+ * memory (a device register)
+ */
+template <typename DataType>
+DataType *AtomicHostAddress(mem::MMU &mmu, RV64Ptr address) {
+    auto [hostAddress, size] = mmu.touchHostAddress(address);
+    return size < sizeof(DataType) ? nullptr
+                                   : static_cast<DataType *>(hostAddress);
+}
+
+/*
+ * AMO operations: Atomic() performs the operation on host memory and returns
+ * the old value, Apply() computes the new value for non-atomic fallback.
+ */
+template <typename Operation, typename DataType>
+DataType AtomicApply(DataType *data, DataType operand) {
+    DataType old = __atomic_load_n(data, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(data, &old,
+                                        Operation::Apply(old, operand), true,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+    }
+    return old;
+}
+
+struct AMOSwap {
+    template <typename T> static T Atomic(T *data, T operand) {
+        return __atomic_exchange_n(data, operand, __ATOMIC_SEQ_CST);
+    }
+    template <typename T> static T Apply(T, T operand) { return operand; }
+};
+struct AMOAdd {
+    template <typename T> static T Atomic(T *data, T operand) {
+        return __atomic_fetch_add(data, operand, __ATOMIC_SEQ_CST);
+    }
+    template <typename T> static T Apply(T old, T operand) {
+        return old + operand;
+    }
+};
+struct AMOXor {
+    template <typename T> static T Atomic(T *data, T operand) {
+        return __atomic_fetch_xor(data, operand, __ATOMIC_SEQ_CST);
+    }
+    template <typename T> static T Apply(T old, T operand) {
+        return old ^ operand;
+    }
+};
+struct AMOAnd {
+    template <typename T> static T Atomic(T *data, T operand) {
+        return __atomic_fetch_and(data, operand, __ATOMIC_SEQ_CST);
+    }
+    template <typename T> static T Apply(T old, T operand) {
+        return old & operand;
+    }
+};
+struct AMOOr {
+    template <typename T> static T Atomic(T *data, T operand) {
+        return __atomic_fetch_or(data, operand, __ATOMIC_SEQ_CST);
+    }
+    template <typename T> static T Apply(T old, T operand) {
+        return old | operand;
+    }
+};
+struct AMOMin {
+    template <typename T> static T Atomic(T *data, T operand) {
+        return AtomicApply<AMOMin>(data, operand);
+    }
+    template <typename T> static T Apply(T old, T operand) {
+        using Signed = std::make_signed_t<T>;
+        return static_cast<Signed>(operand) < static_cast<Signed>(old)
+                   ? operand
+                   : old;
+    }
+};
+struct AMOMax {
+    template <typename T> static T Atomic(T *data, T operand) {
+        return AtomicApply<AMOMax>(data, operand);
+    }
+    template <typename T> static T Apply(T old, T operand) {
+        using Signed = std::make_signed_t<T>;
+        return static_cast<Signed>(operand) > static_cast<Signed>(old)
+                   ? operand
+                   : old;
+    }
+};
+struct AMOMinU {
+    template <typename T> static T Atomic(T *data, T operand) {
+        return AtomicApply<AMOMinU>(data, operand);
+    }
+    template <typename T> static T Apply(T old, T operand) {
+        return std::min(old, operand);
+    }
+};
+struct AMOMaxU {
+    template <typename T> static T Atomic(T *data, T operand) {
+        return AtomicApply<AMOMaxU>(data, operand);
+    }
+    template <typename T> static T Apply(T old, T operand) {
+        return std::max(old, operand);
+    }
+};
+} // namespace
+
+static_assert(std::size(Hart::HANDLER_ARR) == BB_END + 1,
+              "Every operation must have a handler");
+
 Hart::SPtr Hart::Create(std::shared_ptr<mem::PhysMem> const &pMem,
-                        std::shared_ptr<HookManager> const &hookManager) {
-    return std::shared_ptr<Hart>(new Hart(pMem, hookManager));
+                        std::shared_ptr<HookManager> const &hookManager,
+                        size_t hartId) {
+    return std::shared_ptr<Hart>(new Hart(pMem, hookManager, hartId));
 }
 
 Hart::Hart(std::shared_ptr<mem::PhysMem> const &pMem,
-           std::shared_ptr<HookManager> hookManager)
-    : mmu_(mem::MMU::Create(pMem)), prefetcher_(mmu_),
-      hookManager_(std::move(hookManager)), instrsExecuted_(0),
-      currentInstr_(nullptr) {
+           std::shared_ptr<HookManager> hookManager, size_t hartId)
+    : codeCache_(exec::SharedBasicBlockCache::Create()), codeHash_(0),
+      currentInstr_(nullptr), pMem_(pMem), mmu_(mem::MMU::Create(pMem)),
+      prefetcher_(mmu_), hookManager_(std::move(hookManager)),
+      timerDeadline_(&NoTimerDeadline), reservation_{0, 0, 0},
+      instrsExecuted_(0), stats_(Stats::Create(1)), statsShard_(0),
+      blockStart_(0), blockWord_(exec::PRIVILLEGE_MACHINE),
+      decodeBursts_("hart.decode", "blocks", kTraceBurstGap),
+      stopPC_(kNoStopPC), stopRequested_(false), sliceEnd_(kNoSliceEnd),
+      yieldReason_(YIELD_NONE) {
     assert(mmu_ != nullptr);
+    csrf_.mhartid.set<exec::MHartID::Value>(hartId);
+    this->registerStats();
 }
 
 bool Hart::finished() const { return false; }
 
-void Hart::run() { exec_BB_END(*this); }
+void Hart::run() { this->runUntil(kNoStopPC); }
+
+void Hart::runUntil(RV64Ptr stopPC) {
+    stopPC_ = stopPC;
+    exec_BB_END(*this);
+    decodeBursts_.flush();
+}
+
+Hart::YieldReason Hart::runSlice(RV64Ptr stopPC, size_t quantum) {
+    yieldReason_ = YIELD_NONE;
+    size_t instrs = this->getInstrsExecuted();
+    sliceEnd_ = instrs + std::min(quantum, kNoSliceEnd - 1 - instrs);
+
+    this->runUntil(stopPC);
+
+    sliceEnd_ = kNoSliceEnd;
+    return yieldReason_;
+}
+
+bool Hart::wakeUpPending() const {
+    return (csrf_.mip.read() & csrf_.mie.read()) != 0 ||
+           stopRequested_.load(std::memory_order_relaxed);
+}
+
+void Hart::requestStop() {
+    stopRequested_.store(true, std::memory_order_relaxed);
+}
+
+void Hart::attachSyscallEmulator(std::shared_ptr<SyscallEmulator> emulator) {
+    syscalls_ = std::move(emulator);
+    syscalls_->initProcess(gprf_, *mmu_);
+    csrf_.setPrivillege(exec::PRIVILLEGE_USER);
+}
+
+void Hart::attachHTIF(mem::HTIF::SPtr htif) { htif_ = std::move(htif); }
+
+void Hart::attachCLINT(mem::CLINT::SPtr clint) {
+    clint_ = std::move(clint);
+
+    size_t hartId = csrf_.mhartid.get<exec::MHartID::Value>();
+    clint_->attachHart(hartId, &instrsExecuted_, csrf_.mip);
+    timerDeadline_ = &clint_->getDeadline(hartId);
+}
+
+void Hart::attachProfiler(IBlockProfiler *profiler) {
+    profilers_.push_back(profiler);
+}
+
+void Hart::detachProfiler(IBlockProfiler *profiler) {
+    profilers_.erase(
+        std::remove(profilers_.begin(), profilers_.end(), profiler),
+        profilers_.end());
+}
+
+void Hart::attachStats(Stats::SPtr stats) {
+    size_t hartId = csrf_.mhartid.get<exec::MHartID::Value>();
+    if (hartId >= stats->getShardsNum()) {
+        throw std::invalid_argument("No stats shard for hart " +
+                                    std::to_string(hartId));
+    }
+
+    stats_ = std::move(stats);
+    statsShard_ = hartId;
+    this->registerStats();
+}
+
+void Hart::registerStats() {
+    statsSlots_.bbCacheLookups = &stats_->counter(
+        "bb_cache.lookups", "Basic block fetches through the hart cache");
+    statsSlots_.bbCacheMisses = &stats_->counter(
+        "bb_cache.misses", "Basic blocks missing in the hart cache");
+    statsSlots_.blocksDecoded = &stats_->counter(
+        "code_cache.decoded", "Basic blocks missing in the code cache");
+    statsSlots_.fetchTranslations = &stats_->counter(
+        "mmu.fetch_translations", "Instruction fetch address translations");
+    statsSlots_.exceptions =
+        &stats_->counter("csrf.exceptions", "Synchronous traps taken");
+    statsSlots_.interrupts =
+        &stats_->counter("csrf.interrupts", "Interrupts taken");
+    statsSlots_.blockLength = &stats_->histogram(
+        "hart.block_length", "Instructions executed per basic block fetch");
+}
+
+void Hart::attachCodeCache(exec::SharedBasicBlockCache::SPtr codeCache,
+                           uint64_t codeHash) {
+    codeCache_ = std::move(codeCache);
+    codeHash_ = codeHash;
+    bbCache_ = exec::BasicBlockCache();
+}
+
+void Hart::enterTrap(RV64UDWord cause, bool interrupt) {
+    reservation_.size = 0;
+    (interrupt ? statsSlots_.interrupts : statsSlots_.exceptions)
+        ->add(statsShard_);
 
-void Hart::raiseException(ExceptionId id) {
     csrf_.mstatus.set<exec::MStatus::MPIE>(
         csrf_.mstatus.get<exec::MStatus::MIE>());
     csrf_.mstatus.set<exec::MStatus::MIE>(0);
     csrf_.mstatus.set<exec::MStatus::MPP>(csrf_.getPrivillege());
     csrf_.setPrivillege(exec::PRIVILLEGE_MACHINE);
 
-    csrf_.mcause.set<exec::MCause::Interrupt>(0);
-    csrf_.mcause.set<exec::MCause::ExceptionCode>(id);
+    csrf_.mcause.set<exec::MCause::Interrupt>(interrupt ? 1 : 0);
+    csrf_.mcause.set<exec::MCause::ExceptionCode>(cause);
 
     RV64Ptr newPC;
     if (csrf_.mtvec.get<exec::MTVec::Mode>() == exec::MTVec::VectoredMode) {
-        newPC = (csrf_.mtvec.get<exec::MTVec::Base>() + id) * 4;
+        newPC = (csrf_.mtvec.get<exec::MTVec::Base>() + cause) * 4;
     } else {
         newPC = csrf_.mtvec.get<exec::MTVec::Base>() * 4;
     }
 
     csrf_.mepc.set<exec::MEPC::Value>(gprf_.read(exec::GPRF::PC));
     gprf_.write(exec::GPRF::PC, newPC);
+}
 
+void Hart::raiseException(ExceptionId id) {
+    this->enterTrap(id, false);
     this->fetchBB();
 }
+
+/**
+ * Called at a basic block boundary, so mepc is the entry of the block which
+ * is not executed yet
+ */
+void Hart::takeInterrupt() {
+    RV64UDWord pending = csrf_.mip.read() & csrf_.mie.read();
+    if (pending == 0) {
+        return;
+    }
+    if (csrf_.getPrivillege() == exec::PRIVILLEGE_MACHINE &&
+        csrf_.mstatus.get<exec::MStatus::MIE>() == 0) {
+        return;
+    }
+
+    InterruptId id = INTERRUPT_MTIMER;
+    if (pending & MIP_MEIP) {
+        id = INTERRUPT_MEXTERNAL;
+    } else if (pending & MIP_MSIP) {
+        id = INTERRUPT_MSOFTWARE;
+    }
+
+    this->enterTrap(id, true);
+}
+
 void Hart::raiseIllegalInstruction() {
     raiseException(EXCEPTION_ILLEGAL_INSTR);
 }
@@ -60,21 +329,54 @@ void Hart::assembleBB(exec::BasicBlock &bb, RV64Ptr pc) {
     }
 }
 
+exec::BasicBlock const *Hart::findBB(RV64Ptr pc) {
+    statsSlots_.bbCacheMisses->add(statsShard_);
+    exec::BasicBlock const *bb = codeCache_->lookup(codeHash_, pc);
+    if (bb == nullptr) {
+        statsSlots_.blocksDecoded->add(statsShard_);
+        size_t translations = prefetcher_.getTranslationsNum();
+        uint64_t start = util::Tracer::Enabled() ? util::Tracer::Now() : 0;
+        exec::BasicBlock decoded;
+        this->assembleBB(decoded, pc);
+        if (start != 0) {
+            decodeBursts_.add(start, util::Tracer::Now());
+        }
+        statsSlots_.fetchTranslations->add(
+            statsShard_, prefetcher_.getTranslationsNum() - translations);
+        bb = codeCache_->publish(codeHash_, decoded);
+    }
+
+    bbCache_.insert(bb);
+    return bb;
+}
+
 void Hart::fetchBB() {
     RV64UDWord pc = gprf_.read(exec::GPRF::PC);
+    blockWord_.store(pc | csrf_.getPrivillege(), std::memory_order_relaxed);
 
-    auto [bbFound, bb] = bbCache_.lookup(pc);
-    if (!bbFound) {
-        this->assembleBB(bb, pc);
+    size_t instrs = this->getInstrsExecuted();
+    if (instrs != blockStart_) {
+        statsSlots_.blockLength->record(statsShard_, instrs - blockStart_);
+        blockStart_ = instrs;
     }
 
-    hookManager_->triggerBBFetchHook(bb);
+    statsSlots_.bbCacheLookups->add(statsShard_);
+    exec::BasicBlock const *bb = bbCache_.lookup(pc);
+    if (bb == nullptr) {
+        bb = this->findBB(pc);
+    }
+
+    hookManager_->triggerBBFetchHook(*bb);
+    for (IBlockProfiler *profiler : profilers_) {
+        profiler->onBlockFetch(*this, *bb);
+    }
 
-    currentInstr_ = bb.getInstructions();
+    currentInstr_ = bb->getInstructions();
 }
 
 inline void Hart::execNextInstr(Hart &hart) {
-    ++hart.instrsExecuted_;
+    hart.instrsExecuted_.store(hart.getInstrsExecuted() + 1,
+                               std::memory_order_relaxed);
 
     hart.hookManager_->triggerInstrExecHook(*hart.currentInstr_);
 
@@ -83,6 +385,30 @@ inline void Hart::execNextInstr(Hart &hart) {
 }
 
 void Hart::exec_BB_END(Hart &hart) {
+    if (hart.gprf_.read(exec::GPRF::PC) == hart.stopPC_ ||
+        hart.stopRequested_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    size_t instrs = hart.getInstrsExecuted();
+    if (instrs >= hart.sliceEnd_) {
+        if (hart.yieldReason_ == YIELD_NONE) {
+            hart.yieldReason_ = YIELD_QUANTUM;
+        }
+        return;
+    }
+    if (instrs >= hart.timerDeadline_->load(std::memory_order_relaxed)) {
+        hart.clint_->expireTimer(
+            hart.csrf_.mhartid.get<exec::MHartID::Value>());
+    }
+    if (hart.htif_ != nullptr && hart.htif_->pending()) {
+        if (!hart.htif_->process(*hart.pMem_)) {
+            return;
+        }
+    }
+    if (hart.csrf_.mip.read() != 0) {
+        hart.takeInterrupt();
+    }
+
     hart.fetchBB();
 
     (*HANDLER_ARR[hart.currentInstr_->operation])(hart);
@@ -607,9 +933,32 @@ void Hart::exec_FENCE_TSO(Hart &hart) {
     execNextInstr(hart);
 }
 
-// todo: to be implemented
 void Hart::exec_PAUSE(Hart &hart) {
-    hart.raiseIllegalInstruction();
+    hart.nextPC();
+
+    if (hart.sliceEnd_ != kNoSliceEnd) {
+        hart.yieldReason_ = YIELD_PAUSE;
+        hart.sliceEnd_ = 0;
+    }
+
+    execNextInstr(hart);
+}
+
+/**
+ * The virtual clock of a hart runs only while the hart executes, so a hart
+ * waiting for its own timer can't sleep: it yields as a spinning one does.
+ */
+void Hart::exec_WFI(Hart &hart) {
+    hart.nextPC();
+
+    if (hart.sliceEnd_ != kNoSliceEnd) {
+        hart.yieldReason_ =
+            hart.timerDeadline_->load(std::memory_order_relaxed) ==
+                    mem::CLINT::kNoDeadline
+                ? YIELD_WFI
+                : YIELD_PAUSE;
+        hart.sliceEnd_ = 0;
+    }
 
     execNextInstr(hart);
 }
@@ -617,6 +966,14 @@ void Hart::exec_PAUSE(Hart &hart) {
 void Hart::exec_ECALL(Hart &hart) {
     switch (hart.csrf_.getPrivillege()) {
     case exec::PRIVILLEGE_USER:
+        if (hart.syscalls_ != nullptr) {
+            if (!hart.syscalls_->handle(hart.gprf_, *hart.mmu_)) {
+                return;
+            }
+            hart.nextPC();
+            break;
+        }
+
         hart.raiseException(EXCEPTION_ECALL_UMODE);
         break;
 
@@ -843,6 +1200,157 @@ void Hart::exec_CSRRCI(Hart &hart) {
     execNextInstr(hart);
 }
 
+/**
+ * Misaligned atomics trap instead of being emulated. The rest of the block
+ * is dropped, the hart continues at the trap vector.
+ */
+void Hart::raiseMisaligned(Hart &hart, ExceptionId id) {
+    hart.enterTrap(id, false);
+    exec_BB_END(hart);
+}
+
+template <typename DataType> void Hart::execLR(Hart &hart) {
+    RV64Ptr address = hart.gprf_.read(hart.currentInstr_->rs1);
+    if (address % sizeof(DataType) != 0) {
+        raiseMisaligned(hart, EXCEPTION_LOAD_ADDR_MISALIGNED);
+        return;
+    }
+
+    DataType value;
+    if (DataType *data = AtomicHostAddress<DataType>(*hart.mmu_, address)) {
+        value = __atomic_load_n(data, __ATOMIC_SEQ_CST);
+    } else {
+        value = LoadData<DataType>(*hart.mmu_, address);
+    }
+    hart.reservation_ = {address, value, sizeof(DataType)};
+
+    hart.gprf_.write(hart.currentInstr_->rd, ExtendData(value));
+
+    hart.nextPC();
+
+    execNextInstr(hart);
+}
+
+template <typename DataType> void Hart::execSC(Hart &hart) {
+    RV64Ptr address = hart.gprf_.read(hart.currentInstr_->rs1);
+    if (address % sizeof(DataType) != 0) {
+        raiseMisaligned(hart, EXCEPTION_STORE_ADDR_MISALIGNED);
+        return;
+    }
+
+    DataType value =
+        static_cast<DataType>(hart.gprf_.read(hart.currentInstr_->rs2));
+
+    // SC invalidates the reservation whether it succeeds or not
+    Reservation reservation = hart.reservation_;
+    hart.reservation_.size = 0;
+
+    bool success = false;
+    if (reservation.size == sizeof(DataType) &&
+        reservation.address == address) {
+        if (DataType *data = AtomicHostAddress<DataType>(*hart.mmu_, address)) {
+            DataType expected = static_cast<DataType>(reservation.value);
+            success = __atomic_compare_exchange_n(data, &expected, value, false,
+                                                  __ATOMIC_SEQ_CST,
+                                                  __ATOMIC_SEQ_CST);
+        } else {
+            StoreData(*hart.mmu_, address, value);
+            success = true;
+        }
+    }
+
+    hart.gprf_.write(hart.currentInstr_->rd, success ? 0 : 1);
+
+    hart.nextPC();
+
+    execNextInstr(hart);
+}
+
+template <typename DataType, typename Operation>
+void Hart::execAMO(Hart &hart) {
+    RV64Ptr address = hart.gprf_.read(hart.currentInstr_->rs1);
+    if (address % sizeof(DataType) != 0) {
+        raiseMisaligned(hart, EXCEPTION_STORE_ADDR_MISALIGNED);
+        return;
+    }
+
+    DataType operand =
+        static_cast<DataType>(hart.gprf_.read(hart.currentInstr_->rs2));
+
+    DataType old;
+    if (DataType *data = AtomicHostAddress<DataType>(*hart.mmu_, address)) {
+        old = Operation::Atomic(data, operand);
+    } else {
+        old = LoadData<DataType>(*hart.mmu_, address);
+        StoreData(*hart.mmu_, address, Operation::Apply(old, operand));
+    }
+
+    hart.gprf_.write(hart.currentInstr_->rd, ExtendData(old));
+
+    hart.nextPC();
+
+    execNextInstr(hart);
+}
+
+void Hart::exec_LR_W(Hart &hart) { execLR<RV64UWord>(hart); }
+void Hart::exec_SC_W(Hart &hart) { execSC<RV64UWord>(hart); }
+void Hart::exec_AMOSWAP_W(Hart &hart) {
+    execAMO<RV64UWord, AMOSwap>(hart);
+}
+void Hart::exec_AMOADD_W(Hart &hart) {
+    execAMO<RV64UWord, AMOAdd>(hart);
+}
+void Hart::exec_AMOXOR_W(Hart &hart) {
+    execAMO<RV64UWord, AMOXor>(hart);
+}
+void Hart::exec_AMOAND_W(Hart &hart) {
+    execAMO<RV64UWord, AMOAnd>(hart);
+}
+void Hart::exec_AMOOR_W(Hart &hart) {
+    execAMO<RV64UWord, AMOOr>(hart);
+}
+void Hart::exec_AMOMIN_W(Hart &hart) {
+    execAMO<RV64UWord, AMOMin>(hart);
+}
+void Hart::exec_AMOMAX_W(Hart &hart) {
+    execAMO<RV64UWord, AMOMax>(hart);
+}
+void Hart::exec_AMOMINU_W(Hart &hart) {
+    execAMO<RV64UWord, AMOMinU>(hart);
+}
+void Hart::exec_AMOMAXU_W(Hart &hart) {
+    execAMO<RV64UWord, AMOMaxU>(hart);
+}
+void Hart::exec_LR_D(Hart &hart) { execLR<RV64UDWord>(hart); }
+void Hart::exec_SC_D(Hart &hart) { execSC<RV64UDWord>(hart); }
+void Hart::exec_AMOSWAP_D(Hart &hart) {
+    execAMO<RV64UDWord, AMOSwap>(hart);
+}
+void Hart::exec_AMOADD_D(Hart &hart) {
+    execAMO<RV64UDWord, AMOAdd>(hart);
+}
+void Hart::exec_AMOXOR_D(Hart &hart) {
+    execAMO<RV64UDWord, AMOXor>(hart);
+}
+void Hart::exec_AMOAND_D(Hart &hart) {
+    execAMO<RV64UDWord, AMOAnd>(hart);
+}
+void Hart::exec_AMOOR_D(Hart &hart) {
+    execAMO<RV64UDWord, AMOOr>(hart);
+}
+void Hart::exec_AMOMIN_D(Hart &hart) {
+    execAMO<RV64UDWord, AMOMin>(hart);
+}
+void Hart::exec_AMOMAX_D(Hart &hart) {
+    execAMO<RV64UDWord, AMOMax>(hart);
+}
+void Hart::exec_AMOMINU_D(Hart &hart) {
+    execAMO<RV64UDWord, AMOMinU>(hart);
+}
+void Hart::exec_AMOMAXU_D(Hart &hart) {
+    execAMO<RV64UDWord, AMOMaxU>(hart);
+}
+
 void Hart::nextPC() {
     gprf_.write(exec::GPRF::PC, gprf_.read(exec::GPRF::PC) + IALIGN / 8);
 }
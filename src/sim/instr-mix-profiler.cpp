@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/instr-mix-profiler.hpp"
+
+namespace besm::sim {
+
+namespace {
+
+char const *const OPERATION_NAMES[] = {
+    "inv_op",    "lui",       "auipc",     "jal",       "jalr",
+    "beq",       "bne",       "blt",       "bge",       "bltu",
+    "bgeu",      "lb",        "lh",        "lw",        "lbu",
+    "lhu",       "sb",        "sh",        "sw",        "addi",
+    "slti",      "sltiu",     "xori",      "ori",       "andi",
+    "add",       "sub",       "sll",       "slt",       "sltu",
+    "xor",       "srl",       "sra",       "or",        "and",
+    "fence",     "fence.tso", "pause",     "ecall",     "ebreak",
+    "lwu",       "ld",        "sd",        "slli",      "srli",
+    "srai",      "addiw",     "slliw",     "srliw",     "sraiw",
+    "addw",      "subw",      "sllw",      "srlw",      "sraw",
+    "csrrw",     "csrrs",     "csrrc",     "csrrwi",    "csrrsi",
+    "csrrci",    "sret",      "mret",      "wfi",       "lr.w",
+    "sc.w",      "amoswap.w", "amoadd.w",  "amoxor.w",  "amoand.w",
+    "amoor.w",   "amomin.w",  "amomax.w",  "amominu.w", "amomaxu.w",
+    "lr.d",      "sc.d",      "amoswap.d", "amoadd.d",  "amoxor.d",
+    "amoand.d",  "amoor.d",   "amomin.d",  "amomax.d",  "amominu.d",
+    "amomaxu.d",
+};
+static_assert(std::size(OPERATION_NAMES) == BB_END,
+              "Every operation must have a name");
+
+char const *const CLASS_NAMES[InstrMixProfiler::NUM_CLASSES] = {
+    "alu", "load", "store", "branch", "jump", "atomic", "system",
+};
+
+} // namespace
+
+uint64_t InstrMixProfiler::Mix::getTotal() const {
+    uint64_t total = 0;
+    for (uint64_t count : ops) {
+        total += count;
+    }
+    return total;
+}
+
+uint64_t InstrMixProfiler::Mix::getClassCount(Class instrClass) const {
+    uint64_t count = 0;
+    for (size_t op = 0; op < ops.size(); ++op) {
+        if (GetClass(static_cast<InstructionOp>(op)) == instrClass) {
+            count += ops[op];
+        }
+    }
+    return count;
+}
+
+InstrMixProfiler::Mix &InstrMixProfiler::Mix::operator+=(Mix const &other) {
+    for (size_t op = 0; op < ops.size(); ++op) {
+        ops[op] += other.ops[op];
+    }
+    return *this;
+}
+
+char const *InstrMixProfiler::GetOperationName(InstructionOp op) {
+    return op < BB_END ? OPERATION_NAMES[op] : "bb_end";
+}
+
+char const *InstrMixProfiler::GetClassName(Class instrClass) {
+    return CLASS_NAMES[instrClass];
+}
+
+InstrMixProfiler::Class InstrMixProfiler::GetClass(InstructionOp op) {
+    switch (op) {
+    case LB:
+    case LH:
+    case LW:
+    case LD:
+    case LBU:
+    case LHU:
+    case LWU:
+        return CLASS_LOAD;
+    case SB:
+    case SH:
+    case SW:
+    case SD:
+        return CLASS_STORE;
+    case BEQ:
+    case BNE:
+    case BLT:
+    case BGE:
+    case BLTU:
+    case BGEU:
+        return CLASS_BRANCH;
+    case JAL:
+    case JALR:
+        return CLASS_JUMP;
+    case FENCE:
+    case FENCE_TSO:
+    case PAUSE:
+    case ECALL:
+    case EBREAK:
+    case CSRRW:
+    case CSRRS:
+    case CSRRC:
+    case CSRRWI:
+    case CSRRSI:
+    case CSRRCI:
+    case SRET:
+    case MRET:
+    case WFI:
+        return CLASS_SYSTEM;
+    default:
+        return op >= LR_W && op <= AMOMAXU_D ? CLASS_ATOMIC : CLASS_ALU;
+    }
+}
+
+void InstrMixProfiler::Print(std::ostream &output, Mix const &mix) {
+    uint64_t total = mix.getTotal();
+    auto ratio = [total](uint64_t count) {
+        return total == 0 ? 0 : static_cast<double>(count) / total;
+    };
+
+    output << "[BESM-666] Instruction mix of " << total
+           << " instructions:" << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < NUM_CLASSES; ++i) {
+        Class instrClass = static_cast<Class>(i);
+        output << (i == 0 ? " " : ", ") << GetClassName(instrClass) << ' '
+               << ratio(mix.getClassCount(instrClass)) * 100 << '%';
+    }
+    output << '\n';
+
+    std::vector<size_t> ops;
+    for (size_t op = 0; op < mix.ops.size(); ++op) {
+        if (mix.ops[op] != 0) {
+            ops.push_back(op);
+        }
+    }
+    std::stable_sort(ops.begin(), ops.end(), [&mix](size_t lhs, size_t rhs) {
+        return mix.ops[lhs] > mix.ops[rhs];
+    });
+    for (size_t op : ops) {
+        output << "[BESM-666]   " << std::left << std::setw(10)
+               << GetOperationName(static_cast<InstructionOp>(op))
+               << std::right << std::setw(16) << mix.ops[op] << std::setw(8)
+               << ratio(mix.ops[op]) * 100 << "%\n";
+    }
+    output << std::defaultfloat << std::setprecision(6);
+    output.flush();
+}
+
+void InstrMixProfiler::WriteJSON(std::ostream &output, Mix const &mix) {
+    uint64_t total = mix.getTotal();
+
+    output << "{\"instructions\": " << total << ", \"classes\": {";
+    for (size_t i = 0; i < NUM_CLASSES; ++i) {
+        output << (i == 0 ? "" : ", ") << '"'
+               << GetClassName(static_cast<Class>(i))
+               << "\": " << mix.getClassCount(static_cast<Class>(i));
+    }
+    output << "}, \"ratios\": {";
+    for (size_t i = 0; i < NUM_CLASSES; ++i) {
+        uint64_t count = mix.getClassCount(static_cast<Class>(i));
+        output << (i == 0 ? "" : ", ") << '"'
+               << GetClassName(static_cast<Class>(i)) << "\": "
+               << (total == 0 ? 0 : static_cast<double>(count) / total);
+    }
+    output << "}, \"operations\": {";
+    bool first = true;
+    for (size_t op = 0; op < mix.ops.size(); ++op) {
+        if (mix.ops[op] != 0) {
+            output << (first ? "" : ", ") << '"'
+                   << GetOperationName(static_cast<InstructionOp>(op))
+                   << "\": " << mix.ops[op];
+            first = false;
+        }
+    }
+    output << "}}";
+}
+
+InstrMixProfiler::InstrMixProfiler() : last_(nullptr), lastInstrs_(0) {}
+
+void InstrMixProfiler::onBlockFetch(Hart const &hart,
+                                    exec::BasicBlock const &bb) {
+    this->account(hart.getInstrsExecuted());
+
+    last_ = &bb;
+    size_t id = bb.getId();
+    if (id >= runs_.size()) {
+        size_t size = std::max(id + 1, runs_.size() * 2);
+        runs_.resize(size);
+        blocks_.resize(size);
+    }
+    blocks_[id] = &bb;
+}
+
+void InstrMixProfiler::finish(Hart const &hart) {
+    this->account(hart.getInstrsExecuted());
+    last_ = nullptr;
+}
+
+void InstrMixProfiler::account(size_t instrsExecuted) {
+    size_t instrs = instrsExecuted - lastInstrs_;
+    lastInstrs_ = instrsExecuted;
+    if (last_ == nullptr || instrs == 0) {
+        return;
+    }
+
+    if (instrs >= last_->getSize()) {
+        ++runs_[last_->getId()];
+        return;
+    }
+    Instruction const *instr = last_->getInstructions();
+    for (size_t i = 0; i < instrs; ++i) {
+        ++partial_.ops[instr[i].operation];
+    }
+}
+
+InstrMixProfiler::Mix InstrMixProfiler::getMix() const {
+    Mix mix = partial_;
+    for (size_t id = 0; id < runs_.size(); ++id) {
+        if (runs_[id] == 0) {
+            continue;
+        }
+        exec::BasicBlock const &bb = *blocks_[id];
+        Instruction const *instr = bb.getInstructions();
+        for (size_t i = 0; i < bb.getSize(); ++i) {
+            mix.ops[instr[i].operation] += runs_[id];
+        }
+    }
+    return mix;
+}
+
+} // namespace besm::sim
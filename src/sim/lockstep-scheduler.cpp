@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "besm-666/sim/lockstep-scheduler.hpp"
+
+namespace besm::sim {
+
+LockstepScheduler::LockstepScheduler(std::vector<Hart::SPtr> harts,
+                                     size_t numThreads, size_t quantum,
+                                     uint64_t seed, mem::CLINT::SPtr clint)
+    : harts_(std::move(harts)), runTimes_(harts_.size()),
+      states_(harts_.size(), RUNNABLE), reasons_(harts_.size()),
+      errors_(harts_.size()), numThreads_(std::min(numThreads, harts_.size())),
+      quantum_(quantum), seed_(seed), random_(seed), clint_(std::move(clint)),
+      roundTime_(0), round_(0), pendingThreads_(0), exit_(false) {
+    if (numThreads_ == 0) {
+        throw std::invalid_argument("Invalid scheduler threads number");
+    }
+    if (quantum_ == 0) {
+        throw std::invalid_argument("Invalid scheduler quantum");
+    }
+    if (clint_ != nullptr && numThreads_ > 1) {
+        clint_->setTimeSource(&roundTime_);
+    }
+}
+
+LockstepScheduler::~LockstepScheduler() {
+    if (clint_ != nullptr && numThreads_ > 1) {
+        clint_->setTimeSource(nullptr);
+    }
+}
+
+void LockstepScheduler::runUntil(RV64Ptr stopPC) {
+    std::fill(states_.begin(), states_.end(), RUNNABLE);
+    round_ = 0;
+    exit_ = false;
+
+    std::vector<std::thread> threads;
+    for (size_t threadId = 1; threadId < numThreads_; ++threadId) {
+        threads.emplace_back(&LockstepScheduler::threadLoop, this, threadId,
+                             stopPC);
+    }
+
+    std::exception_ptr error;
+    while (error == nullptr) {
+        order_.clear();
+        bool parked = false;
+        for (size_t hartId = 0; hartId < harts_.size(); ++hartId) {
+            if (states_[hartId] == PARKED &&
+                harts_[hartId]->wakeUpPending()) {
+                states_[hartId] = RUNNABLE;
+            }
+            if (states_[hartId] == RUNNABLE) {
+                order_.push_back(hartId);
+            }
+            parked |= states_[hartId] == PARKED;
+        }
+
+        if (order_.empty()) {
+            if (!parked) {
+                break;
+            }
+            // Only a device can wake the harts up
+            std::this_thread::sleep_for(kIdleTimeout);
+            continue;
+        }
+
+        this->shuffleOrder();
+        this->runRound(stopPC);
+
+        // Handled in the round order, so the first error is deterministic
+        for (size_t hartId : order_) {
+            if (errors_[hartId] != nullptr && error == nullptr) {
+                error = std::exchange(errors_[hartId], nullptr);
+            }
+
+            switch (reasons_[hartId]) {
+            case Hart::YIELD_QUANTUM:
+            case Hart::YIELD_PAUSE:
+                break;
+            case Hart::YIELD_WFI:
+                states_[hartId] = PARKED;
+                break;
+            case Hart::YIELD_NONE:
+                states_[hartId] = STOPPED;
+                // The guest has finished, the other harts would never stop
+                // themselves
+                if (harts_[hartId]->getGPRF().read(exec::GPRF::PC) !=
+                    stopPC) {
+                    for (auto const &hart : harts_) {
+                        hart->requestStop();
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(roundMutex_);
+        exit_ = true;
+    }
+    roundStart_.notify_all();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (error != nullptr) {
+        for (auto const &hart : harts_) {
+            hart->requestStop();
+        }
+        std::rethrow_exception(error);
+    }
+}
+
+std::chrono::duration<double>
+LockstepScheduler::getRunTime(size_t hartId) const {
+    return runTimes_.at(hartId);
+}
+
+void LockstepScheduler::threadLoop(size_t threadId, RV64Ptr stopPC) {
+    size_t round = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(roundMutex_);
+            roundStart_.wait(lock, [&] { return round_ != round || exit_; });
+            if (exit_) {
+                return;
+            }
+            round = round_;
+        }
+
+        this->runShare(threadId, stopPC);
+
+        std::lock_guard<std::mutex> lock(roundMutex_);
+        if (--pendingThreads_ == 0) {
+            roundEnd_.notify_one();
+        }
+    }
+}
+
+void LockstepScheduler::runRound(RV64Ptr stopPC) {
+    if (numThreads_ == 1) {
+        this->runShare(0, stopPC);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(roundMutex_);
+        ++round_;
+        pendingThreads_ = numThreads_ - 1;
+    }
+    roundStart_.notify_all();
+
+    this->runShare(0, stopPC);
+
+    std::unique_lock<std::mutex> lock(roundMutex_);
+    roundEnd_.wait(lock, [this] { return pendingThreads_ == 0; });
+    // Not the clock of some hart, which could stop or wait for an interrupt
+    roundTime_.fetch_add(quantum_, std::memory_order_relaxed);
+    if (clint_ != nullptr) {
+        clint_->expireTimers();
+    }
+}
+
+/**
+ * A hart always runs on the same thread, so its caches stay warm
+ */
+void LockstepScheduler::runShare(size_t threadId, RV64Ptr stopPC) {
+    for (size_t hartId : order_) {
+        if (hartId % numThreads_ == threadId) {
+            this->runSlice(hartId, stopPC);
+        }
+    }
+}
+
+void LockstepScheduler::runSlice(size_t hartId, RV64Ptr stopPC) {
+    reasons_[hartId] = Hart::YIELD_NONE;
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+        reasons_[hartId] = harts_[hartId]->runSlice(stopPC, quantum_);
+    } catch (...) {
+        errors_[hartId] = std::current_exception();
+    }
+    runTimes_[hartId] += std::chrono::steady_clock::now() - start;
+}
+
+/**
+ * Fisher-Yates shuffle: unlike std::shuffle, the result is the same with
+ * any standard library
+ */
+void LockstepScheduler::shuffleOrder() {
+    if (seed_ == 0) {
+        return;
+    }
+    for (size_t i = order_.size(); i > 1; --i) {
+        std::swap(order_[i - 1], order_[random_() % i]);
+    }
+}
+
+} // namespace besm::sim
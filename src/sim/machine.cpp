@@ -1,33 +1,414 @@
+#include <algorithm>
+#include <cctype>
+#include <exception>
+#include <stdexcept>
+#include <mutex>
+#include <ostream>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+
 #include "besm-666/sim/machine.hpp"
 #include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/util/elf-parser.hpp"
+#include "besm-666/util/tracer.hpp"
 
 namespace besm::sim {
 
-Machine::Machine(sim::Config const &config) {
-    std::clog << "[BESM] Creating memory system..." << std::endl;
+namespace {
+
+/// Fails every write, a stream per thread as failing sets its state
+std::ostream &NullLog() {
+    thread_local std::ostream null(nullptr);
+    return null;
+}
+
+} // namespace
+
+Machine::Machine(sim::Config const &config,
+                 mem::RAMChunkPool::SPtr ramChunkPool) {
+    util::TraceSpan span("machine.create");
+    std::ostream &log = config.verbose() ? std::clog : NullLog();
+
+    std::unique_ptr<util::IElfParser> elf;
+    {
+        util::TraceSpan parseSpan("elf.parse");
+        elf = util::createParser(config.executablePath());
+        symtab_ = elf->getSymtab();
+    }
+
+    log << "[BESM] Creating memory system..." << std::endl;
     mem::PhysMemBuilder pMemBuilder;
+    pMemBuilder.setRAMChunkPool(std::move(ramChunkPool));
 
-    std::clog << "[BESM] MEMORY: RAM page size is " << config.ramPageSize()
-              << std::endl;
-    std::clog << "[BESM] MEMORY: RAM chunk size is " << config.ramChunkSize()
-              << std::endl;
+    log << "[BESM] MEMORY: RAM page size is " << config.ramPageSize()
+        << std::endl;
+    log << "[BESM] MEMORY: RAM chunk size is " << config.ramChunkSize()
+        << std::endl;
     for (auto range : config.ramRanges()) {
-        std::clog << "[BESM] MEMORY: Added RAM range [" << range.leftBorder()
-                  << ", " << range.size() << ")" << std::endl;
+        log << "[BESM] MEMORY: Added RAM range [" << range.leftBorder() << ", "
+            << range.size() << ")" << std::endl;
         pMemBuilder.mapRAM(range.leftBorder(), range.size(),
                            config.ramPageSize(), config.ramChunkSize());
     }
 
+    htif_ = MakeHTIF(*elf);
+    if (htif_ != nullptr) {
+        log << "[BESM] MEMORY: Added HTIF at " << std::hex
+            << htif_->getBaseAddress() << std::dec << std::endl;
+        pMemBuilder.mapHTIF(htif_);
+    }
+
+    if (config.uartAddress().has_value()) {
+        log << "[BESM] MEMORY: Added UART at " << std::hex
+            << *config.uartAddress() << std::dec << std::endl;
+        uart_ = mem::UART::Create(config.uartInputPath());
+        pMemBuilder.mapUART(*config.uartAddress(), uart_);
+    }
+
+    if (config.timerAddress().has_value()) {
+        log << "[BESM] MEMORY: Added CLINT at " << std::hex
+            << *config.timerAddress() << std::dec << ", "
+            << config.timerFrequency() << " Hz" << std::endl;
+        clint_ =
+            mem::CLINT::Create(config.numHarts(), config.timerFrequency());
+        pMemBuilder.mapTimer(*config.timerAddress(), clint_);
+    }
+
     pMem_ = pMemBuilder.build();
+    uint64_t codeHash = HashCode(*elf);
+    sharedImage_ = mem::SharedImage::Get(*elf, codeHash, config.ramPageSize());
+    if (sharedImage_ != nullptr) {
+        mem::PhysMemLoader(pMem_).loadElf(*elf, *sharedImage_);
+    } else {
+        mem::PhysMemLoader(pMem_).loadElf(*elf);
+    }
 
-    mem::PhysMemLoader(pMem_).loadElf(config.executablePath());
+    // The harts of a machine always share the decoded blocks
+    exec::SharedBasicBlockCache::SPtr codeCache =
+        config.sharedCodeCache() ? exec::SharedBasicBlockCache::Global()
+                                 : exec::SharedBasicBlockCache::Create();
 
     hookManager_ = sim::HookManager::Create();
-    hart_ = sim::Hart::Create(pMem_, hookManager_);
+    log << "[BESM] Creating " << config.numHarts() << " hart(s)..."
+        << std::endl;
+    for (size_t hartId = 0; hartId < config.numHarts(); ++hartId) {
+        sim::Hart::SPtr hart = sim::Hart::Create(pMem_, hookManager_, hartId);
+        if (htif_ != nullptr) {
+            hart->attachHTIF(htif_);
+        }
+        if (clint_ != nullptr) {
+            hart->attachCLINT(clint_);
+        }
+        hart->attachCodeCache(codeCache, codeHash);
+        harts_.push_back(std::move(hart));
+    }
+    runTimes_.resize(harts_.size());
+    this->registerStats(codeCache);
+    hartAffinity_ = config.hartAffinity();
+    if (harts_.size() > 1 && config.deterministic()) {
+        size_t numThreads = std::max<size_t>(config.hostThreads(), 1);
+        log << "[BESM] Interleaving harts deterministically on " << numThreads
+            << " host thread(s), quantum is " << config.hartQuantum()
+            << " instructions, seed is " << config.schedulerSeed()
+            << std::endl;
+        scheduler_ = std::make_unique<LockstepScheduler>(
+            harts_, numThreads, config.hartQuantum(), config.schedulerSeed(),
+            clint_);
+    } else if (harts_.size() > 1 && config.hostThreads() != 0) {
+        log << "[BESM] Scheduling harts onto " << config.hostThreads()
+            << " host thread(s), quantum is " << config.hartQuantum()
+            << " instructions" << std::endl;
+        scheduler_ = std::make_unique<WorkStealingScheduler>(
+            harts_, config.hostThreads(), config.hartQuantum());
+    }
+
+    // No PLIC, the external interrupt is routed to the boot hart
+    if (uart_ != nullptr) {
+        uart_->connectInterrupt(harts_.front()->getInterruptsPending());
+    }
+
+    if (config.userMode()) {
+        log << "[BESM] Setting up user-mode Linux personality..." << std::endl;
+        syscalls_ = SyscallEmulator::Create(MakeProcessImage(config, *elf));
+        harts_.front()->attachSyscallEmulator(syscalls_);
+    }
 }
 
-void Machine::run() { hart_->run(); }
+/**
+ * The harts count their fetches and traps themselves, the shared subsystems
+ * are sampled by gauges holding them, so the registry may outlive the
+ * machine. The harts hold the registry, their gauge holds them weakly.
+ */
+void Machine::registerStats(
+    exec::SharedBasicBlockCache::SPtr const &codeCache) {
+    stats_ = Stats::Create(harts_.size());
+    for (auto const &hart : harts_) {
+        hart->attachStats(stats_);
+    }
+
+    stats_->gauge("hart.instructions", "Instructions executed by the harts",
+                  [harts = std::vector<std::weak_ptr<Hart const>>(
+                       harts_.begin(), harts_.end())] {
+                      size_t instrs = 0;
+                      for (auto const &weakHart : harts) {
+                          if (auto hart = weakHart.lock()) {
+                              instrs += hart->getInstrsExecuted();
+                          }
+                      }
+                      return static_cast<double>(instrs);
+                  });
+    stats_->gauge("code_cache.blocks", "Decoded basic blocks in the cache",
+                  [codeCache] {
+                      return static_cast<double>(codeCache->getBlocksNum());
+                  });
+
+    std::vector<std::shared_ptr<mem::RAM const>> rams;
+    for (auto const &descriptor : pMem_->getDevices()) {
+        auto const &device = descriptor.device;
+        if (device->getType() == mem::IPhysMemDevice::RAM) {
+            rams.push_back(std::static_pointer_cast<mem::RAM const>(device));
+            continue;
+        }
 
-sim::Hart const &Machine::getHart() const { return *hart_; }
+        std::string type = device->getTypeName();
+        std::transform(type.begin(), type.end(), type.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        stats_->gauge("phys_mem." + type + ".accesses",
+                      "Register accesses of the device", [device] {
+                          return static_cast<double>(device->getAccessesNum());
+                      });
+    }
+    stats_->gauge("ram.pages_touched", "RAM pages backed by host memory",
+                  [rams] {
+                      size_t pages = 0;
+                      for (auto const &ram : rams) {
+                          pages += ram->getPagesTouched();
+                      }
+                      return static_cast<double>(pages);
+                  });
+    stats_->gauge("ram_page_allocator.chunks", "RAM chunks mapped",
+                  [rams] {
+                      size_t chunks = 0;
+                      for (auto const &ram : rams) {
+                          chunks += ram->getChunksNum();
+                      }
+                      return static_cast<double>(chunks);
+                  });
+
+    stats_->gauge("hooks.bb_fetch", "Basic block fetch hooks",
+                  [hooks = hookManager_] {
+                      return static_cast<double>(hooks->getBBFetchHooksNum());
+                  });
+    stats_->gauge("hooks.instr_exec", "Instruction execution hooks",
+                  [hooks = hookManager_] {
+                      return static_cast<double>(
+                          hooks->getInstrExecHooksNum());
+                  });
+}
+
+SyscallEmulator::ProcessImage
+Machine::MakeProcessImage(sim::Config const &config, util::IElfParser &elf) {
+    SyscallEmulator::ProcessImage image = {
+        .entry = elf.getEntryPoint(),
+        .programHeaders = elf.getProgramHeaders(),
+        .imageEnd = 0,
+        .stackTop = 0,
+        .args = {config.executablePath().string()},
+    };
+
+    for (auto const &segment : elf.getLoadableSegments()) {
+        image.imageEnd =
+            std::max(image.imageEnd, segment.address + segment.memSize);
+    }
+    for (auto range : config.ramRanges()) {
+        image.stackTop = std::max(image.stackTop, range.rightBorder());
+    }
+    image.args.insert(image.args.end(), config.guestArgs().begin(),
+                      config.guestArgs().end());
+
+    return image;
+}
+
+/**
+ * FNV-1a of the loaded image: the machines running the same program share
+ * the decoded blocks
+ */
+uint64_t Machine::HashCode(util::IElfParser &elf) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    auto mix = [&hash](void const *data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<unsigned char const *>(data)[i];
+            hash *= 0x100000001B3ull;
+        }
+    };
+
+    for (auto const &segment : elf.getLoadableSegments()) {
+        mix(&segment.address, sizeof(segment.address));
+        mix(&segment.size, sizeof(segment.size));
+        mix(segment.data, segment.size);
+    }
+    return hash;
+}
+
+mem::HTIF::SPtr Machine::MakeHTIF(util::IElfParser &elf) {
+    std::optional<RV64Ptr> tohost;
+    std::optional<RV64Ptr> fromhost;
+    for (auto const &symbol : elf.getSymbols()) {
+        if (symbol.name == "tohost") {
+            tohost = symbol.address;
+        } else if (symbol.name == "fromhost") {
+            fromhost = symbol.address;
+        }
+    }
+
+    if (!tohost.has_value()) {
+        return nullptr;
+    }
+    return mem::HTIF::Create(*tohost, fromhost);
+}
+
+std::optional<int> Machine::getExitCode() const {
+    if (syscalls_ != nullptr && syscalls_->exited()) {
+        return syscalls_->exitCode();
+    }
+    if (htif_ != nullptr && htif_->exited()) {
+        return htif_->exitCode();
+    }
+    return std::nullopt;
+}
+
+void Machine::run() { this->runUntil(sim::Hart::kNoStopPC); }
+
+void Machine::runUntil(RV64Ptr stopPC) {
+    if (harts_.size() == 1) {
+        this->runHart(0, stopPC);
+        return;
+    }
+    if (scheduler_ != nullptr) {
+        scheduler_->runUntil(stopPC);
+        return;
+    }
+
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    std::vector<std::thread> threads;
+    for (size_t hartId = 0; hartId < harts_.size(); ++hartId) {
+        threads.emplace_back([&, hartId] {
+            try {
+                this->runHart(hartId, stopPC);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (error == nullptr) {
+                    error = std::current_exception();
+                }
+                for (auto const &hart : harts_) {
+                    hart->requestStop();
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+}
+
+bool Machine::runFor(size_t maxInstrs) {
+    if (harts_.size() != 1) {
+        throw std::invalid_argument("Instruction budget needs a single hart");
+    }
+    sim::Hart &hart = *harts_.front();
+
+    // PAUSE and WFI end a slice early, the budget is the whole run
+    auto start = std::chrono::steady_clock::now();
+    sim::Hart::YieldReason reason = sim::Hart::YIELD_QUANTUM;
+    while (reason != sim::Hart::YIELD_NONE &&
+           hart.getInstrsExecuted() < maxInstrs) {
+        reason = hart.runSlice(sim::Hart::kNoStopPC,
+                               maxInstrs - hart.getInstrsExecuted());
+    }
+    runTimes_.front() += std::chrono::steady_clock::now() - start;
+
+    return reason == sim::Hart::YIELD_NONE;
+}
+
+void Machine::afterFork() {
+    if (uart_ != nullptr) {
+        uart_->afterFork();
+    }
+}
+
+void Machine::attachProfiler(size_t hartId, IBlockProfiler *profiler) {
+    harts_.at(hartId)->attachProfiler(profiler);
+}
+
+void Machine::requestStop() {
+    for (auto const &hart : harts_) {
+        hart->requestStop();
+    }
+}
+
+void Machine::runHart(size_t hartId, RV64Ptr stopPC) {
+    if (!hartAffinity_.empty()) {
+        SetAffinity(hartAffinity_[hartId]);
+    }
+
+    sim::Hart &hart = *harts_[hartId];
+    if (harts_.size() > 1) {
+        util::Tracer::SetThreadName("hart " + std::to_string(hartId));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        util::TraceSpan span("hart.run");
+        hart.runUntil(stopPC);
+    }
+    runTimes_[hartId] += std::chrono::steady_clock::now() - start;
+
+    // The guest has finished, the other harts would never stop themselves
+    if (harts_.size() > 1 && hart.getGPRF().read(exec::GPRF::PC) != stopPC) {
+        for (auto const &other : harts_) {
+            other->requestStop();
+        }
+    }
+}
+
+void Machine::SetAffinity(int cpu) {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+
+    int error =
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (error != 0) {
+        std::clog << "[BESM] Failed to pin hart thread to CPU " << cpu
+                  << ", error " << error << std::endl;
+    }
+}
+
+size_t Machine::getInstrsExecuted() const {
+    size_t instrs = 0;
+    for (auto const &hart : harts_) {
+        instrs += hart->getInstrsExecuted();
+    }
+    return instrs;
+}
+
+std::chrono::duration<double> Machine::getRunTime(size_t hartId) const {
+    if (scheduler_ != nullptr) {
+        return scheduler_->getRunTime(hartId);
+    }
+    return runTimes_.at(hartId);
+}
+
+sim::Hart const &Machine::getHart() const { return *harts_.front(); }
+sim::Hart const &Machine::getHart(size_t hartId) const {
+    return *harts_.at(hartId);
+}
 
 } // namespace besm::sim
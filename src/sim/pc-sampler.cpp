@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <stdexcept>
+
+#include "besm-666/exec/csrf.hpp"
+#include "besm-666/sim/pc-sampler.hpp"
+
+namespace besm::sim {
+
+namespace {
+
+/// The running sampler, read by the signal handler
+std::atomic<PCSampler *> ActiveSampler{nullptr};
+/// Handlers which may still use the sampler being stopped
+std::atomic<int> ActiveHandlers{0};
+
+char const *const PRIVILEGE_NAMES[PCSampler::kNumPrivileges] = {
+    "U", "S", "H", "M",
+};
+
+} // namespace
+
+std::vector<PCSampler::Entry>
+PCSampler::Symbolize(util::Symtab const &symtab,
+                     std::vector<Sample> const &samples) {
+    // Keyed by the symbol address, unknown code is gathered at 0
+    std::map<RV64Ptr, Entry> functions;
+    for (Sample const &sample : samples) {
+        util::Symtab::Entry const *symbol = symtab.lookup(sample.pc);
+        RV64Ptr address = symbol == nullptr ? 0 : symbol->address;
+        auto [it, inserted] = functions.try_emplace(
+            address,
+            Entry{.name = symbol == nullptr ? "[unknown]" : symbol->name,
+                  .address = address,
+                  .counts = {},
+                  .total = 0});
+        it->second.counts[sample.privilege] += sample.count;
+        it->second.total += sample.count;
+    }
+
+    std::vector<Entry> profile;
+    profile.reserve(functions.size());
+    for (auto &[address, entry] : functions) {
+        profile.push_back(std::move(entry));
+    }
+    std::stable_sort(profile.begin(), profile.end(),
+                     [](Entry const &lhs, Entry const &rhs) {
+                         return lhs.total > rhs.total;
+                     });
+    return profile;
+}
+
+void PCSampler::Print(std::ostream &output, std::vector<Entry> const &profile,
+                      size_t topN) {
+    uint64_t total = 0;
+    for (Entry const &entry : profile) {
+        total += entry.total;
+    }
+
+    size_t shown = std::min(topN, profile.size());
+    output << "[BESM-666] PC samples: " << total << ", top " << shown
+           << " of " << profile.size() << " functions:\n"
+           << "[BESM-666]     self         U         S         M  function\n"
+           << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < shown; ++i) {
+        Entry const &entry = profile[i];
+        output << "[BESM-666] " << std::setw(7)
+               << (total == 0 ? 0 : 100.0 * entry.total / total) << "% "
+               << std::setw(9) << entry.counts[exec::PRIVILLEGE_USER] << ' '
+               << std::setw(9) << entry.counts[exec::PRIVILLEGE_SUPERVISOR]
+               << ' ' << std::setw(9) << entry.counts[exec::PRIVILLEGE_MACHINE]
+               << "  " << entry.name;
+        if (entry.address != 0) {
+            output << " (0x" << std::hex << entry.address << std::dec << ')';
+        }
+        output << '\n';
+    }
+    output << std::defaultfloat << std::setprecision(6);
+    output.flush();
+}
+
+void PCSampler::WriteFolded(std::ostream &output,
+                            std::vector<Entry> const &profile) {
+    for (Entry const &entry : profile) {
+        for (size_t privilege = 0; privilege < kNumPrivileges; ++privilege) {
+            if (entry.counts[privilege] != 0) {
+                output << PRIVILEGE_NAMES[privilege] << ';' << entry.name
+                       << ' ' << entry.counts[privilege] << '\n';
+            }
+        }
+    }
+}
+
+PCSampler::PCSampler(unsigned frequency)
+    : frequency_(frequency), slots_(new Slot[kSlots]), samples_(0),
+      dropped_(0), running_(false), timer_{}, previousAction_{} {
+    if (frequency_ == 0) {
+        throw std::invalid_argument("Invalid sampling frequency");
+    }
+    for (size_t i = 0; i < kSlots; ++i) {
+        slots_[i].key.store(0, std::memory_order_relaxed);
+        slots_[i].count.store(0, std::memory_order_relaxed);
+    }
+}
+
+PCSampler::~PCSampler() { this->stop(); }
+
+bool PCSampler::start(std::vector<Hart const *> const &harts) {
+    if (running_) {
+        return true;
+    }
+
+    PCSampler *expected = nullptr;
+    if (!ActiveSampler.compare_exchange_strong(expected, this)) {
+        error_ = "Another PC sampler runs";
+        return false;
+    }
+    words_.clear();
+    for (Hart const *hart : harts) {
+        words_.push_back(&hart->getBlockWord());
+    }
+
+    struct sigaction action = {};
+    action.sa_handler = &PCSampler::HandleSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &previousAction_);
+
+    struct sigevent event = {};
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGPROF;
+    if (timer_create(CLOCK_MONOTONIC, &event, &timer_) != 0) {
+        error_ = std::string("timer_create: ") + std::strerror(errno);
+        sigaction(SIGPROF, &previousAction_, nullptr);
+        ActiveSampler.store(nullptr);
+        return false;
+    }
+
+    long period = 1'000'000'000L / frequency_;
+    struct itimerspec spec = {};
+    spec.it_value.tv_sec = period / 1'000'000'000L;
+    spec.it_value.tv_nsec = std::max(period % 1'000'000'000L, 1L);
+    spec.it_interval = spec.it_value;
+    timer_settime(timer_, 0, &spec, nullptr);
+
+    running_ = true;
+    return true;
+}
+
+void PCSampler::stop() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+
+    timer_delete(timer_);
+    // Ignoring the signal discards a pending one, which the previous
+    // disposition could take as fatal
+    struct sigaction ignore = {};
+    ignore.sa_handler = SIG_IGN;
+    sigemptyset(&ignore.sa_mask);
+    sigaction(SIGPROF, &ignore, nullptr);
+    sigaction(SIGPROF, &previousAction_, nullptr);
+
+    ActiveSampler.store(nullptr);
+    while (ActiveHandlers.load() != 0) {
+    }
+}
+
+std::vector<PCSampler::Sample> PCSampler::getSamples() const {
+    std::vector<Sample> samples;
+    for (size_t i = 0; i < kSlots; ++i) {
+        uint64_t key = slots_[i].key.load(std::memory_order_relaxed);
+        if (key == 0) {
+            continue;
+        }
+        uint64_t word = key - 1;
+        samples.push_back(
+            Sample{.pc = Hart::GetBlockWordPC(word),
+                   .privilege = Hart::GetBlockWordPrivilege(word),
+                   .count = slots_[i].count.load(std::memory_order_relaxed)});
+    }
+    std::sort(samples.begin(), samples.end(),
+              [](Sample const &lhs, Sample const &rhs) {
+                  return lhs.count != rhs.count ? lhs.count > rhs.count
+                                                : lhs.pc < rhs.pc;
+              });
+    return samples;
+}
+
+uint64_t PCSampler::getSamplesNum() const {
+    return samples_.load(std::memory_order_relaxed);
+}
+
+uint64_t PCSampler::getDroppedNum() const {
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+/// Async-signal-safe: atomics only, no allocation
+void PCSampler::HandleSignal(int) {
+    int savedErrno = errno;
+    ActiveHandlers.fetch_add(1);
+    PCSampler *sampler = ActiveSampler.load();
+    if (sampler != nullptr) {
+        sampler->sample();
+    }
+    ActiveHandlers.fetch_sub(1);
+    errno = savedErrno;
+}
+
+void PCSampler::sample() {
+    for (std::atomic<uint64_t> const *word : words_) {
+        this->record(word->load(std::memory_order_relaxed));
+    }
+}
+
+void PCSampler::record(uint64_t word) {
+    uint64_t key = word + 1;
+    size_t hash = ((word >> 2) * 0x9e3779b97f4a7c15ULL) >> (64 - kSlotsLog);
+    for (size_t probe = 0; probe < kMaxProbes; ++probe) {
+        Slot &slot = slots_[(hash + probe) & (kSlots - 1)];
+        uint64_t current = slot.key.load(std::memory_order_relaxed);
+        if (current == 0 &&
+            slot.key.compare_exchange_strong(current, key,
+                                             std::memory_order_relaxed)) {
+            current = key;
+        }
+        if (current == key) {
+            slot.count.fetch_add(1, std::memory_order_relaxed);
+            samples_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace besm::sim
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "besm-666/sim/stats.hpp"
+
+namespace besm::sim {
+
+namespace {
+
+std::string PrometheusName(std::string const &name) {
+    std::string result = "besm666_" + name;
+    std::replace(result.begin(), result.end(), '.', '_');
+    return result;
+}
+
+/// Counts sampled by gauges are printed exactly, not in the stream precision
+void WriteGaugeValue(std::ostream &output, double value) {
+    if (value >= 0 && value < 0x1p64 &&
+        value == static_cast<double>(static_cast<uint64_t>(value))) {
+        output << static_cast<uint64_t>(value);
+    } else {
+        output << value;
+    }
+}
+
+template <typename Stat>
+Stat const *Find(std::deque<Stat> const &stats, std::string const &name) {
+    for (Stat const &stat : stats) {
+        if (stat.getName() == name) {
+            return &stat;
+        }
+    }
+    return nullptr;
+}
+
+template <typename Stat>
+Stat &FindOrEmplace(std::deque<Stat> &stats, std::string const &name,
+                    std::string const &help, size_t numShards) {
+    Stat const *stat = Find(stats, name);
+    if (stat != nullptr) {
+        return const_cast<Stat &>(*stat);
+    }
+    return stats.emplace_back(name, help, numShards);
+}
+
+} // namespace
+
+Stats::Counter::Counter(std::string name, std::string help, size_t numShards)
+    : name_(std::move(name)), help_(std::move(help)),
+      shards_(new Shard[numShards]), numShards_(numShards) {}
+
+uint64_t Stats::Counter::read() const noexcept {
+    uint64_t value = 0;
+    for (size_t shard = 0; shard < numShards_; ++shard) {
+        value += shards_[shard].value.load(std::memory_order_relaxed);
+    }
+    return value;
+}
+
+Stats::Histogram::Histogram(std::string name, std::string help,
+                            size_t numShards)
+    : name_(std::move(name)), help_(std::move(help)),
+      shards_(new Shard[numShards]), numShards_(numShards) {}
+
+Stats::Histogram::Snapshot Stats::Histogram::read() const noexcept {
+    Snapshot snapshot;
+    for (size_t shard = 0; shard < numShards_; ++shard) {
+        Shard const &slot = shards_[shard];
+        for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+            uint64_t count =
+                slot.buckets[bucket].load(std::memory_order_relaxed);
+            snapshot.buckets[bucket] += count;
+            snapshot.count += count;
+        }
+        snapshot.sum += slot.sum.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+Stats::Gauge::Gauge(std::string name, std::string help, Callback callback)
+    : name_(std::move(name)), help_(std::move(help)),
+      callback_(std::move(callback)) {}
+
+Stats::SPtr Stats::Create(size_t numShards) {
+    return SPtr(new Stats(numShards));
+}
+
+Stats::Stats(size_t numShards) : numShards_(numShards) {
+    if (numShards_ == 0) {
+        throw std::invalid_argument("Invalid stats shards number");
+    }
+}
+
+Stats::Counter &Stats::counter(std::string const &name,
+                               std::string const &help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return FindOrEmplace(counters_, name, help, numShards_);
+}
+
+Stats::Histogram &Stats::histogram(std::string const &name,
+                                   std::string const &help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return FindOrEmplace(histograms_, name, help, numShards_);
+}
+
+void Stats::gauge(std::string const &name, std::string const &help,
+                  Gauge::Callback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Find(gauges_, name) != nullptr) {
+        throw std::invalid_argument("Gauge " + name + " is already registered");
+    }
+    gauges_.emplace_back(name, help, std::move(callback));
+}
+
+Stats::Counter const *Stats::findCounter(std::string const &name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Find(counters_, name);
+}
+
+Stats::Histogram const *Stats::findHistogram(std::string const &name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Find(histograms_, name);
+}
+
+Stats::Gauge const *Stats::findGauge(std::string const &name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Find(gauges_, name);
+}
+
+void Stats::writeJSON(std::ostream &output) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    output << "{\"counters\": {";
+    for (size_t i = 0; i < counters_.size(); ++i) {
+        output << (i == 0 ? "" : ", ") << '"' << counters_[i].getName()
+               << "\": " << counters_[i].read();
+    }
+
+    output << "}, \"gauges\": {";
+    for (size_t i = 0; i < gauges_.size(); ++i) {
+        output << (i == 0 ? "" : ", ") << '"' << gauges_[i].getName()
+               << "\": ";
+        WriteGaugeValue(output, gauges_[i].read());
+    }
+
+    output << "}, \"histograms\": {";
+    for (size_t i = 0; i < histograms_.size(); ++i) {
+        Histogram::Snapshot snapshot = histograms_[i].read();
+        output << (i == 0 ? "" : ", ") << '"' << histograms_[i].getName()
+               << "\": {\"count\": " << snapshot.count
+               << ", \"sum\": " << snapshot.sum << ", \"buckets\": [";
+        for (size_t bucket = 0; bucket < Histogram::kBuckets; ++bucket) {
+            output << (bucket == 0 ? "" : ", ") << "{\"le\": ";
+            if (bucket + 1 == Histogram::kBuckets) {
+                output << "null";
+            } else {
+                output << Histogram::GetBucketBound(bucket);
+            }
+            output << ", \"count\": " << snapshot.buckets[bucket] << '}';
+        }
+        output << "]}";
+    }
+    output << "}}";
+}
+
+void Stats::writePrometheus(std::ostream &output) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (Counter const &counter : counters_) {
+        std::string name = PrometheusName(counter.getName()) + "_total";
+        output << "# HELP " << name << ' ' << counter.getHelp() << '\n'
+               << "# TYPE " << name << " counter\n"
+               << name << ' ' << counter.read() << '\n';
+    }
+
+    for (Gauge const &gauge : gauges_) {
+        std::string name = PrometheusName(gauge.getName());
+        output << "# HELP " << name << ' ' << gauge.getHelp() << '\n'
+               << "# TYPE " << name << " gauge\n"
+               << name << ' ';
+        WriteGaugeValue(output, gauge.read());
+        output << '\n';
+    }
+
+    for (Histogram const &histogram : histograms_) {
+        std::string name = PrometheusName(histogram.getName());
+        Histogram::Snapshot snapshot = histogram.read();
+        output << "# HELP " << name << ' ' << histogram.getHelp() << '\n'
+               << "# TYPE " << name << " histogram\n";
+
+        uint64_t cumulative = 0;
+        for (size_t bucket = 0; bucket < Histogram::kBuckets; ++bucket) {
+            cumulative += snapshot.buckets[bucket];
+            output << name << "_bucket{le=\"";
+            if (bucket + 1 == Histogram::kBuckets) {
+                output << "+Inf";
+            } else {
+                output << Histogram::GetBucketBound(bucket);
+            }
+            output << "\"} " << cumulative << '\n';
+        }
+        output << name << "_sum " << snapshot.sum << '\n'
+               << name << "_count " << snapshot.count << '\n';
+    }
+}
+
+} // namespace besm::sim
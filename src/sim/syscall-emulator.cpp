@@ -0,0 +1,831 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/random.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "besm-666/memory/phys-mem-device.hpp"
+#include "besm-666/sim/syscall-emulator.hpp"
+#include "besm-666/util/bit-magic.hpp"
+
+namespace besm::sim {
+
+namespace {
+
+// RISCV Linux uses asm-generic syscall numbers
+enum GuestSyscall : RV64UDWord {
+    SYSCALL_GETCWD = 17,
+    SYSCALL_IOCTL = 29,
+    SYSCALL_FACCESSAT = 48,
+    SYSCALL_OPENAT = 56,
+    SYSCALL_CLOSE = 57,
+    SYSCALL_LSEEK = 62,
+    SYSCALL_READ = 63,
+    SYSCALL_WRITE = 64,
+    SYSCALL_READV = 65,
+    SYSCALL_WRITEV = 66,
+    SYSCALL_PREAD64 = 67,
+    SYSCALL_PWRITE64 = 68,
+    SYSCALL_NEWFSTATAT = 79,
+    SYSCALL_FSTAT = 80,
+    SYSCALL_EXIT = 93,
+    SYSCALL_EXIT_GROUP = 94,
+    SYSCALL_SET_TID_ADDRESS = 96,
+    SYSCALL_SET_ROBUST_LIST = 99,
+    SYSCALL_CLOCK_GETTIME = 113,
+    SYSCALL_SIGALTSTACK = 132,
+    SYSCALL_RT_SIGACTION = 134,
+    SYSCALL_RT_SIGPROCMASK = 135,
+    SYSCALL_UNAME = 160,
+    SYSCALL_GETTIMEOFDAY = 169,
+    SYSCALL_GETPID = 172,
+    SYSCALL_GETPPID = 173,
+    SYSCALL_GETUID = 174,
+    SYSCALL_GETEUID = 175,
+    SYSCALL_GETGID = 176,
+    SYSCALL_GETEGID = 177,
+    SYSCALL_GETTID = 178,
+    SYSCALL_BRK = 214,
+    SYSCALL_MUNMAP = 215,
+    SYSCALL_MMAP = 222,
+    SYSCALL_MPROTECT = 226,
+    SYSCALL_MADVISE = 233,
+    SYSCALL_GETRANDOM = 278,
+};
+
+// asm-generic open flags
+constexpr int GUEST_O_ACCMODE = 03;
+constexpr int GUEST_O_CREAT = 0100;
+constexpr int GUEST_O_EXCL = 0200;
+constexpr int GUEST_O_NOCTTY = 0400;
+constexpr int GUEST_O_TRUNC = 01000;
+constexpr int GUEST_O_APPEND = 02000;
+constexpr int GUEST_O_NONBLOCK = 04000;
+constexpr int GUEST_O_DIRECTORY = 0200000;
+constexpr int GUEST_O_NOFOLLOW = 0400000;
+constexpr int GUEST_O_CLOEXEC = 02000000;
+
+constexpr int GUEST_MAP_FIXED = 0x10;
+constexpr int GUEST_MAP_ANONYMOUS = 0x20;
+
+constexpr int GUEST_AT_FDCWD = -100;
+
+/// The offset of read(2) and write(2)
+constexpr off_t FILE_POSITION = -1;
+/// Guest pages a regular file read allocates ahead of the data
+constexpr RV64Size READ_CHUNK = 64 * 1024;
+
+enum AuxvType : RV64UDWord {
+    AUXV_NULL = 0,
+    AUXV_PHDR = 3,
+    AUXV_PHENT = 4,
+    AUXV_PHNUM = 5,
+    AUXV_PAGESZ = 6,
+    AUXV_ENTRY = 9,
+    AUXV_UID = 11,
+    AUXV_EUID = 12,
+    AUXV_GID = 13,
+    AUXV_EGID = 14,
+    AUXV_CLKTCK = 17,
+    AUXV_SECURE = 23,
+    AUXV_RANDOM = 25,
+};
+
+// asm-generic struct stat
+struct GuestStat {
+    RV64UDWord dev;
+    RV64UDWord ino;
+    RV64UWord mode;
+    RV64UWord nlink;
+    RV64UWord uid;
+    RV64UWord gid;
+    RV64UDWord rdev;
+    RV64UDWord pad1;
+    RV64DWord size;
+    RV64Word blksize;
+    RV64Word pad2;
+    RV64DWord blocks;
+    RV64DWord atime;
+    RV64UDWord atimeNsec;
+    RV64DWord mtime;
+    RV64UDWord mtimeNsec;
+    RV64DWord ctime;
+    RV64UDWord ctimeNsec;
+    RV64UWord unused4;
+    RV64UWord unused5;
+};
+static_assert(sizeof(GuestStat) == 128);
+
+struct GuestTimespec {
+    RV64DWord sec;
+    RV64DWord nsec;
+};
+
+struct GuestIovec {
+    RV64Ptr base;
+    RV64Size len;
+};
+static_assert(sizeof(GuestIovec) == 16);
+
+struct GuestUtsname {
+    char sysname[65];
+    char nodename[65];
+    char release[65];
+    char version[65];
+    char machine[65];
+    char domainname[65];
+};
+
+int TranslateOpenFlags(int guestFlags) {
+    constexpr std::pair<int, int> TABLE[] = {
+        {GUEST_O_CREAT, O_CREAT},         {GUEST_O_EXCL, O_EXCL},
+        {GUEST_O_NOCTTY, O_NOCTTY},       {GUEST_O_TRUNC, O_TRUNC},
+        {GUEST_O_APPEND, O_APPEND},       {GUEST_O_NONBLOCK, O_NONBLOCK},
+        {GUEST_O_DIRECTORY, O_DIRECTORY}, {GUEST_O_NOFOLLOW, O_NOFOLLOW},
+        {GUEST_O_CLOEXEC, O_CLOEXEC}};
+
+    int hostFlags = guestFlags & GUEST_O_ACCMODE;
+    for (auto [guestFlag, hostFlag] : TABLE) {
+        if (guestFlags & guestFlag) {
+            hostFlags |= hostFlag;
+        }
+    }
+
+    return hostFlags;
+}
+
+GuestStat TranslateStat(struct stat const &st) {
+    GuestStat guestSt = {};
+
+    guestSt.dev = st.st_dev;
+    guestSt.ino = st.st_ino;
+    guestSt.mode = st.st_mode;
+    guestSt.nlink = st.st_nlink;
+    guestSt.uid = st.st_uid;
+    guestSt.gid = st.st_gid;
+    guestSt.rdev = st.st_rdev;
+    guestSt.size = st.st_size;
+    guestSt.blksize = st.st_blksize;
+    guestSt.blocks = st.st_blocks;
+    guestSt.atime = st.st_atim.tv_sec;
+    guestSt.atimeNsec = st.st_atim.tv_nsec;
+    guestSt.mtime = st.st_mtim.tv_sec;
+    guestSt.mtimeNsec = st.st_mtim.tv_nsec;
+    guestSt.ctime = st.st_ctim.tv_sec;
+    guestSt.ctimeNsec = st.st_ctim.tv_nsec;
+
+    return guestSt;
+}
+
+int TranslateDirFd(RV64UDWord dirfd) {
+    int fd = static_cast<int>(dirfd);
+    return fd == GUEST_AT_FDCWD ? AT_FDCWD : fd;
+}
+
+RV64DWord HostResult(RV64DWord result) { return result < 0 ? -errno : result; }
+
+bool IsRegularFile(int fd) {
+    struct stat st;
+    return ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+RV64Ptr PageRoundUp(RV64Ptr address) {
+    return (address + SyscallEmulator::kPageSize - 1) &
+           ~(SyscallEmulator::kPageSize - 1);
+}
+
+} // namespace
+
+SyscallEmulator::SPtr SyscallEmulator::Create(ProcessImage image) {
+    return SPtr(new SyscallEmulator(std::move(image)));
+}
+
+SyscallEmulator::SyscallEmulator(ProcessImage &&image)
+    : image_(std::move(image)), fixedLow_(~RV64Ptr(0)), fixedHigh_(0),
+      exited_(false), exitCode_(0) {
+    brkBase_ = brk_ = brkHigh_ = PageRoundUp(image_.imageEnd);
+    mmapTop_ = mmapEnd_ = mmapLow_ =
+        (image_.stackTop - kStackSize) & ~(kPageSize - 1);
+}
+
+void SyscallEmulator::initProcess(exec::GPRF &gprf, mem::MMU &mmu) {
+    RV64Ptr sp = image_.stackTop & ~static_cast<RV64Ptr>(0xF);
+
+    // AT_RANDOM bytes are fixed to keep runs reproducible
+    constexpr char RANDOM_BYTES[16] = {'B', 'E', 'S', 'M', '-', '6', '6', '6',
+                                       'B', 'E', 'S', 'M', '-', '6', '6', '6'};
+    sp -= sizeof(RANDOM_BYTES);
+    RV64Ptr randomPtr = sp;
+    copyToGuest(mmu, randomPtr, RANDOM_BYTES, sizeof(RANDOM_BYTES));
+
+    std::vector<RV64Ptr> argPtrs;
+    for (auto const &arg : image_.args) {
+        sp -= arg.size() + 1;
+        copyToGuest(mmu, sp, arg.c_str(), arg.size() + 1);
+        argPtrs.push_back(sp);
+    }
+
+    std::vector<RV64UDWord> words;
+    words.push_back(argPtrs.size());
+    words.insert(words.end(), argPtrs.begin(), argPtrs.end());
+    words.push_back(0); // argv terminator
+    words.push_back(0); // empty envp
+
+    std::pair<AuxvType, RV64UDWord> const auxv[] = {
+        {AUXV_PHDR, image_.programHeaders.address},
+        {AUXV_PHENT, image_.programHeaders.entrySize},
+        {AUXV_PHNUM, image_.programHeaders.count},
+        {AUXV_PAGESZ, kPageSize},
+        {AUXV_ENTRY, image_.entry},
+        {AUXV_UID, 0},
+        {AUXV_EUID, 0},
+        {AUXV_GID, 0},
+        {AUXV_EGID, 0},
+        {AUXV_CLKTCK, 100},
+        {AUXV_SECURE, 0},
+        {AUXV_RANDOM, randomPtr},
+        {AUXV_NULL, 0}};
+    for (auto [type, value] : auxv) {
+        words.push_back(type);
+        words.push_back(value);
+    }
+
+    sp = (sp - words.size() * sizeof(RV64UDWord)) &
+         ~static_cast<RV64Ptr>(0xF);
+    copyToGuest(mmu, sp, words.data(), words.size() * sizeof(RV64UDWord));
+
+    gprf.write(exec::GPRF::X2, sp);
+    gprf.write(exec::GPRF::PC, image_.entry);
+}
+
+bool SyscallEmulator::handle(exec::GPRF &gprf, mem::MMU &mmu) {
+    RV64UDWord number = gprf.read(exec::GPRF::X17);
+    RV64UDWord a0 = gprf.read(exec::GPRF::X10);
+    RV64UDWord a1 = gprf.read(exec::GPRF::X11);
+    RV64UDWord a2 = gprf.read(exec::GPRF::X12);
+    RV64UDWord a3 = gprf.read(exec::GPRF::X13);
+    RV64UDWord a4 = gprf.read(exec::GPRF::X14);
+    RV64UDWord a5 = gprf.read(exec::GPRF::X15);
+
+    int fd = static_cast<int>(a0);
+
+    RV64DWord result = -ENOSYS;
+    switch (number) {
+    case SYSCALL_READ:
+        result = this->doRead(mmu, fd, a1, a2, FILE_POSITION);
+        break;
+    case SYSCALL_WRITE:
+        result = this->doWrite(mmu, fd, a1, a2, FILE_POSITION);
+        break;
+    case SYSCALL_READV:
+        result = this->doReadV(mmu, fd, a1, a2, false);
+        break;
+    case SYSCALL_WRITEV:
+        result = this->doReadV(mmu, fd, a1, a2, true);
+        break;
+    case SYSCALL_PREAD64:
+        result = static_cast<off_t>(a3) < 0
+                     ? -EINVAL
+                     : this->doRead(mmu, fd, a1, a2, static_cast<off_t>(a3));
+        break;
+    case SYSCALL_PWRITE64:
+        result = static_cast<off_t>(a3) < 0
+                     ? -EINVAL
+                     : this->doWrite(mmu, fd, a1, a2, static_cast<off_t>(a3));
+        break;
+    case SYSCALL_OPENAT:
+        result = this->doOpenAt(mmu, TranslateDirFd(a0), a1,
+                                static_cast<int>(a2), static_cast<int>(a3));
+        break;
+    case SYSCALL_CLOSE:
+        // Simulator standard streams are shared with the guest
+        result = fd <= STDERR_FILENO ? 0 : HostResult(::close(fd));
+        break;
+    case SYSCALL_LSEEK:
+        result = HostResult(
+            ::lseek(fd, static_cast<off_t>(a1), static_cast<int>(a2)));
+        break;
+    case SYSCALL_FSTAT:
+        result = this->doFStat(mmu, fd, a1);
+        break;
+    case SYSCALL_NEWFSTATAT:
+        result = this->doFStatAt(mmu, TranslateDirFd(a0), a1, a2,
+                                 static_cast<int>(a3));
+        break;
+    case SYSCALL_FACCESSAT: {
+        std::string path;
+        result = !readGuestString(mmu, a1, path)
+                     ? -EFAULT
+                     : HostResult(::faccessat(TranslateDirFd(a0), path.c_str(),
+                                              static_cast<int>(a2), 0));
+        break;
+    }
+    case SYSCALL_GETCWD: {
+        // ERANGE if the path doesn't fit the guest buffer or PATH_MAX
+        char cwd[PATH_MAX];
+        if (a1 == 0) {
+            result = -EINVAL;
+        } else if (::getcwd(cwd, std::min<RV64Size>(a1, sizeof(cwd))) ==
+                   nullptr) {
+            result = -errno;
+        } else {
+            size_t size = strlen(cwd) + 1;
+            result = copyToGuest(mmu, a0, cwd, size) ? size : -EFAULT;
+        }
+        break;
+    }
+    case SYSCALL_IOCTL:
+        // Guest streams are never terminals
+        result = -ENOTTY;
+        break;
+    case SYSCALL_EXIT:
+    case SYSCALL_EXIT_GROUP:
+        exited_ = true;
+        exitCode_ = static_cast<int>(a0 & 0xFF);
+        return false;
+    case SYSCALL_SET_TID_ADDRESS:
+    case SYSCALL_GETPID:
+    case SYSCALL_GETTID:
+        result = 1;
+        break;
+    case SYSCALL_GETPPID:
+    case SYSCALL_GETUID:
+    case SYSCALL_GETEUID:
+    case SYSCALL_GETGID:
+    case SYSCALL_GETEGID:
+    case SYSCALL_SET_ROBUST_LIST:
+    case SYSCALL_SIGALTSTACK:
+    case SYSCALL_RT_SIGACTION:
+    case SYSCALL_RT_SIGPROCMASK:
+    case SYSCALL_MPROTECT:
+    case SYSCALL_MADVISE:
+        result = 0;
+        break;
+    case SYSCALL_BRK:
+        result = this->doBrk(mmu, a0);
+        break;
+    case SYSCALL_MMAP:
+        result = this->doMmap(mmu, a0, a1, static_cast<int>(a3),
+                              static_cast<int>(a4), a5);
+        break;
+    case SYSCALL_MUNMAP:
+        result = this->doMunmap(a0, a1);
+        break;
+    case SYSCALL_CLOCK_GETTIME:
+        result = this->doClockGetTime(mmu, static_cast<int>(a0), a1);
+        break;
+    case SYSCALL_GETTIMEOFDAY:
+        result = this->doGetTimeOfDay(mmu, a0);
+        break;
+    case SYSCALL_UNAME:
+        result = this->doUname(mmu, a0);
+        break;
+    case SYSCALL_GETRANDOM:
+        result = this->doGetRandom(mmu, a0, a1);
+        break;
+    default:
+        std::clog << "[BESM] SYSCALL: Unsupported syscall " << number
+                  << std::endl;
+        break;
+    }
+
+    gprf.write(exec::GPRF::X10, util::Unsignify(result));
+    return true;
+}
+
+/**
+ * A buffer larger than the rest of a regular file is read in chunks, so the
+ * guest pages past the end of the file are not allocated. Like Linux, the
+ * read stops at the first page not backed by host memory.
+ */
+RV64DWord SyscallEmulator::doRead(mem::MMU &mmu, int fd, RV64Ptr buf,
+                                  RV64Size count, off_t offset) {
+    RV64Size done = 0;
+    while (true) {
+        RV64Size chunk = std::min(count - done, READ_CHUNK);
+        spans_.clear();
+        RV64Size backed = collectSpans(mmu, buf + done, chunk, spans_);
+        if (backed == 0 && chunk != 0) {
+            return done == 0 ? -EFAULT : done;
+        }
+
+        int iovcnt = std::min<size_t>(spans_.size(), IOV_MAX);
+        ssize_t bytes =
+            offset == FILE_POSITION
+                ? ::readv(fd, spans_.data(), iovcnt)
+                : ::preadv(fd, spans_.data(), iovcnt, offset + done);
+        if (bytes < 0) {
+            return done == 0 ? -errno : done;
+        }
+        done += bytes;
+
+        if (static_cast<RV64Size>(bytes) < chunk || done == count) {
+            return done;
+        }
+        // Another read could block on a pipe or a terminal
+        if (done == chunk && !IsRegularFile(fd)) {
+            return done;
+        }
+    }
+}
+
+RV64DWord SyscallEmulator::doWrite(mem::MMU &mmu, int fd, RV64Ptr buf,
+                                   RV64Size count, off_t offset) {
+    spans_.clear();
+    if (collectSpans(mmu, buf, count, spans_) == 0 && count != 0) {
+        return -EFAULT;
+    }
+
+    int iovcnt = std::min<size_t>(spans_.size(), IOV_MAX);
+    return HostResult(offset == FILE_POSITION
+                          ? ::writev(fd, spans_.data(), iovcnt)
+                          : ::pwritev(fd, spans_.data(), iovcnt, offset));
+}
+
+RV64DWord SyscallEmulator::doReadV(mem::MMU &mmu, int fd, RV64Ptr iov,
+                                   RV64Size iovcnt, bool write) {
+    if (iovcnt > IOV_MAX) {
+        return -EINVAL;
+    }
+
+    std::vector<GuestIovec> guestIov(iovcnt);
+    if (!copyFromGuest(mmu, iov, guestIov.data(),
+                       iovcnt * sizeof(GuestIovec))) {
+        return -EFAULT;
+    }
+
+    // The transfer stops at the first byte not backed by host memory
+    spans_.clear();
+    for (GuestIovec const &entry : guestIov) {
+        if (collectSpans(mmu, entry.base, entry.len, spans_) < entry.len) {
+            if (spans_.empty()) {
+                return -EFAULT;
+            }
+            break;
+        }
+    }
+
+    int count = std::min<size_t>(spans_.size(), IOV_MAX);
+    return HostResult(write ? ::writev(fd, spans_.data(), count)
+                            : ::readv(fd, spans_.data(), count));
+}
+
+RV64DWord SyscallEmulator::doOpenAt(mem::MMU &mmu, int dirfd, RV64Ptr path,
+                                    int flags, int mode) {
+    std::string hostPath;
+    if (!readGuestString(mmu, path, hostPath)) {
+        return -EFAULT;
+    }
+
+    return HostResult(
+        ::openat(dirfd, hostPath.c_str(), TranslateOpenFlags(flags), mode));
+}
+
+RV64DWord SyscallEmulator::doFStat(mem::MMU &mmu, int fd, RV64Ptr statbuf) {
+    struct stat st;
+    if (::fstat(fd, &st) < 0) {
+        return -errno;
+    }
+
+    GuestStat guestSt = TranslateStat(st);
+    return copyToGuest(mmu, statbuf, &guestSt, sizeof(guestSt)) ? 0 : -EFAULT;
+}
+
+RV64DWord SyscallEmulator::doFStatAt(mem::MMU &mmu, int dirfd, RV64Ptr path,
+                                     RV64Ptr statbuf, int flags) {
+    std::string hostPath;
+    if (!readGuestString(mmu, path, hostPath)) {
+        return -EFAULT;
+    }
+
+    struct stat st;
+    if (::fstatat(dirfd, hostPath.c_str(), &st, flags) < 0) {
+        return -errno;
+    }
+
+    GuestStat guestSt = TranslateStat(st);
+    return copyToGuest(mmu, statbuf, &guestSt, sizeof(guestSt)) ? 0 : -EFAULT;
+}
+
+RV64DWord SyscallEmulator::doBrk(mem::MMU &mmu, RV64Ptr address) {
+    if (address < brkBase_ || address >= mmapTop_) {
+        return brk_;
+    }
+
+    // Memory released by shrinking the break must read as zero if regrown,
+    // as must the pages a fixed or an unmapped mapping has written beyond
+    // the break
+    if (address > brk_) {
+        RV64Ptr dirtyEnd = std::min(address, brkHigh_);
+        if (address > brkHigh_ &&
+            (address > mmapLow_ || this->overlapsFixed(brkHigh_, address))) {
+            dirtyEnd = address;
+        }
+        if (brk_ < dirtyEnd) {
+            zeroGuest(mmu, brk_, dirtyEnd - brk_);
+        }
+    }
+
+    brk_ = address;
+    brkHigh_ = std::max(brkHigh_, brk_);
+    return brk_;
+}
+
+RV64DWord SyscallEmulator::doMmap(mem::MMU &mmu, RV64Ptr address,
+                                  RV64Size length, int flags, int fd,
+                                  RV64Size offset) {
+    length = PageRoundUp(length);
+    if (length == 0) {
+        return -EINVAL;
+    }
+
+    RV64Ptr target;
+    bool fresh;
+    auto released = std::find_if(
+        released_.begin(), released_.end(),
+        [length](auto const &range) {
+            return range.second - range.first >= length;
+        });
+    if (flags & GUEST_MAP_FIXED) {
+        target = address;
+        fresh = false;
+        fixedLow_ = std::min(fixedLow_, target);
+        fixedHigh_ = std::max(fixedHigh_, target + length);
+        this->reserveRange(target, target + length);
+    } else if (released != released_.end()) {
+        target = released->first;
+        fresh = false;
+        this->reserveRange(target, target + length);
+    } else {
+        // The break never shrinks below brkHigh_ here, so the mapping takes
+        // no page the break has used
+        if (length > mmapTop_ - brkHigh_) {
+            return -ENOMEM;
+        }
+        mmapTop_ -= length;
+        target = mmapTop_;
+        fresh = target + length <= mmapLow_ &&
+                !this->overlapsFixed(target, target + length);
+        mmapLow_ = std::min(mmapLow_, mmapTop_);
+    }
+
+    if ((flags & GUEST_MAP_ANONYMOUS) && fresh) {
+        // Never touched RAM pages are zero-filled already
+        return target;
+    }
+
+    spans_.clear();
+    if (collectSpans(mmu, target, length, spans_) != length) {
+        return -ENOMEM;
+    }
+
+    // The tail past the end of the file must read as zero too
+    if (!fresh) {
+        for (auto const &span : spans_) {
+            memset(span.iov_base, 0, span.iov_len);
+        }
+    }
+    if (flags & GUEST_MAP_ANONYMOUS) {
+        return target;
+    }
+
+    for (size_t i = 0; i < spans_.size(); i += IOV_MAX) {
+        int count = std::min<size_t>(spans_.size() - i, IOV_MAX);
+        size_t requested = 0;
+        for (int j = 0; j < count; ++j) {
+            requested += spans_[i + j].iov_len;
+        }
+
+        ssize_t bytes = ::preadv(fd, spans_.data() + i, count,
+                                 static_cast<off_t>(offset));
+        if (bytes < 0) {
+            return -errno;
+        }
+        // The rest of the mapping is past the end of the file
+        if (static_cast<size_t>(bytes) < requested) {
+            break;
+        }
+        offset += bytes;
+    }
+
+    return target;
+}
+
+/**
+ * Only the pages of non-fixed mappings are reused: a range unmapped at
+ * mmapTop_ is given back to the break, others are kept for later mappings
+ */
+RV64DWord SyscallEmulator::doMunmap(RV64Ptr address, RV64Size length) {
+    if (address % kPageSize != 0 || length == 0) {
+        return -EINVAL;
+    }
+
+    RV64Size limit = address < mmapEnd_ ? mmapEnd_ - address : 0;
+    RV64Ptr begin = std::max(address, mmapTop_);
+    RV64Ptr end = address + std::min(PageRoundUp(length), limit);
+    if (begin >= end) {
+        return 0;
+    }
+
+    this->reserveRange(begin, end);
+    auto next = released_.find(end);
+    if (next != released_.end()) {
+        end = next->second;
+        released_.erase(next);
+    }
+    auto prev = released_.lower_bound(begin);
+    if (prev != released_.begin() && std::prev(prev)->second == begin) {
+        --prev;
+        begin = prev->first;
+        released_.erase(prev);
+    }
+
+    if (begin == mmapTop_) {
+        mmapTop_ = end;
+    } else {
+        released_[begin] = end;
+    }
+    return 0;
+}
+
+RV64DWord SyscallEmulator::doClockGetTime(mem::MMU &mmu, int clock,
+                                          RV64Ptr tp) {
+    struct timespec ts;
+    if (::clock_gettime(clock, &ts) < 0) {
+        return -errno;
+    }
+
+    GuestTimespec guestTs = {.sec = ts.tv_sec, .nsec = ts.tv_nsec};
+    return copyToGuest(mmu, tp, &guestTs, sizeof(guestTs)) ? 0 : -EFAULT;
+}
+
+RV64DWord SyscallEmulator::doGetTimeOfDay(mem::MMU &mmu, RV64Ptr tv) {
+    struct timeval hostTv;
+    ::gettimeofday(&hostTv, nullptr);
+
+    GuestTimespec guestTv = {.sec = hostTv.tv_sec, .nsec = hostTv.tv_usec};
+    return tv == 0 || copyToGuest(mmu, tv, &guestTv, sizeof(guestTv))
+               ? 0
+               : -EFAULT;
+}
+
+RV64DWord SyscallEmulator::doUname(mem::MMU &mmu, RV64Ptr buf) {
+    GuestUtsname uts = {};
+    strcpy(uts.sysname, "Linux");
+    strcpy(uts.nodename, "besm-666");
+    strcpy(uts.release, "5.15.0");
+    strcpy(uts.version, "#1 BESM-666");
+    strcpy(uts.machine, "riscv64");
+
+    return copyToGuest(mmu, buf, &uts, sizeof(uts)) ? 0 : -EFAULT;
+}
+
+RV64DWord SyscallEmulator::doGetRandom(mem::MMU &mmu, RV64Ptr buf,
+                                       RV64Size count) {
+    spans_.clear();
+    RV64Size backed = collectSpans(mmu, buf, count, spans_);
+    if (backed == 0 && count != 0) {
+        return -EFAULT;
+    }
+
+    for (auto const &span : spans_) {
+        if (::getrandom(span.iov_base, span.iov_len, 0) < 0) {
+            return -errno;
+        }
+    }
+
+    return backed;
+}
+
+RV64Size SyscallEmulator::collectSpans(mem::MMU &mmu, RV64Ptr address,
+                                       RV64Size size,
+                                       std::vector<iovec> &spans) {
+    RV64Size backed = 0;
+    while (backed != size) {
+        std::pair<void *, RV64Size> span;
+        try {
+            span = mmu.touchHostAddress(address);
+        } catch (mem::IPhysMemDevice::InvalidAddressError const &) {
+            break;
+        }
+
+        if (span.first == nullptr || span.second == 0) {
+            break;
+        }
+
+        RV64Size len = std::min(size - backed, span.second);
+
+        // Pages allocated from the same chunk are often adjacent on host
+        if (!spans.empty() &&
+            static_cast<char *>(spans.back().iov_base) +
+                    spans.back().iov_len ==
+                span.first) {
+            spans.back().iov_len += len;
+        } else {
+            spans.push_back(iovec{.iov_base = span.first, .iov_len = len});
+        }
+
+        address += len;
+        backed += len;
+    }
+
+    return backed;
+}
+
+bool SyscallEmulator::overlapsFixed(RV64Ptr begin, RV64Ptr end) const {
+    return begin < fixedHigh_ && fixedLow_ < end;
+}
+
+void SyscallEmulator::reserveRange(RV64Ptr begin, RV64Ptr end) {
+    auto it = released_.lower_bound(begin);
+    if (it != released_.begin() && std::prev(it)->second > begin) {
+        --it;
+    }
+    while (it != released_.end() && it->first < end) {
+        auto [rangeBegin, rangeEnd] = *it;
+        it = released_.erase(it);
+        if (rangeBegin < begin) {
+            released_[rangeBegin] = begin;
+        }
+        if (end < rangeEnd) {
+            released_[end] = rangeEnd;
+        }
+    }
+}
+
+void SyscallEmulator::zeroGuest(mem::MMU &mmu, RV64Ptr address,
+                                RV64Size size) {
+    spans_.clear();
+    collectSpans(mmu, address, size, spans_);
+    for (auto const &span : spans_) {
+        memset(span.iov_base, 0, span.iov_len);
+    }
+}
+
+bool SyscallEmulator::copyFromGuest(mem::MMU &mmu, RV64Ptr address,
+                                    void *data, RV64Size size) {
+    std::vector<iovec> spans;
+    if (collectSpans(mmu, address, size, spans) != size) {
+        return false;
+    }
+
+    char *dst = static_cast<char *>(data);
+    for (auto const &span : spans) {
+        memcpy(dst, span.iov_base, span.iov_len);
+        dst += span.iov_len;
+    }
+
+    return true;
+}
+
+bool SyscallEmulator::copyToGuest(mem::MMU &mmu, RV64Ptr address,
+                                  void const *data, RV64Size size) {
+    std::vector<iovec> spans;
+    if (collectSpans(mmu, address, size, spans) != size) {
+        return false;
+    }
+
+    char const *src = static_cast<char const *>(data);
+    for (auto const &span : spans) {
+        memcpy(span.iov_base, src, span.iov_len);
+        src += span.iov_len;
+    }
+
+    return true;
+}
+
+bool SyscallEmulator::readGuestString(mem::MMU &mmu, RV64Ptr address,
+                                      std::string &string) {
+    string.clear();
+    while (string.size() < PATH_MAX) {
+        std::pair<void *, RV64Size> span;
+        try {
+            span = mmu.touchHostAddress(address);
+        } catch (mem::IPhysMemDevice::InvalidAddressError const &) {
+            return false;
+        }
+
+        if (span.first == nullptr) {
+            return false;
+        }
+
+        char const *chars = static_cast<char const *>(span.first);
+        size_t len = strnlen(chars, span.second);
+        string.append(chars, len);
+
+        if (len < span.second) {
+            return true;
+        }
+        address += len;
+    }
+
+    return false;
+}
+
+} // namespace besm::sim
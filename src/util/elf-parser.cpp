@@ -1,4 +1,7 @@
+#include <optional>
+
 #include "besm-666/util/elf-parser.hpp"
+#include "besm-666/util/symtab.hpp"
 #include "elfio/elfio.hpp"
 
 namespace besm::util {
@@ -20,6 +23,12 @@ public:
      */
     const std::vector<LoadableSegment> &getLoadableSegments() & override;
 
+    RV64Ptr getEntryPoint() const override;
+    ProgramHeaders getProgramHeaders() const override;
+
+    const std::vector<Symbol> &getSymbols() & override;
+    const Symtab &getSymtab() & override;
+
 private:
     /**
      * \brief stores ELF requirements for simulator
@@ -38,6 +47,9 @@ private:
 
     ELFIO::elfio reader_{};
     std::vector<LoadableSegment> loadableSegments_;
+    std::vector<Symbol> symbols_;
+    bool symbolsRead_ = false;
+    std::optional<Symtab> symtab_;
 };
 
 std::unique_ptr<IElfParser> createParser(const std::filesystem::path &elfPath) {
@@ -72,22 +84,108 @@ ElfParser::getLoadableSegments() & {
             if (seg->get_type() == ELFIO::PT_LOAD) {
                 loadableSegments_.emplace_back(
                     seg->get_virtual_address(), seg->get_data(),
-                    static_cast<RV64Size>(seg->get_file_size()));
+                    static_cast<RV64Size>(seg->get_file_size()),
+                    static_cast<RV64Size>(seg->get_memory_size()),
+                    (seg->get_flags() & ELFIO::PF_W) != 0);
             }
         }
     }
     return loadableSegments_;
 }
 
+RV64Ptr ElfParser::getEntryPoint() const { return reader_.get_entry(); }
+
+/**
+ * Program headers are found either by PT_PHDR segment or by the LOAD segment
+ * mapping the ELF file beginning (the usual layout of static executables)
+ */
+IElfParser::ProgramHeaders ElfParser::getProgramHeaders() const {
+    ProgramHeaders headers = {
+        .address = 0,
+        .entrySize = reader_.get_segment_entry_size(),
+        .count = reader_.segments.size(),
+    };
+
+    for (const auto &seg : reader_.segments) {
+        if (seg->get_type() == ELFIO::PT_PHDR) {
+            headers.address = seg->get_virtual_address();
+            return headers;
+        }
+    }
+
+    RV64Size phOffset = reader_.get_segments_offset();
+    for (const auto &seg : reader_.segments) {
+        if (seg->get_type() == ELFIO::PT_LOAD &&
+            seg->get_offset() <= phOffset &&
+            phOffset < seg->get_offset() + seg->get_file_size()) {
+            headers.address =
+                seg->get_virtual_address() + phOffset - seg->get_offset();
+            break;
+        }
+    }
+
+    return headers;
+}
+
+const std::vector<IElfParser::Symbol> &ElfParser::getSymbols() & {
+    if (symbolsRead_) {
+        return symbols_;
+    }
+    symbolsRead_ = true;
+
+    for (const auto &sec : reader_.sections) {
+        if (sec->get_type() != ELFIO::SHT_SYMTAB &&
+            sec->get_type() != ELFIO::SHT_DYNSYM) {
+            continue;
+        }
+
+        ELFIO::symbol_section_accessor accessor(reader_, &*sec);
+        for (ELFIO::Elf_Xword i = 0; i < accessor.get_symbols_num(); ++i) {
+            std::string name;
+            ELFIO::Elf64_Addr value;
+            ELFIO::Elf_Xword size;
+            unsigned char bind;
+            unsigned char type;
+            ELFIO::Elf_Half sectionIndex;
+            unsigned char other;
+
+            accessor.get_symbol(i, name, value, size, bind, type,
+                                sectionIndex, other);
+            if (name.empty() || sectionIndex == ELFIO::SHN_UNDEF ||
+                type == ELFIO::STT_SECTION || type == ELFIO::STT_FILE) {
+                continue;
+            }
+
+            symbols_.push_back(Symbol{.name = std::move(name),
+                                      .address = value,
+                                      .size = size,
+                                      .isFunction = type == ELFIO::STT_FUNC});
+        }
+    }
+
+    return symbols_;
+}
+
+const Symtab &ElfParser::getSymtab() & {
+    if (!symtab_.has_value()) {
+        symtab_.emplace(getSymbols());
+    }
+    return *symtab_;
+}
+
 IElfParser::LoadableSegment::LoadableSegment(RV64Ptr address, const void *data,
-                                             RV64Size size)
-    : address(address), data(data), size(size) {}
+                                             RV64Size size, RV64Size memSize,
+                                             bool writable)
+    : address(address), data(data), size(size), memSize(memSize),
+      writable(writable) {}
 IElfParser::LoadableSegment::LoadableSegment(
     IElfParser::LoadableSegment &&other)
-    : address(other.address), data(other.data), size(other.size) {
+    : address(other.address), data(other.data), size(other.size),
+      memSize(other.memSize), writable(other.writable) {
     std::swap(other.address, address);
     std::swap(other.data, data);
     std::swap(other.size, size);
+    std::swap(other.memSize, memSize);
 }
 IElfParser::LoadableSegment &
 IElfParser::LoadableSegment::operator=(IElfParser::LoadableSegment &&other) {
@@ -95,9 +193,12 @@ IElfParser::LoadableSegment::operator=(IElfParser::LoadableSegment &&other) {
         address = 0;
         data = nullptr;
         size = 0;
+        memSize = 0;
+        writable = other.writable;
         std::swap(other.address, address);
         std::swap(other.data, data);
         std::swap(other.size, size);
+        std::swap(other.memSize, memSize);
     }
     return *this;
 }
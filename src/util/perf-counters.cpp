@@ -0,0 +1,120 @@
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "besm-666/util/perf-counters.hpp"
+
+namespace besm::util {
+
+namespace {
+
+constexpr uint64_t HWCacheConfig(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+struct EventDescriptor {
+    char const *name;
+    uint32_t type;
+    uint64_t config;
+};
+
+EventDescriptor const EVENTS[PerfCounters::NUM_EVENTS] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"L1-dcache-load-misses", PERF_TYPE_HW_CACHE,
+     HWCacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                   PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"dTLB-load-misses", PERF_TYPE_HW_CACHE,
+     HWCacheConfig(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                   PERF_COUNT_HW_CACHE_RESULT_MISS)},
+};
+
+int OpenEvent(EventDescriptor const &event) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                                    PERF_FLAG_FD_CLOEXEC));
+}
+
+} // namespace
+
+char const *PerfCounters::GetEventName(Event event) {
+    return EVENTS[event].name;
+}
+
+PerfCounters::PerfCounters() {
+    for (size_t event = 0; event < NUM_EVENTS; ++event) {
+        fds_[event] = OpenEvent(EVENTS[event]);
+        if (fds_[event] < 0 && error_.empty()) {
+            error_ = std::string(EVENTS[event].name) + ": " +
+                     std::strerror(errno);
+        }
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+bool PerfCounters::available() const {
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::start() {
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+PerfCounters::Counts PerfCounters::stop() {
+    for (int fd : fds_) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    Counts counts;
+    for (size_t event = 0; event < NUM_EVENTS; ++event) {
+        // value, time enabled, time running
+        uint64_t data[3];
+        if (fds_[event] < 0 ||
+            read(fds_[event], data, sizeof(data)) != sizeof(data) ||
+            data[2] == 0) {
+            continue;
+        }
+        counts[event] =
+            data[2] < data[1]
+                ? static_cast<uint64_t>(static_cast<double>(data[0]) *
+                                        data[1] / data[2])
+                : data[0];
+    }
+    return counts;
+}
+
+} // namespace besm::util
@@ -0,0 +1,48 @@
+#include <algorithm>
+
+#include "besm-666/util/symtab.hpp"
+
+namespace besm::util {
+
+Symtab::Symtab(std::vector<IElfParser::Symbol> const &symbols) {
+    bool hasFunctions =
+        std::any_of(symbols.begin(), symbols.end(),
+                    [](auto const &symbol) { return symbol.isFunction; });
+
+    for (auto const &symbol : symbols) {
+        if (!hasFunctions || symbol.isFunction) {
+            entries_.push_back(Entry{.name = symbol.name,
+                                     .address = symbol.address,
+                                     .size = symbol.size});
+        }
+    }
+
+    std::stable_sort(entries_.begin(), entries_.end(),
+                     [](Entry const &lhs, Entry const &rhs) {
+                         return lhs.address < rhs.address;
+                     });
+    entries_.erase(std::unique(entries_.begin(), entries_.end(),
+                               [](Entry const &lhs, Entry const &rhs) {
+                                   return lhs.address == rhs.address;
+                               }),
+                   entries_.end());
+}
+
+Symtab::Entry const *Symtab::lookup(RV64Ptr address) const {
+    auto next = std::upper_bound(
+        entries_.begin(), entries_.end(), address,
+        [](RV64Ptr address, Entry const &entry) {
+            return address < entry.address;
+        });
+    if (next == entries_.begin()) {
+        return nullptr;
+    }
+
+    Entry const &entry = *std::prev(next);
+    if (entry.size != 0 && address - entry.address >= entry.size) {
+        return nullptr;
+    }
+    return &entry;
+}
+
+} // namespace besm::util
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "besm-666/util/tracer.hpp"
+
+namespace besm::util {
+
+std::atomic<bool> Tracer::enabled_{false};
+
+namespace {
+
+struct Event {
+    char const *name;
+    uint64_t start;
+    uint64_t end;
+    char const *argName;
+    uint64_t arg;
+};
+
+/// Owned by the recording thread and by the tracer, so it outlives both
+struct ThreadBuffer {
+    std::mutex mutex; ///< taken by the flusher only once per period
+    std::vector<Event> events;
+    std::string name;
+    bool nameWritten = false;
+    bool finished = false; ///< the thread has exited
+    uint32_t tid = 0;
+};
+
+/// Created on the first event of the thread, dropped once it exits
+struct LocalState {
+    std::shared_ptr<ThreadBuffer> buffer;
+    std::string name;
+
+    ~LocalState() {
+        if (buffer != nullptr) {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            buffer->finished = true;
+        }
+    }
+};
+
+struct TracerState {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    uint32_t nextTid = 1;
+
+    std::ofstream file;
+    uint64_t origin = 0;
+    bool firstEvent = true;
+
+    std::thread flusher;
+    std::condition_variable wakeUp;
+    bool stopping = false;
+};
+
+TracerState &State() {
+    static TracerState state;
+    return state;
+}
+
+LocalState &Local() {
+    thread_local LocalState local;
+    return local;
+}
+
+ThreadBuffer &LocalBuffer() {
+    LocalState &local = Local();
+    if (local.buffer == nullptr) {
+        local.buffer = std::make_shared<ThreadBuffer>();
+        local.buffer->name = local.name;
+
+        TracerState &state = State();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        local.buffer->tid = state.nextTid++;
+        state.buffers.push_back(local.buffer);
+    }
+    return *local.buffer;
+}
+
+void WriteSeparator(TracerState &state) {
+    state.file << (state.firstEvent ? "\n" : ",\n");
+    state.firstEvent = false;
+}
+
+/// The format counts microseconds
+void WriteMicros(std::ostream &output, uint64_t ns) {
+    output << ns / 1000 << '.' << std::setw(3) << std::setfill('0')
+           << ns % 1000 << std::setfill(' ');
+}
+
+/**
+ * Writes out the buffered events and drops the buffers of exited threads,
+ * called under the state mutex
+ */
+void FlushBuffers(TracerState &state) {
+    std::vector<Event> events;
+    pid_t pid = ::getpid();
+
+    for (auto &buffer : state.buffers) {
+        std::string name;
+        bool writeName;
+        bool finished;
+        {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            events.swap(buffer->events);
+            writeName = !buffer->nameWritten && !buffer->name.empty();
+            buffer->nameWritten |= writeName;
+            name = buffer->name;
+            finished = buffer->finished;
+        }
+
+        if (writeName) {
+            WriteSeparator(state);
+            state.file << "{\"name\": \"thread_name\", \"ph\": \"M\", "
+                          "\"pid\": "
+                       << pid << ", \"tid\": " << buffer->tid
+                       << ", \"args\": {\"name\": \"" << name << "\"}}";
+        }
+
+        for (Event const &event : events) {
+            WriteSeparator(state);
+            state.file << "{\"name\": \"" << event.name
+                       << "\", \"ph\": \"X\", \"pid\": " << pid
+                       << ", \"tid\": " << buffer->tid << ", \"ts\": ";
+            WriteMicros(state.file, event.start > state.origin
+                                        ? event.start - state.origin
+                                        : 0);
+            state.file << ", \"dur\": ";
+            WriteMicros(state.file, event.end - event.start);
+            if (event.argName != nullptr) {
+                state.file << ", \"args\": {\"" << event.argName
+                           << "\": " << event.arg << '}';
+            }
+            state.file << '}';
+        }
+        events.clear();
+
+        if (finished) {
+            buffer.reset();
+        }
+    }
+    state.buffers.erase(
+        std::remove(state.buffers.begin(), state.buffers.end(), nullptr),
+        state.buffers.end());
+    state.file.flush();
+}
+
+void FlusherLoop(std::chrono::milliseconds period) {
+    TracerState &state = State();
+    std::unique_lock<std::mutex> lock(state.mutex);
+    while (!state.wakeUp.wait_for(lock, period,
+                                  [&state] { return state.stopping; })) {
+        FlushBuffers(state);
+    }
+}
+
+} // namespace
+
+bool Tracer::Start(std::filesystem::path const &path,
+                   std::chrono::milliseconds flushPeriod) {
+    TracerState &state = State();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.file.is_open()) {
+            return false;
+        }
+        state.file.open(path);
+        if (!state.file) {
+            state.file.close();
+            return false;
+        }
+
+        // Events of an earlier run, threads exited since then are dropped
+        for (auto &buffer : state.buffers) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            buffer->events.clear();
+            buffer->nameWritten = false;
+            if (buffer->finished) {
+                buffer.reset();
+            }
+        }
+        state.buffers.erase(
+            std::remove(state.buffers.begin(), state.buffers.end(), nullptr),
+            state.buffers.end());
+        state.file << "{\"traceEvents\": [";
+        state.origin = Now();
+        state.firstEvent = true;
+        state.stopping = false;
+    }
+
+    state.flusher = std::thread(FlusherLoop, flushPeriod);
+    enabled_.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void Tracer::Stop() {
+    TracerState &state = State();
+    if (!state.flusher.joinable()) {
+        return;
+    }
+    enabled_.store(false, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.stopping = true;
+    }
+    state.wakeUp.notify_one();
+    state.flusher.join();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    FlushBuffers(state);
+    state.file << "\n]}\n";
+    state.file.close();
+}
+
+void Tracer::Record(char const *name, uint64_t start, uint64_t end,
+                    char const *argName, uint64_t arg) {
+    if (!Enabled()) {
+        return;
+    }
+    ThreadBuffer &buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back({name, start, end, argName, arg});
+}
+
+/**
+ * The name is kept by the thread, a buffer is only created once the thread
+ * records an event
+ */
+void Tracer::SetThreadName(std::string name) {
+    LocalState &local = Local();
+    local.name = std::move(name);
+    if (local.buffer != nullptr) {
+        std::lock_guard<std::mutex> lock(local.buffer->mutex);
+        local.buffer->name = local.name;
+        local.buffer->nameWritten = false;
+    }
+}
+
+} // namespace besm::util
@@ -1,8 +1,21 @@
 #include <chrono>
+#include <cerrno>
+#include <condition_variable>
 #include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <poll.h>
+#include <sstream>
 #include <stdexcept>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "besm-666/instruction.hpp"
 #include "besm-666/riscv-types.hpp"
@@ -13,9 +26,17 @@
 #include "CLI/CLI.hpp"
 
 #include "besm-666/exec/gprf.hpp"
+#include "besm-666/memory/ram.hpp"
+#include "besm-666/sim/batch-runner.hpp"
 #include "besm-666/sim/config.hpp"
 #include "besm-666/sim/hooks.hpp"
+#include "besm-666/sim/call-graph-profiler.hpp"
+#include "besm-666/sim/flat-profiler.hpp"
+#include "besm-666/sim/instr-mix-profiler.hpp"
+#include "besm-666/sim/pc-sampler.hpp"
 #include "besm-666/sim/machine.hpp"
+#include "besm-666/util/perf-counters.hpp"
+#include "besm-666/util/tracer.hpp"
 #include "besm-666/util/range.hpp"
 
 bool optionDumpInstructions = false;
@@ -185,22 +206,720 @@ besm::util::Range<besm::RV64Ptr> ParseRange(std::string const &rangeString) {
     }
 }
 
+/// CLI11 validator of the addresses parsed with std::stoull in any base
+std::string CheckAddress(std::string const &string) {
+    try {
+        size_t parsed = 0;
+        std::stoull(string, &parsed, 0);
+        if (std::isdigit(static_cast<unsigned char>(string.front())) &&
+            parsed == string.size()) {
+            return {};
+        }
+    } catch (std::logic_error const &) {
+    }
+    return "Invalid address: " + string;
+}
+
+int ExitCode(bool a0Validation) {
+    if (a0Validation) {
+        if (Machine->getHart().getGPRF().read(besm::exec::GPRF::X10) == 1) {
+            return 0;
+        } else {
+            return 1;
+        }
+    } else {
+        return Machine->getExitCode().value_or(0);
+    }
+}
+
+/// Host counters of a phase of the run, see --perf-counters
+struct PerfPhase {
+    char const *name;
+    size_t instrsExecuted; ///< guest instructions
+    besm::util::PerfCounters::Counts counts;
+};
+
+/*
+ * End-of-run statistics. The simulator counts them per basic block fetch,
+ * per RAM page allocation and per device register access, never per
+ * instruction, so they are always collected and only reported on request.
+ */
+struct RunStats {
+    struct Device {
+        std::string type;
+        besm::RV64Ptr address;
+        size_t accesses;
+    };
+
+    double seconds = 0;
+    size_t instrsExecuted = 0;
+    size_t blocksFetched = 0;
+    size_t bbCacheMisses = 0; ///< blocks missing in the hart caches
+    size_t blocksDecoded = 0; ///< missing in the shared cache as well
+    size_t ramPagesTouched = 0;
+    size_t ramChunksMapped = 0;
+    std::vector<Device> devices; ///< memory mapped registers, RAM aside
+    std::vector<PerfPhase> perfPhases;
+
+    size_t getBBCacheHits() const { return blocksFetched - bbCacheMisses; }
+    double getAverageBlockLength() const {
+        return blocksFetched == 0
+                   ? 0
+                   : static_cast<double>(instrsExecuted) / blocksFetched;
+    }
+};
+
+RunStats CollectStats(double seconds, std::vector<PerfPhase> perfPhases) {
+    besm::sim::Stats const &registry = Machine->getStats();
+    auto counter = [&](char const *name) {
+        auto const *counter = registry.findCounter(name);
+        return counter != nullptr ? counter->read() : 0;
+    };
+    auto gauge = [&](char const *name) {
+        auto const *gauge = registry.findGauge(name);
+        return gauge != nullptr ? static_cast<size_t>(gauge->read()) : 0;
+    };
+
+    RunStats stats;
+    stats.seconds = seconds;
+    stats.perfPhases = std::move(perfPhases);
+    stats.instrsExecuted = Machine->getInstrsExecuted();
+    stats.blocksFetched = counter("bb_cache.lookups");
+    stats.bbCacheMisses = counter("bb_cache.misses");
+    stats.blocksDecoded = counter("code_cache.decoded");
+    stats.ramPagesTouched = gauge("ram.pages_touched");
+    stats.ramChunksMapped = gauge("ram_page_allocator.chunks");
+
+    for (auto const &descriptor : Machine->getPhysMem()->getDevices()) {
+        auto const &device = *descriptor.device;
+        if (device.getType() != besm::mem::IPhysMemDevice::RAM) {
+            stats.devices.push_back({device.getTypeName(),
+                                     descriptor.range.leftBorder(),
+                                     device.getAccessesNum()});
+        }
+    }
+
+    return stats;
+}
+
+/**
+ * Rewrites the Prometheus text file every period while the machine runs,
+ * as the node_exporter textfile collector expects. The file is replaced
+ * with a rename, so a reader never sees a partial one.
+ */
+class StatsExporter : besm::INonCopyable {
+public:
+    StatsExporter(std::string path, std::chrono::duration<double> period)
+        : path_(std::move(path)), period_(period), stopped_(false),
+          failed_(false), thread_(&StatsExporter::loop, this) {}
+
+    ~StatsExporter() { this->stop(); }
+
+    /// Joins the exporter and writes the final statistics
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopped_) {
+                return;
+            }
+            stopped_ = true;
+        }
+        wakeUp_.notify_one();
+        thread_.join();
+        this->write();
+    }
+
+private:
+    void loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!wakeUp_.wait_for(lock, period_, [this] { return stopped_; })) {
+            this->write();
+        }
+    }
+
+    /// A failure is reported once, the next periods try again
+    void write() {
+        std::string tmpPath = path_ + ".tmp";
+        {
+            std::ofstream file(tmpPath);
+            Machine->getStats().writePrometheus(file);
+            if (!file) {
+                this->reportFailure("Can't write " + tmpPath);
+                return;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tmpPath, path_, error);
+        if (error) {
+            this->reportFailure("Can't rename " + tmpPath + " to " + path_ +
+                                ": " + error.message());
+        }
+    }
+
+    void reportFailure(std::string const &message) {
+        if (!failed_) {
+            failed_ = true;
+            std::clog << "[BESM-666] Stats export: " << message << std::endl;
+        }
+    }
+
+    std::string path_;
+    std::chrono::duration<double> period_;
+    std::mutex mutex_;
+    std::condition_variable wakeUp_;
+    bool stopped_;
+    bool failed_;
+    std::thread thread_;
+};
+
+void PrintStats(RunStats const &stats) {
+    std::clog << "[BESM-666] Blocks fetched " << stats.blocksFetched
+              << ", BB cache hits " << stats.getBBCacheHits() << ", misses "
+              << stats.bbCacheMisses << " (decoded " << stats.blocksDecoded
+              << "), average block length "
+              << stats.getAverageBlockLength() << std::endl;
+    std::clog << "[BESM-666] RAM pages touched " << stats.ramPagesTouched
+              << ", chunks mapped " << stats.ramChunksMapped << std::endl;
+    for (auto const &device : stats.devices) {
+        std::clog << "[BESM-666] " << device.type << " at 0x" << std::hex
+                  << device.address << std::dec << ": accesses "
+                  << device.accesses << std::endl;
+    }
+}
+
+void WriteStatsJSON(std::ostream &output, RunStats const &stats) {
+    output << "{\n"
+           << "  \"seconds\": " << stats.seconds << ",\n"
+           << "  \"instructions\": " << stats.instrsExecuted << ",\n"
+           << "  \"mips\": "
+           << (stats.seconds > 0 ? stats.instrsExecuted * 1e-6 / stats.seconds
+                                 : 0)
+           << ",\n"
+           << "  \"blocks_fetched\": " << stats.blocksFetched << ",\n"
+           << "  \"bb_cache_hits\": " << stats.getBBCacheHits() << ",\n"
+           << "  \"bb_cache_misses\": " << stats.bbCacheMisses << ",\n"
+           << "  \"blocks_decoded\": " << stats.blocksDecoded << ",\n"
+           << "  \"average_block_length\": " << stats.getAverageBlockLength()
+           << ",\n"
+           << "  \"ram_pages_touched\": " << stats.ramPagesTouched << ",\n"
+           << "  \"ram_chunks_mapped\": " << stats.ramChunksMapped << ",\n"
+           << "  \"devices\": [";
+    for (size_t i = 0; i < stats.devices.size(); ++i) {
+        auto const &device = stats.devices[i];
+        output << (i == 0 ? "\n" : ",\n") << "    {\"type\": \""
+               << device.type << "\", \"address\": " << device.address
+               << ", \"accesses\": " << device.accesses << "}";
+    }
+    output << (stats.devices.empty() ? "]" : "\n  ]");
+
+    output << ",\n  \"stats\": ";
+    Machine->getStats().writeJSON(output);
+
+    if (!stats.perfPhases.empty()) {
+        output << ",\n  \"host_counters\": [";
+        for (size_t i = 0; i < stats.perfPhases.size(); ++i) {
+            auto const &phase = stats.perfPhases[i];
+            output << (i == 0 ? "\n" : ",\n") << "    {\"phase\": \""
+                   << phase.name << "\", \"guest_instructions\": "
+                   << phase.instrsExecuted;
+            for (size_t event = 0; event < phase.counts.size(); ++event) {
+                if (phase.counts[event].has_value()) {
+                    output << ", \""
+                           << besm::util::PerfCounters::GetEventName(
+                                  static_cast<besm::util::PerfCounters::Event>(
+                                      event))
+                           << "\": " << *phase.counts[event];
+                }
+            }
+            output << "}";
+        }
+        output << "\n  ]";
+    }
+    output << "\n}" << std::endl;
+}
+
+void PrintPerfPhases(std::vector<PerfPhase> const &phases) {
+    using besm::util::PerfCounters;
+
+    for (auto const &phase : phases) {
+        std::clog << "[BESM-666] Host counters, " << phase.name << ":";
+        for (size_t event = 0; event < phase.counts.size(); ++event) {
+            std::clog << (event == 0 ? " " : ", ")
+                      << PerfCounters::GetEventName(
+                             static_cast<PerfCounters::Event>(event))
+                      << ' ';
+            if (phase.counts[event].has_value()) {
+                std::clog << *phase.counts[event];
+            } else {
+                std::clog << "n/a";
+            }
+        }
+        std::clog << std::endl;
+
+        if (phase.instrsExecuted == 0) {
+            continue;
+        }
+        auto const &cycles = phase.counts[PerfCounters::EVENT_CYCLES];
+        auto const &instrs = phase.counts[PerfCounters::EVENT_INSTRUCTIONS];
+        std::clog << "[BESM-666] Host counters, " << phase.name
+                  << ": per guest instruction";
+        if (cycles.has_value()) {
+            std::clog << " cycles "
+                      << static_cast<double>(*cycles) / phase.instrsExecuted;
+        }
+        if (instrs.has_value()) {
+            std::clog << (cycles.has_value() ? ", " : " ") << "instructions "
+                      << static_cast<double>(*instrs) / phase.instrsExecuted;
+        }
+        std::clog << std::endl;
+    }
+}
+
+/// Writes \p line with a single write(2), so the lines of concurrent jobs
+/// never interleave
+void WriteLine(int fd, std::string line) {
+    line += '\n';
+    for (size_t written = 0; written < line.size();) {
+        ssize_t bytes = write(fd, line.data() + written, line.size() - written);
+        if (bytes < 0 && errno != EINTR) {
+            return;
+        }
+        written += std::max<ssize_t>(bytes, 0);
+    }
+}
+
+/**
+ * Points stdin of a fork server job at its input file, /dev/null by default
+ * so that the job never reads the requests, and stdout at its output file,
+ * /dev/null by default so that the job never writes into the responses.
+ * Returns the error message on failure.
+ */
+std::string RedirectJobIO(std::string const &input, std::string const &output) {
+    int inputFd = open(input.empty() ? "/dev/null" : input.c_str(), O_RDONLY);
+    if (inputFd < 0) {
+        return input + ": " + strerror(errno);
+    }
+    dup2(inputFd, STDIN_FILENO);
+    close(inputFd);
+
+    int outputFd = open(output.empty() ? "/dev/null" : output.c_str(),
+                        O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (outputFd < 0) {
+        return output + ": " + strerror(errno);
+    }
+    dup2(outputFd, STDOUT_FILENO);
+    close(outputFd);
+    return {};
+}
+
+/*
+ * Fork server protocol (stdin/stdout, one text line per message):
+ *   request:  <job-id> [<input-file> [<output-file>]]
+ *   response: <job-id> exit <code> insns <count>
+ *             <job-id> signal <signo>
+ *             <job-id> error <message>
+ * The machine is created once and optionally warmed up by running it till
+ * the marker PC, then every request is served by a forked child, so each run
+ * starts from the pre-warmed machine state shared through copy-on-write.
+ *
+ * Up to numJobs children run at the same time and respond in the order they
+ * finish. A job reads the input file as stdin and writes its console to
+ * the output file, both /dev/null by default, so the server stdout carries
+ * the responses only.
+ */
+int RunForkServer(besm::RV64Ptr markerPC, bool a0Validation, size_t numJobs) {
+    if (markerPC != besm::sim::Hart::kNoStopPC) {
+        std::clog << "[BESM-666] INFO: Warming up till PC = 0x" << std::hex
+                  << markerPC << std::dec << std::endl;
+        Machine->runUntil(markerPC);
+
+        if (Machine->getHart().getGPRF().read(besm::exec::GPRF::PC) !=
+            markerPC) {
+            std::cerr << "[BESM-666] ERROR: Fork server marker PC has not "
+                         "been reached"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    size_t warmupInstrs = Machine->getInstrsExecuted();
+
+    std::clog << "[BESM-666] INFO: Fork server is ready" << std::endl;
+
+    // Job ids of the running children
+    std::map<pid_t, std::string> running;
+    auto reapChild = [&](int options) {
+        int status = 0;
+        pid_t child = waitpid(-1, &status, options);
+        if (child < 0 && errno == ECHILD) {
+            running.clear();
+        }
+        if (child <= 0) {
+            return false;
+        }
+
+        auto it = running.find(child);
+        if (it != running.end()) {
+            if (WIFSIGNALED(status)) {
+                WriteLine(STDOUT_FILENO,
+                          it->second + " signal " +
+                              std::to_string(WTERMSIG(status)));
+            }
+            running.erase(it);
+        }
+        return true;
+    };
+
+    auto serve = [&](std::string const &request) {
+        std::istringstream fields(request);
+        std::string jobId;
+        std::string input;
+        std::string output;
+        fields >> jobId >> input >> output;
+        if (jobId.empty()) {
+            return true;
+        }
+
+        std::cout.flush();
+        std::clog.flush();
+
+        pid_t child = fork();
+        if (child < 0) {
+            std::cerr << "[BESM-666] ERROR: Fork server failed to fork"
+                      << std::endl;
+            return false;
+        }
+
+        if (child == 0) {
+            int responseFd = dup(STDOUT_FILENO);
+            std::string error = RedirectJobIO(input, output);
+            if (!error.empty()) {
+                WriteLine(responseFd, jobId + " error " + error);
+                _exit(1);
+            }
+
+            Machine->afterFork();
+            Machine->run();
+
+            int code = ExitCode(a0Validation);
+            size_t instrs = Machine->getInstrsExecuted() - warmupInstrs;
+            // Flushes buffered device output ahead of the response
+            Machine.reset();
+            std::cout.flush();
+
+            WriteLine(responseFd, jobId + " exit " + std::to_string(code) +
+                                      " insns " + std::to_string(instrs));
+            _exit(code);
+        }
+
+        running.emplace(child, jobId);
+        return true;
+    };
+
+    // The requests are read with poll(2) to report killed children while
+    // the client waits for their responses
+    constexpr int kReapPeriodMs = 10;
+    std::string pending;
+    bool eof = false;
+    while (!eof || !pending.empty() || !running.empty()) {
+        if (running.size() == numJobs) {
+            reapChild(0);
+            continue;
+        }
+
+        size_t newline = pending.find('\n');
+        if (newline != std::string::npos || (eof && !pending.empty())) {
+            std::string request = pending.substr(0, newline);
+            pending.erase(0, newline == std::string::npos ? newline
+                                                          : newline + 1);
+            if (!serve(request)) {
+                return 1;
+            }
+            continue;
+        }
+
+        if (eof) {
+            reapChild(0);
+            continue;
+        }
+
+        pollfd requests = {.fd = STDIN_FILENO, .events = POLLIN, .revents = 0};
+        int ready = poll(&requests, 1, running.empty() ? -1 : kReapPeriodMs);
+        while (reapChild(WNOHANG)) {
+        }
+        if (ready <= 0) {
+            continue;
+        }
+
+        char buffer[4096];
+        ssize_t bytes = read(STDIN_FILENO, buffer, sizeof(buffer));
+        if (bytes > 0) {
+            pending.append(buffer, bytes);
+        } else if (bytes == 0 || errno != EINTR) {
+            eof = true;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Interval-parallel run: the fast pass runs the machine without hooks and
+ * forks a child at every interval boundary. The child holds the checkpoint
+ * of the whole machine through copy-on-write and replays the interval with
+ * tracing and verbose logging into its own files, while the fast pass goes
+ * on. Once all the children have finished, their outputs are appended to
+ * the trace file and to the log in the interval order.
+ *
+ * The intervals end at the first basic block boundary after a multiple of
+ * the interval size, which the fast pass and the replay reach identically
+ * as long as the guest takes no asynchronous input (UART RX). The guest
+ * console output comes from the fast pass only.
+ */
+int RunIntervals(size_t intervalSize, size_t numJobs,
+                 std::string const &traceFilename) {
+    if (Machine->getHartsNum() != 1) {
+        std::cerr << "[BESM-666] ERROR: Interval-parallel run needs a single "
+                     "hart"
+                  << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path partsPrefix =
+        std::filesystem::temp_directory_path() /
+        ("besm666-" + std::to_string(getpid()) + "-interval-");
+    auto partPath = [&](size_t interval, char const *suffix) {
+        return partsPrefix.string() + std::to_string(interval) + suffix;
+    };
+
+    std::clog << "[BESM-666] INFO: Replaying intervals of " << intervalSize
+              << " instructions on " << numJobs << " processes" << std::endl;
+
+    bool failed = false;
+    size_t running = 0;
+    auto waitChild = [&]() {
+        int status = 0;
+        if (wait(&status) > 0) {
+            --running;
+            failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+        } else if (errno != EINTR) {
+            running = 0;
+            failed = true;
+        }
+    };
+
+    size_t intervals = 0;
+    bool stopped = false;
+    while (!stopped) {
+        if (running == numJobs) {
+            waitChild();
+        }
+
+        size_t intervalEnd = (intervals + 1) * intervalSize;
+        std::cout.flush();
+        std::clog.flush();
+
+        pid_t child = fork();
+        if (child < 0) {
+            std::cerr << "[BESM-666] ERROR: Failed to fork an interval"
+                      << std::endl;
+            return 1;
+        }
+
+        if (child == 0) {
+            int devNull = open("/dev/null", O_WRONLY);
+            dup2(devNull, STDOUT_FILENO);
+            dup2(devNull, STDERR_FILENO);
+
+            std::ofstream log(partPath(intervals, ".log"));
+            std::clog.rdbuf(log.rdbuf());
+            if (!traceFilename.empty()) {
+                traceFile.close();
+                traceFile.open(partPath(intervals, ".trace"));
+                optionTracingEnabled = true;
+            }
+            if (optionDumpInstructions || optionTracingEnabled) {
+                InitVerboseLogging();
+            }
+
+            Machine->afterFork();
+            Machine->runFor(intervalEnd);
+
+            traceFile.flush();
+            log.flush();
+            _exit(traceFile.fail() || log.fail() ? 1 : 0);
+        }
+
+        ++running;
+        ++intervals;
+        stopped = Machine->runFor(intervalEnd);
+    }
+    while (running != 0) {
+        waitChild();
+    }
+
+    if (failed) {
+        std::cerr << "[BESM-666] ERROR: Interval replay has failed"
+                  << std::endl;
+    }
+
+    for (size_t interval = 0; interval < intervals; ++interval) {
+        std::ifstream log(partPath(interval, ".log"));
+        if (log.peek() != std::ifstream::traits_type::eof()) {
+            std::clog << log.rdbuf();
+        }
+        std::filesystem::remove(partPath(interval, ".log"));
+
+        if (!traceFilename.empty()) {
+            std::ifstream trace(partPath(interval, ".trace"));
+            if (trace.peek() != std::ifstream::traits_type::eof()) {
+                traceFile << trace.rdbuf();
+            }
+            std::filesystem::remove(partPath(interval, ".trace"));
+        }
+    }
+    traceFile.flush();
+
+    std::clog << "[BESM-666] Intervals replayed: " << intervals
+              << ", Insns " << Machine->getInstrsExecuted() << ", fast pass "
+              << Machine->getRunTime(0).count() << "s" << std::endl;
+
+    return failed ? 1 : 0;
+}
+
+int RunBatch(besm::sim::ConfigBuilder const &base,
+             std::string const &manifestPath, std::string const &resultsPath,
+             size_t numThreads) {
+    std::vector<besm::sim::BatchRunner::Job> jobs;
+    std::unique_ptr<besm::sim::BatchRunner> runner;
+    try {
+        std::ifstream manifest(manifestPath);
+        jobs = besm::sim::BatchRunner::ParseManifest(manifest);
+        runner = std::make_unique<besm::sim::BatchRunner>(base, numThreads);
+    } catch (besm::sim::InvalidConfiguration const &error) {
+        std::cerr << "[BESM-666] ERROR: " << error.what() << std::endl;
+        return 1;
+    }
+
+    std::clog << "[BESM-666] INFO: Running " << jobs.size() << " jobs on "
+              << numThreads << " threads" << std::endl;
+
+    auto time_start = std::chrono::steady_clock::now();
+    auto results = runner->run(jobs);
+    auto time_end = std::chrono::steady_clock::now();
+
+    size_t instrsExecuted = 0;
+    bool failed = false;
+    for (auto const &result : results) {
+        instrsExecuted += result.instrsExecuted;
+        failed |= result.status == besm::sim::BatchRunner::STATUS_ERROR ||
+                  result.status == besm::sim::BatchRunner::STATUS_TIMEOUT;
+    }
+
+    double ellapsedSecond =
+        std::chrono::duration<double>(time_end - time_start).count();
+    std::clog << "[BESM-666] Batch finished." << std::endl;
+    std::clog << "[BESM-666] Time = " << ellapsedSecond << "s, Insns "
+              << instrsExecuted << ", MIPS = "
+              << static_cast<double>(instrsExecuted) * 1e-6 / ellapsedSecond
+              << ", RAM chunks mapped "
+              << runner->getRAMChunkPool().getChunksNum() << std::endl;
+
+    if (resultsPath.empty()) {
+        besm::sim::BatchRunner::WriteResults(std::cout, jobs, results);
+    } else {
+        std::ofstream resultsFile(resultsPath);
+        besm::sim::BatchRunner::WriteResults(resultsFile, jobs, results);
+    }
+
+    return failed ? 1 : 0;
+}
+
 int main(int argc, char *argv[]) {
     besm::sim::ConfigBuilder configBuilder;
 
     CLI::App app(
         "BESM-666 (Best Ever SiMulator is a toy RISCV functional simulator");
 
-    app.add_option_function<std::string>(
-           "-e,--executable",
-           [&](std::string const &string) {
-               configBuilder.setExecutablePath(string);
-           },
-           "Setups the file to be executed with the simulator")
-        ->required()
-        ->check(CLI::ExistingFile)
+    auto executableOption =
+        app.add_option_function<std::string>(
+               "-e,--executable",
+               [&](std::string const &string) {
+                   configBuilder.setExecutablePath(string);
+               },
+               "Setups the file to be executed with the simulator")
+            ->check(CLI::ExistingFile)
+            ->group("Input");
+
+    bool userMode = false;
+    app.add_flag("--user-mode", userMode,
+                 "Run a statically linked Linux executable serving its "
+                 "syscalls in the simulator")
+        ->default_val(false)
         ->group("Input");
 
+    std::vector<std::string> guestArgs;
+    app.add_option("guest-args", guestArgs,
+                   "Arguments passed to the guest program in user mode")
+        ->group("Input");
+
+    app.add_option_function<size_t>(
+           "--harts",
+           [&](size_t value) { configBuilder.setNumHarts(value); },
+           "Number of harts, each runs on its own host thread unless "
+           "--host-threads is set")
+        ->group("Harts");
+
+    app.add_option_function<size_t>(
+           "--host-threads",
+           [&](size_t value) { configBuilder.setHostThreads(value); },
+           "Multiplex the harts onto a pool of host threads with work "
+           "stealing")
+        ->group("Harts");
+
+    app.add_option_function<size_t>(
+           "--quantum",
+           [&](size_t value) { configBuilder.setHartQuantum(value); },
+           "Instructions a hart runs on a pooled host thread before yielding "
+           "it to another hart")
+        ->group("Harts");
+
+    bool deterministic = false;
+    app.add_flag("--deterministic", deterministic,
+                 "Interleave the harts in fixed quanta, on --host-threads "
+                 "threads synchronized at quantum boundaries, so the runs "
+                 "are reproducible")
+        ->default_val(false)
+        ->group("Harts");
+
+    app.add_option_function<uint64_t>(
+           "--sched-seed",
+           [&](uint64_t value) { configBuilder.setSchedulerSeed(value); },
+           "Seed of the hart order in deterministic rounds, hart id order "
+           "if 0")
+        ->group("Harts");
+
+    bool sharedCodeCache = false;
+    app.add_flag("--shared-code-cache", sharedCodeCache,
+                 "Share decoded blocks with the other machines of the "
+                 "process, for guests which run only the code of the ELF "
+                 "image")
+        ->default_val(false)
+        ->group("Harts");
+
+    app.add_option_function<std::vector<int>>(
+           "--hart-affinity",
+           [&](std::vector<int> const &cpus) {
+               for (int cpu : cpus) {
+                   configBuilder.addHartAffinity(cpu);
+               }
+           },
+           "Pin the hart threads to the host CPUs, one CPU per hart, e.g. "
+           "0,2,4,6")
+        ->delimiter(',')
+        ->group("Harts");
+
     app.add_option_function<std::string>(
            "--ram",
            [&](std::string const &string) {
@@ -235,6 +954,40 @@ int main(int argc, char *argv[]) {
         ->force_callback()
         ->group("Memory");
 
+    app.add_option_function<std::string>(
+           "--uart",
+           [&](std::string const &string) {
+               configBuilder.setUartAddress(std::stoull(string, nullptr, 0));
+           },
+           "Map 16550 UART at the physical address, e.g. 0x10000000")
+        ->group("Devices");
+
+    app.add_option_function<std::string>(
+           "--uart-input",
+           [&](std::string const &string) {
+               configBuilder.setUartInputPath(string);
+           },
+           "Feed UART RX from the file instead of stdin")
+        ->check(CLI::ExistingFile)
+        ->group("Devices");
+
+    app.add_option_function<std::string>(
+           "--clint",
+           [&](std::string const &string) {
+               configBuilder.setTimerAddress(std::stoull(string, nullptr, 0));
+           },
+           "Map CLINT at the physical address, e.g. 0x2000000")
+        ->group("Devices");
+
+    app.add_option_function<besm::RV64UDWord>(
+           "--timer-freq",
+           [&](besm::RV64UDWord value) {
+               configBuilder.setTimerFrequency(value);
+           },
+           "Setup mtime frequency in Hz, the hart runs 1 instruction per ns "
+           "of virtual time")
+        ->group("Devices");
+
     app.add_flag("-v,--verbose", optionDumpInstructions,
                  "Enables per-instruction machine state logging")
         ->default_val(false)
@@ -253,27 +1006,453 @@ int main(int argc, char *argv[]) {
         ->default_val(false)
         ->group("Validation");
 
+    bool forkServer = false;
+    auto forkServerOption =
+        app.add_flag("--fork-server", forkServer,
+                     "Serve job requests from stdin by forking the "
+                     "initialized machine, see RunForkServer for the protocol")
+            ->default_val(false)
+            ->group("Fork server");
+
+    size_t forkServerJobs = std::max(std::thread::hardware_concurrency(), 1u);
+    app.add_option("--fork-server-jobs", forkServerJobs,
+                   "Number of requests served at the same time")
+        ->check(CLI::PositiveNumber)
+        ->group("Fork server");
+
+    std::string forkServerMarker;
+    app.add_option("--fork-server-marker", forkServerMarker,
+                   "Basic block entry PC to run the machine till before "
+                   "serving the first request")
+        ->check(CheckAddress)
+        ->group("Fork server");
+
+    std::string bbvFilename;
+    app.add_option("--bbv", bbvFilename,
+                   "Write SimPoint basic block vectors of the boot hart to "
+                   "the .bb file")
+        ->group("Profiling");
+
+    size_t bbvInterval = 100'000'000;
+    app.add_option("--bbv-interval", bbvInterval,
+                   "Instructions per basic block vector")
+        ->check(CLI::PositiveNumber)
+        ->group("Profiling");
+
+    std::string simPointsFilename;
+    app.add_option("--simpoints", simPointsFilename,
+                   "SimPoint .simpts file: dump the state at the start of "
+                   "the chosen intervals")
+        ->check(CLI::ExistingFile)
+        ->group("Profiling");
+
+    std::string simPointDumpDir = "simpoints";
+    app.add_option("--simpoint-dump", simPointDumpDir,
+                   "Directory of the state dumps, one subdirectory per "
+                   "interval")
+        ->group("Profiling");
+
+    bool stats = false;
+    app.add_flag("--stats", stats,
+                 "Report basic block, RAM and device statistics at exit")
+        ->default_val(false)
+        ->group("Profiling");
+
+    std::string statsJSON;
+    app.add_option("--stats-json", statsJSON,
+                   "Write the statistics to the JSON file at exit")
+        ->group("Profiling");
+
+    std::string statsPrometheus;
+    auto statsPrometheusOption =
+        app.add_option("--stats-prometheus", statsPrometheus,
+                       "Rewrite the statistics registry to the file in the "
+                       "Prometheus text format while running, for a "
+                       "textfile collector")
+            ->group("Profiling");
+
+    double statsPeriod = 10;
+    app.add_option("--stats-period", statsPeriod,
+                   "Seconds between --stats-prometheus rewrites")
+        ->check(CLI::PositiveNumber)
+        ->needs(statsPrometheusOption)
+        ->group("Profiling");
+
+    bool instrMix = false;
+    app.add_flag("--instr-mix", instrMix,
+                 "Report the executed instruction mix at exit, counted per "
+                 "basic block run")
+        ->default_val(false)
+        ->group("Profiling");
+
+    std::string instrMixJSON;
+    app.add_option("--instr-mix-json", instrMixJSON,
+                   "Write the instruction mix to the JSON file at exit")
+        ->group("Profiling");
+
+    bool profile = false;
+    app.add_flag("--profile", profile,
+                 "Report the guest functions executing the most instructions "
+                 "at exit, counted per basic block run and symbolized by the "
+                 "ELF symbol table")
+        ->default_val(false)
+        ->group("Profiling");
+
+    size_t profileTop = 20;
+    app.add_option("--profile-top", profileTop,
+                   "Number of functions or call paths reported by --profile, "
+                   "--call-graph and --sample-pc")
+        ->check(CLI::PositiveNumber)
+        ->group("Profiling");
+
+    std::string profileFolded;
+    app.add_option("--profile-folded", profileFolded,
+                   "Write the flat profile to the file at exit in the folded "
+                   "stacks format of flamegraph.pl")
+        ->group("Profiling");
+
+    std::string callGraph;
+    app.add_option("--call-graph", callGraph,
+                   "Track guest calls with a shadow call stack, report the "
+                   "call paths executing the most instructions at exit and "
+                   "write them to the file in the folded stacks format")
+        ->group("Profiling");
+
+    size_t callGraphDepth = besm::sim::CallGraphProfiler::kDefaultMaxDepth;
+    app.add_option("--call-graph-depth", callGraphDepth,
+                   "Maximum depth of the --call-graph shadow call stack")
+        ->check(CLI::PositiveNumber)
+        ->group("Profiling");
+
+    bool samplePC = false;
+    app.add_flag("--sample-pc", samplePC,
+                 "Sample the guest PC and privilege level of the harts with a "
+                 "SIGPROF host timer, report the most sampled functions at "
+                 "exit")
+        ->default_val(false)
+        ->group("Profiling");
+
+    unsigned sampleFrequency = 997;
+    app.add_option("--sample-frequency", sampleFrequency,
+                   "Samples per second of --sample-pc and --sample-folded")
+        ->check(CLI::PositiveNumber)
+        ->group("Profiling");
+
+    std::string sampleFolded;
+    app.add_option("--sample-folded", sampleFolded,
+                   "Sample the guest PC as --sample-pc does and write the "
+                   "samples to the file at exit in the folded stacks format, "
+                   "rooted by the privilege level")
+        ->group("Profiling");
+
+    bool perfCounters = false;
+    auto perfCountersOption =
+        app.add_flag("--perf-counters", perfCounters,
+                     "Count host cycles, instructions, branch and cache "
+                     "misses with perf_event_open separately for the load, "
+                     "warm-up and run phases")
+            ->default_val(false)
+            ->group("Profiling");
+
+    size_t perfWarmup = 0;
+    app.add_option("--perf-warmup", perfWarmup,
+                   "Guest instructions of the warm-up phase, single hart "
+                   "only")
+        ->needs(perfCountersOption)
+        ->group("Profiling");
+
+    std::string chromeTrace;
+    app.add_option("--chrome-trace", chromeTrace,
+                   "Write a timeline of the simulator phases (loading, block "
+                   "decoding, RAM first touches, device threads) to the file "
+                   "in the Chrome trace-event format, for chrome://tracing "
+                   "or Perfetto")
+        ->group("Profiling");
+
+    size_t intervalSize = 0;
+    auto intervalsOption =
+        app.add_option("--intervals", intervalSize,
+                       "Run without instrumentation, replaying every interval "
+                       "of this many instructions with tracing and logging in "
+                       "parallel from a checkpoint, see RunIntervals")
+            ->group("Intervals");
+    // The intervals are replayed with tracing and logging only and the fork
+    // server jobs only respond with the exit code, so the profilers and the
+    // statistics would never be reported
+    for (char const *name :
+         {"--bbv", "--stats", "--stats-json", "--stats-prometheus",
+          "--instr-mix", "--instr-mix-json", "--profile", "--profile-folded",
+          "--call-graph", "--sample-pc", "--sample-folded",
+          "--perf-counters"}) {
+        intervalsOption->excludes(name);
+        forkServerOption->excludes(name);
+    }
+
+    size_t intervalJobs = std::max(std::thread::hardware_concurrency(), 1u);
+    app.add_option("--interval-jobs", intervalJobs,
+                   "Number of intervals replayed at the same time")
+        ->check(CLI::PositiveNumber)
+        ->group("Intervals");
+
+    std::string batchManifest;
+    app.add_option("--batch", batchManifest,
+                   "Run the jobs listed in the manifest in parallel instead "
+                   "of a single executable, see BatchRunner::Job for the "
+                   "format")
+        ->check(CLI::ExistingFile)
+        ->excludes(executableOption)
+        ->group("Batch");
+
+    std::string batchResults;
+    app.add_option("--batch-results", batchResults,
+                   "Write the JSON job results to the file instead of stdout")
+        ->group("Batch");
+
+    size_t batchJobs = std::max(std::thread::hardware_concurrency(), 1u);
+    app.add_option("--batch-jobs", batchJobs,
+                   "Number of jobs running at the same time")
+        ->group("Batch");
+
     CLI11_PARSE(app, argc, argv);
 
+    if (!chromeTrace.empty()) {
+        if (!besm::util::Tracer::Start(chromeTrace)) {
+            std::cerr << "[BESM-666] ERROR: Failed to open " << chromeTrace
+                      << std::endl;
+            return 1;
+        }
+        besm::util::Tracer::SetThreadName("main");
+    }
+    // Completes the trace file on any return, a no-op if it isn't written
+    struct TracerStopper {
+        ~TracerStopper() { besm::util::Tracer::Stop(); }
+    } tracerStopper;
+
+    configBuilder.setUserMode(userMode);
+    configBuilder.setDeterministic(deterministic);
+    configBuilder.setSharedCodeCache(sharedCodeCache);
+
+    if (!batchManifest.empty()) {
+        return RunBatch(configBuilder, batchManifest, batchResults, batchJobs);
+    }
+    if (executableOption->count() == 0) {
+        std::cerr << "--executable is required" << std::endl;
+        return 1;
+    }
+    for (auto const &arg : guestArgs) {
+        configBuilder.addGuestArg(arg);
+    }
+
+    // Opened before the harts are created, so their threads are counted
+    std::unique_ptr<besm::util::PerfCounters> hostCounters;
+    std::vector<PerfPhase> perfPhases;
+    if (perfCounters) {
+        hostCounters = std::make_unique<besm::util::PerfCounters>();
+        if (!hostCounters->available()) {
+            std::clog << "[BESM-666] WARNING: Host performance counters are "
+                         "unavailable: "
+                      << hostCounters->getError() << std::endl;
+            hostCounters.reset();
+        }
+    }
+    auto measurePhase = [&](char const *name, auto &&body) {
+        if (hostCounters == nullptr) {
+            return body();
+        }
+        size_t instrs = Machine != nullptr ? Machine->getInstrsExecuted() : 0;
+        hostCounters->start();
+        auto result = body();
+        auto counts = hostCounters->stop();
+        perfPhases.push_back(
+            {name, Machine->getInstrsExecuted() - instrs, counts});
+        return result;
+    };
+
     std::clog << "[BESM-666] INFO: Creating RISCV Machine->" << std::endl;
     besm::sim::Config config = configBuilder.build();
-    Machine = std::make_unique<besm::sim::Machine>(config);
+    measurePhase("load", [&] {
+        Machine = std::make_unique<besm::sim::Machine>(config);
+        return true;
+    });
 
     if (!traceFilename.empty()) {
-        optionTracingEnabled = true;
         traceFile.open(traceFilename);
     }
 
+    if (intervalSize != 0) {
+        int code = RunIntervals(intervalSize, intervalJobs, traceFilename);
+        return code != 0 ? code : ExitCode(a0Validation);
+    }
+
+    if (!traceFilename.empty()) {
+        optionTracingEnabled = true;
+    }
     if (optionDumpInstructions || optionTracingEnabled) {
         InitVerboseLogging();
     }
 
+    std::ofstream bbvFile;
+    std::unique_ptr<besm::sim::BBVProfiler> bbvProfiler;
+    if (!bbvFilename.empty()) {
+        bbvFile.open(bbvFilename);
+        bbvProfiler =
+            std::make_unique<besm::sim::BBVProfiler>(bbvFile, bbvInterval);
+        if (!simPointsFilename.empty()) {
+            std::ifstream simPoints(simPointsFilename);
+            bbvProfiler->setSimPoints(
+                besm::sim::BBVProfiler::ReadSimPoints(simPoints),
+                simPointDumpDir, Machine->getPhysMem());
+        }
+        Machine->attachProfiler(0, bbvProfiler.get());
+    }
+
+    std::vector<std::unique_ptr<besm::sim::InstrMixProfiler>> instrMixProfilers;
+    if (instrMix || !instrMixJSON.empty()) {
+        for (size_t hartId = 0; hartId < Machine->getHartsNum(); ++hartId) {
+            instrMixProfilers.push_back(
+                std::make_unique<besm::sim::InstrMixProfiler>());
+            Machine->attachProfiler(hartId, instrMixProfilers.back().get());
+        }
+    }
+
+    std::vector<std::unique_ptr<besm::sim::FlatProfiler>> flatProfilers;
+    if (profile || !profileFolded.empty()) {
+        for (size_t hartId = 0; hartId < Machine->getHartsNum(); ++hartId) {
+            flatProfilers.push_back(
+                std::make_unique<besm::sim::FlatProfiler>());
+            Machine->attachProfiler(hartId, flatProfilers.back().get());
+        }
+    }
+
+    std::vector<std::unique_ptr<besm::sim::CallGraphProfiler>>
+        callGraphProfilers;
+    if (!callGraph.empty()) {
+        for (size_t hartId = 0; hartId < Machine->getHartsNum(); ++hartId) {
+            callGraphProfilers.push_back(
+                std::make_unique<besm::sim::CallGraphProfiler>(
+                    callGraphDepth));
+            Machine->attachProfiler(hartId, callGraphProfilers.back().get());
+        }
+    }
+
+    if (forkServer) {
+        besm::RV64Ptr markerPC = besm::sim::Hart::kNoStopPC;
+        if (!forkServerMarker.empty()) {
+            markerPC = std::stoull(forkServerMarker, nullptr, 0);
+        }
+
+        return RunForkServer(markerPC, a0Validation, forkServerJobs);
+    }
+
+    std::unique_ptr<StatsExporter> statsExporter;
+    if (!statsPrometheus.empty()) {
+        statsExporter = std::make_unique<StatsExporter>(
+            statsPrometheus, std::chrono::duration<double>(statsPeriod));
+    }
+
+    std::unique_ptr<besm::sim::PCSampler> pcSampler;
+    if (samplePC || !sampleFolded.empty()) {
+        std::vector<besm::sim::Hart const *> harts;
+        for (size_t hartId = 0; hartId < Machine->getHartsNum(); ++hartId) {
+            harts.push_back(&Machine->getHart(hartId));
+        }
+        pcSampler = std::make_unique<besm::sim::PCSampler>(sampleFrequency);
+        if (!pcSampler->start(harts)) {
+            std::clog << "[BESM-666] WARNING: PC sampler is unavailable: "
+                      << pcSampler->getError() << std::endl;
+            pcSampler.reset();
+        }
+    }
+
     std::clog << "[BESM-666] INFO: Starting simulation" << std::endl;
 
     auto time_start = std::chrono::steady_clock::now();
-    Machine->run();
+    bool stopped = false;
+    if (perfWarmup != 0 && Machine->getHartsNum() != 1) {
+        std::clog << "[BESM-666] WARNING: Warm-up phase needs a single hart, "
+                     "counting the whole run"
+                  << std::endl;
+    } else if (perfWarmup != 0) {
+        stopped = measurePhase("warm-up",
+                               [&] { return Machine->runFor(perfWarmup); });
+    }
+    if (!stopped) {
+        measurePhase("run", [&] {
+            Machine->run();
+            return true;
+        });
+    }
     auto time_end = std::chrono::steady_clock::now();
 
+    if (statsExporter != nullptr) {
+        statsExporter->stop();
+    }
+    if (pcSampler != nullptr) {
+        pcSampler->stop();
+        auto sampled = besm::sim::PCSampler::Symbolize(
+            Machine->getSymtab(), pcSampler->getSamples());
+        if (samplePC) {
+            besm::sim::PCSampler::Print(std::clog, sampled, profileTop);
+        }
+        if (pcSampler->getDroppedNum() != 0) {
+            std::clog << "[BESM-666] WARNING: " << pcSampler->getDroppedNum()
+                      << " PC samples dropped, the sample table is full"
+                      << std::endl;
+        }
+        if (!sampleFolded.empty()) {
+            std::ofstream foldedFile(sampleFolded);
+            besm::sim::PCSampler::WriteFolded(foldedFile, sampled);
+        }
+    }
+    if (!instrMixProfilers.empty()) {
+        besm::sim::InstrMixProfiler::Mix mix;
+        for (size_t hartId = 0; hartId < instrMixProfilers.size(); ++hartId) {
+            instrMixProfilers[hartId]->finish(Machine->getHart(hartId));
+            mix += instrMixProfilers[hartId]->getMix();
+        }
+        if (instrMix) {
+            besm::sim::InstrMixProfiler::Print(std::clog, mix);
+        }
+        if (!instrMixJSON.empty()) {
+            std::ofstream instrMixFile(instrMixJSON);
+            besm::sim::InstrMixProfiler::WriteJSON(instrMixFile, mix);
+            instrMixFile << std::endl;
+        }
+    }
+    if (!flatProfilers.empty()) {
+        besm::sim::FlatProfiler::Counts counts;
+        for (size_t hartId = 0; hartId < flatProfilers.size(); ++hartId) {
+            flatProfilers[hartId]->finish(Machine->getHart(hartId));
+            flatProfilers[hartId]->addCounts(counts);
+        }
+        auto flatProfile =
+            besm::sim::FlatProfiler::Symbolize(Machine->getSymtab(), counts);
+        if (profile) {
+            besm::sim::FlatProfiler::Print(std::clog, flatProfile, profileTop);
+        }
+        if (!profileFolded.empty()) {
+            std::ofstream foldedFile(profileFolded);
+            besm::sim::FlatProfiler::WriteFolded(foldedFile, flatProfile);
+        }
+    }
+    if (!callGraphProfilers.empty()) {
+        besm::sim::CallGraphProfiler::Counts counts;
+        for (size_t hartId = 0; hartId < callGraphProfilers.size(); ++hartId) {
+            callGraphProfilers[hartId]->finish(Machine->getHart(hartId));
+            callGraphProfilers[hartId]->addCounts(counts);
+        }
+        auto callPaths = besm::sim::CallGraphProfiler::Symbolize(
+            Machine->getSymtab(), counts);
+        besm::sim::CallGraphProfiler::Print(std::clog, callPaths, profileTop);
+        std::ofstream foldedFile(callGraph);
+        besm::sim::CallGraphProfiler::WriteFolded(foldedFile, callPaths);
+    }
+    if (bbvProfiler != nullptr) {
+        bbvProfiler->finish(Machine->getHart());
+        std::clog << "[BESM-666] Basic block vectors: "
+                  << bbvProfiler->getIntervalsNum() << std::endl;
+    }
+
     double ellapsedSecond =
         std::chrono::duration_cast<std::chrono::nanoseconds>(time_end -
                                                              time_start)
@@ -286,15 +1465,31 @@ int main(int argc, char *argv[]) {
     std::clog << "[BESM-666] Simulation finished." << std::endl;
     std::clog << "[BESM-666] Time = " << ellapsedSecond << "s, Insns "
               << instrsExecuted << ", MIPS = " << mips << std::endl;
-    besm::exec::GPRFStateDumper(std::clog).dump(Machine->getHart().getGPRF());
-
-    if (a0Validation) {
-        if (Machine->getHart().getGPRF().read(besm::exec::GPRF::X10) == 1) {
-            return 0;
-        } else {
-            return 1;
+    if (Machine->getHartsNum() > 1) {
+        for (size_t hartId = 0; hartId < Machine->getHartsNum(); ++hartId) {
+            size_t hartInstrs = Machine->getHart(hartId).getInstrsExecuted();
+            double hartSeconds = Machine->getRunTime(hartId).count();
+            std::clog << "[BESM-666] Hart " << hartId << ": Time = "
+                      << hartSeconds << "s, Insns " << hartInstrs
+                      << ", MIPS = "
+                      << static_cast<double>(hartInstrs) * 1e-6 / hartSeconds
+                      << std::endl;
         }
-    } else {
-        return 0;
     }
+    if (!perfPhases.empty()) {
+        PrintPerfPhases(perfPhases);
+    }
+    if (stats || !statsJSON.empty()) {
+        RunStats runStats = CollectStats(ellapsedSecond, perfPhases);
+        if (stats) {
+            PrintStats(runStats);
+        }
+        if (!statsJSON.empty()) {
+            std::ofstream statsFile(statsJSON);
+            WriteStatsJSON(statsFile, runStats);
+        }
+    }
+    besm::exec::GPRFStateDumper(std::clog).dump(Machine->getHart().getGPRF());
+
+    return ExitCode(a0Validation);
 }
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+Runs the e2e benchmarks (e2e_test/*-bench.c) on the standalone simulator
+and compares their MIPS with a stored baseline.
+
+A benchmark regresses if its best MIPS over the repeats is below the
+baseline one by more than the threshold. The exit code is 1 if a benchmark
+has regressed or failed its a0 validation. MIPS depend on the host, so the
+baseline is recorded on the host running the comparison with --update.
+
+Example:
+    tools/mips-regression.py \\
+        --simulator build/besm-666/standalone/besm666_standalone \\
+        --bench-dir build/e2e --baseline e2e_test/bench-baseline.json
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+
+def find_benchmarks(bench_dir):
+    return sorted(name for name in os.listdir(bench_dir)
+                  if name.endswith('-bench') and
+                  os.access(os.path.join(bench_dir, name), os.X_OK))
+
+
+def run_benchmark(simulator, executable):
+    """Returns the MIPS of a run, None if the validation has failed"""
+    with tempfile.NamedTemporaryFile(suffix='.json') as stats:
+        result = subprocess.run(
+            [simulator, '--a0-validation', '--executable', executable,
+             '--stats-json', stats.name],
+            stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        if result.returncode != 0:
+            return None
+        return json.load(stats)['mips']
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='MIPS regression check of the e2e benchmarks')
+    parser.add_argument('--simulator', required=True,
+                        help='besm666_standalone executable')
+    parser.add_argument('--bench-dir', required=True,
+                        help='directory of the built *-bench executables')
+    parser.add_argument('--baseline', required=True,
+                        help='JSON file mapping benchmark names to MIPS')
+    parser.add_argument('--threshold', type=float, default=0.05,
+                        help='allowed relative slowdown, 0.05 by default')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='runs per benchmark, the best one counts')
+    parser.add_argument('--update', action='store_true',
+                        help='record the measured MIPS as the baseline')
+    parser.add_argument('--results',
+                        help='write the measured MIPS to the JSON file')
+    args = parser.parse_args()
+
+    baseline = {}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as baseline_file:
+            baseline = json.load(baseline_file)
+
+    benchmarks = find_benchmarks(args.bench_dir)
+    if not benchmarks:
+        print('No benchmarks found in ' + args.bench_dir, file=sys.stderr)
+        return 1
+
+    measured = {}
+    failed = False
+    print('%-24s %10s %10s %8s' % ('benchmark', 'MIPS', 'baseline', 'change'))
+    for name in benchmarks:
+        runs = [run_benchmark(args.simulator,
+                              os.path.join(args.bench_dir, name))
+                for _ in range(args.repeat)]
+        if None in runs:
+            print('%-24s %10s' % (name, 'FAILED'))
+            failed = True
+            continue
+
+        mips = max(runs)
+        measured[name] = mips
+        if name not in baseline:
+            print('%-24s %10.2f %10s %8s' % (name, mips, '-', 'new'))
+            continue
+
+        change = mips / baseline[name] - 1
+        regressed = change < -args.threshold
+        failed |= regressed and not args.update
+        print('%-24s %10.2f %10.2f %+7.1f%%%s' %
+              (name, mips, baseline[name], change * 100,
+               ' REGRESSION' if regressed else ''))
+
+    if args.results:
+        with open(args.results, 'w') as results_file:
+            json.dump(measured, results_file, indent=2, sort_keys=True)
+    if args.update:
+        baseline.update(measured)
+        with open(args.baseline, 'w') as baseline_file:
+            json.dump(baseline, baseline_file, indent=2, sort_keys=True)
+        print('Baseline written to ' + args.baseline)
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,144 @@
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "besm-666/exec/gprf.hpp"
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/hooks.hpp"
+#include "test-programs.hpp"
+
+using namespace besm;
+
+namespace {
+
+constexpr RV64Ptr DATA = 0x1000;
+constexpr RV64Size RAM_SIZE = 64 * 1024 * 1024;
+
+/**
+ * Runs \p numHarts harts over \p pMem, each incrementing the dword at DATA
+ * 65536 times, and returns the final value
+ */
+RV64UDWord RunContention(std::shared_ptr<mem::PhysMem> const &pMem,
+                         size_t numHarts) {
+    std::vector<sim::Hart::SPtr> harts;
+    for (size_t hartId = 0; hartId < numHarts; ++hartId) {
+        harts.push_back(
+            sim::Hart::Create(pMem, sim::HookManager::Create(), hartId));
+    }
+
+    std::vector<std::thread> threads;
+    for (sim::Hart::SPtr const &hart : harts) {
+        threads.emplace_back([&hart] { hart->run(); });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    return pMem->loadDWord(DATA);
+}
+
+} // namespace
+
+TEST(Atomics, MemoryOperations) {
+    RV64UWord const program[] = {
+        0x00100293, // addi t0, zero, 1
+        0x00c29293, // slli t0, t0, 12
+        0x00500313, // addi t1, zero, 5
+        0x0062b023, // sd t1, 0(t0)
+        0x00300393, // addi t2, zero, 3
+        0x0072b52f, // amoadd.d a0, t2, (t0)
+        0x0872a5af, // amoswap.w a1, t2, (t0)
+        0xfff00e13, // addi t3, zero, -1
+        0xe1c2a62f, // amomaxu.w a2, t3, (t0)
+        0x8072a6af, // amomin.w a3, t2, (t0)
+        0x1002b72f, // lr.d a4, (t0)
+        0x1872b7af, // sc.d a5, t2, (t0)
+        0x1872b82f, // sc.d a6, t2, (t0)
+        0x00100073, // ebreak
+    };
+    std::shared_ptr<mem::PhysMem> pMem = test::MakePhysMem(program, RAM_SIZE);
+
+    sim::Hart::SPtr hart = sim::Hart::Create(pMem, sim::HookManager::Create());
+    hart->run();
+
+    exec::GPRF const &gprf = hart->getGPRF();
+    EXPECT_EQ(gprf.read(exec::GPRF::X10), 5);
+    EXPECT_EQ(gprf.read(exec::GPRF::X11), 8);
+    EXPECT_EQ(gprf.read(exec::GPRF::X12), 3);
+    // Word results are sign-extended
+    EXPECT_EQ(gprf.read(exec::GPRF::X13), ~static_cast<RV64UDWord>(0));
+    EXPECT_EQ(gprf.read(exec::GPRF::X14), 0xFFFFFFFF);
+    EXPECT_EQ(gprf.read(exec::GPRF::X15), 0);
+    // The reservation is consumed by the first SC
+    EXPECT_EQ(gprf.read(exec::GPRF::X16), 1);
+    EXPECT_EQ(pMem->loadDWord(DATA), 3);
+}
+
+TEST(Atomics, MisalignedAMOTraps) {
+    RV64UWord const program[] = {
+        0x00100293, // addi t0, zero, 1
+        0x00c29293, // slli t0, t0, 12
+        0x30529073, // csrw mtvec, t0
+        0x00228313, // addi t1, t0, 2
+        0x0073252f, // amoadd.w a0, t2, (t1)
+        0x00100073, // ebreak
+    };
+    RV64UWord const handler[] = {
+        0x00000013, // nop
+        0x00100073, // ebreak
+    };
+    std::shared_ptr<mem::PhysMem> pMem = test::MakePhysMem(program, RAM_SIZE);
+    pMem->storeContArea(DATA, handler, sizeof(handler));
+
+    sim::Hart::SPtr hart = sim::Hart::Create(pMem, sim::HookManager::Create());
+    hart->run();
+
+    EXPECT_EQ(hart->getCSRF().mcause.get<exec::MCause::ExceptionCode>(),
+              EXCEPTION_STORE_ADDR_MISALIGNED);
+    EXPECT_EQ(hart->getCSRF().mepc.get<exec::MEPC::Value>(), 0x10);
+    EXPECT_EQ(hart->getGPRF().read(exec::GPRF::PC), DATA + 4);
+}
+
+/*
+ * Every hart increments the same dword, no increment may be lost. The
+ * throughput is measured by BM_HartContention in the benchmarks.
+ */
+TEST(Atomics, AMOAddContention) {
+    RV64UWord const program[] = {
+        0x00100293, // addi t0, zero, 1
+        0x00c29293, // slli t0, t0, 12
+        0x00100313, // addi t1, zero, 1
+        0x01031313, // slli t1, t1, 16
+        0x00100393, // addi t2, zero, 1
+        0x0072b02f, // loop: amoadd.d zero, t2, (t0)
+        0xfff30313, // addi t1, t1, -1
+        0xfe031ce3, // bnez t1, loop
+        0x00100073, // ebreak
+    };
+    constexpr size_t NUM_HARTS = 4;
+
+    EXPECT_EQ(RunContention(test::MakePhysMem(program, RAM_SIZE), NUM_HARTS),
+              NUM_HARTS << 16);
+}
+
+TEST(Atomics, LRSCContention) {
+    RV64UWord const program[] = {
+        0x00100293, // addi t0, zero, 1
+        0x00c29293, // slli t0, t0, 12
+        0x00100313, // addi t1, zero, 1
+        0x01031313, // slli t1, t1, 16
+        0x1002b3af, // loop: lr.d t2, (t0)
+        0x00138393, // addi t2, t2, 1
+        0x1872be2f, // sc.d t3, t2, (t0)
+        0xfe0e1ae3, // bnez t3, loop
+        0xfff30313, // addi t1, t1, -1
+        0xfe0316e3, // bnez t1, loop
+        0x00100073, // ebreak
+    };
+    constexpr size_t NUM_HARTS = 4;
+
+    EXPECT_EQ(RunContention(test::MakePhysMem(program, RAM_SIZE), NUM_HARTS),
+              NUM_HARTS << 16);
+}
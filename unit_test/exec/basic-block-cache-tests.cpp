@@ -0,0 +1,120 @@
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "besm-666/exec/basic-block.hpp"
+#include "besm-666/exec/gprf.hpp"
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/hooks.hpp"
+#include "test-programs.hpp"
+
+using namespace besm;
+
+namespace {
+
+exec::BasicBlock MakeBB(RV64Ptr pc, RV64UWord imm) {
+    exec::BasicBlock bb;
+    exec::BasicBlockRebuilder rebuilder(bb, pc);
+    Instruction instr{};
+    instr.operation = ADDI;
+    instr.immidiate = imm;
+    rebuilder.append(instr);
+    instr.operation = JAL;
+    rebuilder.append(instr);
+    return bb;
+}
+
+} // namespace
+
+TEST(SharedBasicBlockCache, KeysBlocksByCodeHashAndPC) {
+    auto cache = exec::SharedBasicBlockCache::Create();
+
+    EXPECT_EQ(cache->lookup(1, 0x100), nullptr);
+    exec::BasicBlock const *first = cache->publish(1, MakeBB(0x100, 1));
+    exec::BasicBlock const *second = cache->publish(2, MakeBB(0x100, 2));
+
+    EXPECT_EQ(cache->lookup(1, 0x100), first);
+    EXPECT_EQ(cache->lookup(2, 0x100), second);
+    EXPECT_EQ(first->getInstructions()[0].immidiate, 1);
+    EXPECT_EQ(second->getInstructions()[0].immidiate, 2);
+    EXPECT_EQ(cache->getBlocksNum(), 2);
+}
+
+/*
+ * Threads race to publish the same blocks, each block must be published
+ * once and every thread must get the winner.
+ */
+TEST(SharedBasicBlockCache, PublishesEachBlockOnce) {
+    constexpr size_t NUM_THREADS = 8;
+    constexpr size_t NUM_BLOCKS = 4096;
+
+    auto cache = exec::SharedBasicBlockCache::Create();
+    std::vector<std::vector<exec::BasicBlock const *>> published(
+        NUM_THREADS, std::vector<exec::BasicBlock const *>(NUM_BLOCKS));
+
+    std::vector<std::thread> threads;
+    for (size_t threadId = 0; threadId < NUM_THREADS; ++threadId) {
+        threads.emplace_back([&, threadId] {
+            for (size_t i = 0; i < NUM_BLOCKS; ++i) {
+                RV64Ptr pc = i * 4;
+                exec::BasicBlock const *bb = cache->lookup(0, pc);
+                if (bb == nullptr) {
+                    bb = cache->publish(0, MakeBB(pc, i));
+                }
+                published[threadId][i] = bb;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(cache->getBlocksNum(), NUM_BLOCKS);
+    for (size_t i = 0; i < NUM_BLOCKS; ++i) {
+        EXPECT_EQ(published[0][i]->getPC(), i * 4);
+        for (size_t threadId = 1; threadId < NUM_THREADS; ++threadId) {
+            EXPECT_EQ(published[threadId][i], published[0][i]);
+        }
+    }
+}
+
+TEST(SharedBasicBlockCache, HartsShareDecodedBlocks) {
+    std::shared_ptr<mem::PhysMem> pMem =
+        test::MakePhysMem(test::CountdownProgram);
+
+    auto cache = exec::SharedBasicBlockCache::Create();
+    sim::HookManager::SPtr hookManager = sim::HookManager::Create();
+    for (size_t hartId = 0; hartId < 4; ++hartId) {
+        sim::Hart::SPtr hart = sim::Hart::Create(pMem, hookManager, hartId);
+        hart->attachCodeCache(cache, 42);
+        hart->runUntil(test::COUNTDOWN_END);
+        EXPECT_EQ(hart->getGPRF().read(exec::GPRF::PC), test::COUNTDOWN_END);
+        EXPECT_EQ(hart->getGPRF().read(exec::GPRF::X5), 0);
+    }
+
+    // The entry block and the loop, the hart stops before fetching END
+    EXPECT_EQ(cache->getBlocksNum(), 2);
+}
+
+TEST(BasicBlockCache, HartCountsFetches) {
+    sim::Hart::SPtr hart =
+        sim::Hart::Create(test::MakePhysMem(test::CountdownProgram),
+                          sim::HookManager::Create());
+    hart->runUntil(test::COUNTDOWN_END);
+
+    // The entry block runs the first iteration, the loop block the other 9,
+    // each block is decoded once
+    sim::Stats const &stats = hart->getStats();
+    EXPECT_EQ(stats.findCounter("bb_cache.lookups")->read(), 10);
+    EXPECT_EQ(stats.findCounter("bb_cache.misses")->read(), 2);
+    EXPECT_EQ(stats.findCounter("code_cache.decoded")->read(), 2);
+
+    // A block is recorded once the next one is fetched, so the last loop
+    // iteration isn't
+    auto snapshot = stats.findHistogram("hart.block_length")->read();
+    EXPECT_EQ(snapshot.count, 9);
+    EXPECT_EQ(snapshot.sum, 3 + 8 * 2);
+    EXPECT_EQ(snapshot.buckets[2], 9);
+}
@@ -0,0 +1,170 @@
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "besm-666/riscv-types.hpp"
+#include "besm-666/sim/batch-runner.hpp"
+#include "besm-666/sim/config.hpp"
+#include "elf-gen.hpp"
+
+using namespace besm;
+
+namespace {
+
+constexpr RV64Ptr ENTRY = 0x10000;
+constexpr RV64Size RAM_SIZE = 64 * 1024 * 1024;
+
+/// exit(7);
+RV64UWord const ExitProgram[] = {
+    0x00700513, // addi a0, zero, 7
+    0x05d00893, // addi a7, zero, 93
+    0x00000073, // ecall
+};
+
+RV64UWord const LoopProgram[] = {
+    0x0000006f, // loop: j loop
+};
+
+class BatchRunnerTest : public ::testing::Test {
+protected:
+    static constexpr char const *kExitPath = "./batch_exit_elf";
+    static constexpr char const *kLoopPath = "./batch_loop_elf";
+
+    void SetUp() override {
+        gen::generateSuitableElf(kExitPath,
+                                 reinterpret_cast<char const *>(ExitProgram),
+                                 sizeof(ExitProgram), ENTRY);
+        gen::generateSuitableElf(kLoopPath,
+                                 reinterpret_cast<char const *>(LoopProgram),
+                                 sizeof(LoopProgram), ENTRY);
+
+        base_.addRamRange(util::Range<RV64Ptr>(0, RAM_SIZE));
+        base_.setRamPageSize(4096);
+        base_.setRamChunkSize(64 * 1024);
+        base_.setUserMode(true);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(kExitPath);
+        std::filesystem::remove(kLoopPath);
+    }
+
+    std::vector<sim::BatchRunner::Job> parse(std::string const &manifest) {
+        std::istringstream input(manifest);
+        return sim::BatchRunner::ParseManifest(input);
+    }
+
+    sim::ConfigBuilder base_;
+};
+
+} // namespace
+
+TEST(BatchRunner, ParseManifestOptions) {
+    std::istringstream manifest("# comment\n"
+                                "\n"
+                                "a.elf\n"
+                                "b.elf ram=0x1000,4096 ram=0,0x100 "
+                                "ram-page-size=8192 ram-chunk-size=0x10000 "
+                                "max-instrs=1000 timeout=0.5 user-mode -- "
+                                "-x ram=1\n");
+    std::vector<sim::BatchRunner::Job> jobs =
+        sim::BatchRunner::ParseManifest(manifest);
+    ASSERT_EQ(jobs.size(), 2);
+
+    EXPECT_EQ(jobs[0].executablePath.string(), "a.elf");
+    EXPECT_TRUE(jobs[0].guestArgs.empty());
+    EXPECT_TRUE(jobs[0].ramRanges.empty());
+    EXPECT_FALSE(jobs[0].maxInstrs.has_value());
+    EXPECT_FALSE(jobs[0].timeout.has_value());
+    EXPECT_FALSE(jobs[0].userMode);
+
+    sim::BatchRunner::Job const &job = jobs[1];
+    EXPECT_EQ(job.executablePath.string(), "b.elf");
+    ASSERT_EQ(job.ramRanges.size(), 2);
+    EXPECT_EQ(job.ramRanges[0].leftBorder(), 0x1000);
+    EXPECT_EQ(job.ramRanges[0].size(), 4096);
+    EXPECT_EQ(job.ramRanges[1].leftBorder(), 0);
+    EXPECT_EQ(job.ramRanges[1].size(), 0x100);
+    EXPECT_EQ(job.ramPageSize, 8192);
+    EXPECT_EQ(job.ramChunkSize, 0x10000);
+    EXPECT_EQ(job.maxInstrs, 1000);
+    ASSERT_TRUE(job.timeout.has_value());
+    EXPECT_DOUBLE_EQ(job.timeout->count(), 0.5);
+    EXPECT_TRUE(job.userMode);
+    EXPECT_EQ(job.guestArgs, (std::vector<std::string>{"-x", "ram=1"}));
+}
+
+TEST(BatchRunner, ParseManifestErrorsNameLine) {
+    for (char const *line :
+         {"a.elf verbose", "a.elf color=red", "a.elf ram=0x1000",
+          "a.elf max-instrs=many", "a.elf timeout="}) {
+        std::istringstream manifest(std::string("ok.elf\n# comment\n") +
+                                    line + "\n");
+        try {
+            sim::BatchRunner::ParseManifest(manifest);
+            ADD_FAILURE() << "Accepted " << line;
+        } catch (sim::InvalidConfiguration const &error) {
+            EXPECT_EQ(std::string(error.what()).rfind("Manifest line 3: ", 0),
+                      0)
+                << error.what();
+        }
+    }
+}
+
+TEST(BatchRunner, WriteResultsEscapesStrings) {
+    sim::BatchRunner::Job job;
+    job.executablePath = "dir/\"quoted\"\\name";
+    sim::BatchRunner::Result result;
+    result.status = sim::BatchRunner::STATUS_ERROR;
+    result.error = "line\nnext\ttab\x01";
+
+    std::ostringstream output;
+    sim::BatchRunner::WriteResults(output, {job}, {result});
+    EXPECT_EQ(output.str(),
+              "[\n"
+              "  {\"executable\": \"dir/\\\"quoted\\\"\\\\name\", "
+              "\"status\": \"error\", \"instructions\": 0, \"seconds\": 0, "
+              "\"mips\": 0, \"error\": \"line\\nnext\\u0009tab\\u0001\"}\n"
+              "]\n");
+}
+
+TEST_F(BatchRunnerTest, Statuses) {
+    std::vector<sim::BatchRunner::Job> jobs =
+        this->parse(std::string(kExitPath) + "\n" + kLoopPath +
+                    " max-instrs=1000\n" + kLoopPath + " timeout=0.05\n" +
+                    "./missing_elf\n");
+    ASSERT_EQ(jobs.size(), 4);
+
+    sim::BatchRunner runner(base_, 2);
+    std::vector<sim::BatchRunner::Result> results = runner.run(jobs);
+    ASSERT_EQ(results.size(), 4);
+
+    EXPECT_EQ(results[0].status, sim::BatchRunner::STATUS_EXITED);
+    EXPECT_EQ(results[0].exitCode, 7);
+    EXPECT_GT(results[0].instrsExecuted, 0);
+
+    EXPECT_EQ(results[1].status, sim::BatchRunner::STATUS_BUDGET);
+    EXPECT_FALSE(results[1].exitCode.has_value());
+    EXPECT_GE(results[1].instrsExecuted, 1000);
+
+    EXPECT_EQ(results[2].status, sim::BatchRunner::STATUS_TIMEOUT);
+    EXPECT_FALSE(results[2].exitCode.has_value());
+    EXPECT_GT(results[2].instrsExecuted, 0);
+
+    EXPECT_EQ(results[3].status, sim::BatchRunner::STATUS_ERROR);
+    EXPECT_FALSE(results[3].error.empty());
+}
+
+TEST_F(BatchRunnerTest, ReusesRAMChunks) {
+    sim::BatchRunner runner(base_, 1);
+    runner.run(this->parse(kExitPath));
+    size_t chunks = runner.getRAMChunkPool().getChunksNum();
+    EXPECT_GT(chunks, 0);
+
+    // The jobs run one by one, each takes the chunks the previous returned
+    runner.run(this->parse(std::string(kExitPath) + "\n" + kExitPath + "\n" +
+                           kExitPath + "\n"));
+    EXPECT_EQ(runner.getRAMChunkPool().getChunksNum(), chunks);
+}
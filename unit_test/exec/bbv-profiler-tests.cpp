@@ -0,0 +1,93 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "besm-666/exec/gprf.hpp"
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/bbv-profiler.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/hooks.hpp"
+#include "test-programs.hpp"
+
+using namespace besm;
+
+namespace {
+
+/// Sums the instructions of every interval of a .bb file
+std::vector<size_t> ReadIntervals(std::string const &bb) {
+    std::vector<size_t> intervals;
+    std::istringstream lines(bb);
+    std::string line;
+    while (std::getline(lines, line)) {
+        EXPECT_EQ(line.front(), 'T');
+        size_t total = 0;
+        std::istringstream fields(line.substr(1));
+        std::string field;
+        while (fields >> field) {
+            total += std::stoull(field.substr(field.rfind(':') + 1));
+        }
+        intervals.push_back(total);
+    }
+    return intervals;
+}
+
+} // namespace
+
+TEST(BBVProfiler, CountsInstructionsPerInterval) {
+    std::shared_ptr<mem::PhysMem> pMem =
+        test::MakePhysMem(test::CountdownProgram);
+
+    std::ostringstream output;
+    sim::BBVProfiler profiler(output, 8);
+    sim::Hart::SPtr hart = sim::Hart::Create(pMem, sim::HookManager::Create());
+    hart->attachProfiler(&profiler);
+    hart->runUntil(test::COUNTDOWN_END);
+    profiler.finish(*hart);
+
+    // 1 + 10 * 2 instructions: intervals end at the block boundaries after
+    // 8 and 16 instructions
+    std::vector<size_t> intervals = ReadIntervals(output.str());
+    ASSERT_EQ(intervals.size(), 3);
+    EXPECT_EQ(intervals[0], 9);
+    EXPECT_EQ(intervals[1], 8);
+    EXPECT_EQ(intervals[2], 4);
+    EXPECT_EQ(profiler.getIntervalsNum(), 3);
+}
+
+TEST(BBVProfiler, DumpsStateAtSimPoints) {
+    std::shared_ptr<mem::PhysMem> pMem =
+        test::MakePhysMem(test::CountdownProgram);
+
+    std::filesystem::path dumpDir =
+        std::filesystem::temp_directory_path() / "besm666-simpoints-test";
+    std::filesystem::remove_all(dumpDir);
+
+    std::istringstream simPoints("1 0\n");
+    std::ostringstream output;
+    sim::BBVProfiler profiler(output, 8);
+    profiler.setSimPoints(sim::BBVProfiler::ReadSimPoints(simPoints), dumpDir,
+                          pMem);
+
+    sim::Hart::SPtr hart = sim::Hart::Create(pMem, sim::HookManager::Create());
+    hart->attachProfiler(&profiler);
+    hart->runUntil(test::COUNTDOWN_END);
+    profiler.finish(*hart);
+
+    EXPECT_FALSE(std::filesystem::exists(dumpDir / "0"));
+    std::ifstream regs(dumpDir / "1" / "regs");
+    std::string regsText((std::istreambuf_iterator<char>(regs)),
+                         std::istreambuf_iterator<char>());
+    EXPECT_NE(regsText.find("pc 0x4\n"), std::string::npos);
+    EXPECT_NE(regsText.find("instret 9\n"), std::string::npos);
+
+    // The code page
+    std::ifstream ram(dumpDir / "1" / "ram-0.bin", std::ios::binary);
+    RV64UWord first = 0;
+    ram.read(reinterpret_cast<char *>(&first), sizeof(first));
+    EXPECT_EQ(first, test::CountdownProgram[0]);
+
+    std::filesystem::remove_all(dumpDir);
+}
@@ -0,0 +1,75 @@
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/call-graph-profiler.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/hooks.hpp"
+#include "test-programs.hpp"
+
+using namespace besm;
+
+namespace {
+
+RV64UWord const Program[] = {
+    0x00300513, // _start: addi a0, zero, 3
+    0x00c000ef, //         jal ra, inc
+    0x008000ef, //         jal ra, inc
+    0x00100073, //         ebreak
+    0x00150513, // inc:    addi a0, a0, 1
+    0x00008067, //         ret
+};
+
+sim::CallGraphProfiler::Counts Profile(sim::CallGraphProfiler &profiler) {
+    sim::Hart::SPtr hart = sim::Hart::Create(test::MakePhysMem(Program),
+                                             sim::HookManager::Create());
+    hart->attachProfiler(&profiler);
+    hart->run();
+    profiler.finish(*hart);
+
+    sim::CallGraphProfiler::Counts counts;
+    profiler.addCounts(counts);
+    return counts;
+}
+
+} // namespace
+
+TEST(CallGraphProfiler, CountsCallPaths) {
+    sim::CallGraphProfiler profiler;
+    auto counts = Profile(profiler);
+
+    EXPECT_EQ(profiler.getDepth(), 1);
+    ASSERT_EQ(counts.size(), 2);
+    EXPECT_EQ((counts[{0x0}]), 3);
+    EXPECT_EQ((counts[{0x0, 0x10}]), 4);
+
+    util::Symtab symtab({
+        {.name = "_start", .address = 0x0, .size = 0x10, .isFunction = true},
+        {.name = "inc", .address = 0x10, .size = 0x8, .isFunction = true},
+    });
+    auto profile = sim::CallGraphProfiler::Symbolize(symtab, counts);
+    ASSERT_EQ(profile.size(), 2);
+    EXPECT_EQ(profile[0].stack, "_start");
+    EXPECT_EQ(profile[0].self, 3);
+    EXPECT_EQ(profile[0].total, 7);
+    EXPECT_EQ(profile[1].stack, "_start;inc");
+    EXPECT_EQ(profile[1].self, 4);
+    EXPECT_EQ(profile[1].total, 4);
+
+    std::ostringstream folded;
+    sim::CallGraphProfiler::WriteFolded(
+        folded, sim::CallGraphProfiler::Symbolize(util::Symtab(), counts));
+    EXPECT_EQ(folded.str(), "0x0 3\n0x0;0x10 4\n");
+}
+
+TEST(CallGraphProfiler, BoundsDepth) {
+    EXPECT_THROW(sim::CallGraphProfiler(0), std::invalid_argument);
+
+    sim::CallGraphProfiler profiler(1);
+    auto counts = Profile(profiler);
+
+    EXPECT_EQ(profiler.getDepth(), 1);
+    ASSERT_EQ(counts.size(), 1);
+    EXPECT_EQ((counts[{0x0}]), 7);
+}
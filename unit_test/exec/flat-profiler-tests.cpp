@@ -0,0 +1,49 @@
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/flat-profiler.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/hooks.hpp"
+#include "test-programs.hpp"
+
+using namespace besm;
+
+TEST(FlatProfiler, AttributesBlocksToFunctions) {
+    sim::FlatProfiler profiler;
+    sim::Hart::SPtr hart =
+        sim::Hart::Create(test::MakePhysMem(test::CountdownProgram),
+                          sim::HookManager::Create());
+    hart->attachProfiler(&profiler);
+    hart->runUntil(test::COUNTDOWN_END);
+    profiler.finish(*hart);
+
+    sim::FlatProfiler::Counts counts;
+    profiler.addCounts(counts);
+    EXPECT_EQ(counts.size(), 2);
+    EXPECT_EQ(counts[0x0], 3);
+    EXPECT_EQ(counts[0x4], 18);
+
+    util::Symtab symtab({
+        {.name = "_start", .address = 0x0, .size = 0x4, .isFunction = true},
+        {.name = "loop", .address = 0x4, .size = 0x8, .isFunction = true},
+    });
+    auto profile = sim::FlatProfiler::Symbolize(symtab, counts);
+    ASSERT_EQ(profile.size(), 2);
+    EXPECT_EQ(profile[0].name, "loop");
+    EXPECT_EQ(profile[0].instrs, 18);
+    EXPECT_EQ(profile[1].name, "_start");
+    EXPECT_EQ(profile[1].instrs, 3);
+
+    // Without symbols all the code is unknown
+    profile = sim::FlatProfiler::Symbolize(util::Symtab(), counts);
+    ASSERT_EQ(profile.size(), 1);
+    EXPECT_EQ(profile[0].name, "[unknown]");
+    EXPECT_EQ(profile[0].instrs, 21);
+
+    std::ostringstream folded;
+    sim::FlatProfiler::WriteFolded(folded,
+                                   sim::FlatProfiler::Symbolize(symtab, counts));
+    EXPECT_EQ(folded.str(), "loop 18\n_start 3\n");
+}
@@ -0,0 +1,118 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "besm-666/exec/gprf.hpp"
+#include "besm-666/memory/clint.hpp"
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/hart-scheduler.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/hooks.hpp"
+
+using namespace besm;
+
+namespace {
+
+constexpr RV64Ptr COUNTER = 0x1000;
+constexpr RV64Ptr CLINT_ADDRESS = 0x100000;
+constexpr RV64Size RAM_SIZE = 64 * 1024 * 1024;
+
+} // namespace
+
+/*
+ * Many more harts than workers and a short quantum, so the harts are
+ * preempted and stolen many times while incrementing the counter.
+ */
+TEST(WorkStealingScheduler, RunsManyHartsOnFewWorkers) {
+    RV64UWord const program[] = {
+        0x00100293, // addi t0, zero, 1
+        0x00c29293, // slli t0, t0, 12
+        0x3e800313, // addi t1, zero, 1000
+        0x00100393, // addi t2, zero, 1
+        0x0072b02f, // loop: amoadd.d zero, t2, (t0)
+        0xfff30313, // addi t1, t1, -1
+        0xfe031ce3, // bnez t1, loop
+        0x00100073, // end: ebreak
+    };
+    constexpr RV64Ptr END = 0x1c;
+    constexpr size_t NUM_HARTS = 64;
+
+    std::shared_ptr<mem::PhysMem> pMem =
+        mem::PhysMemBuilder().mapRAM(0, RAM_SIZE, 4096, 64 * 1024).build();
+    pMem->storeContArea(0, program, sizeof(program));
+
+    std::vector<sim::Hart::SPtr> harts;
+    sim::HookManager::SPtr hookManager = sim::HookManager::Create();
+    for (size_t hartId = 0; hartId < NUM_HARTS; ++hartId) {
+        harts.push_back(sim::Hart::Create(pMem, hookManager, hartId));
+    }
+
+    sim::WorkStealingScheduler scheduler(harts, 3, 100);
+    scheduler.runUntil(END);
+
+    EXPECT_EQ(pMem->loadDWord(COUNTER), NUM_HARTS * 1000);
+    for (size_t hartId = 0; hartId < NUM_HARTS; ++hartId) {
+        EXPECT_EQ(harts[hartId]->getGPRF().read(exec::GPRF::PC), END);
+        EXPECT_GT(scheduler.getRunTime(hartId).count(), 0);
+    }
+}
+
+/*
+ * Harts 1..N-1 park in WFI until hart 0 raises their software interrupts,
+ * then count themselves. Hart 0 spins with PAUSE until all of them have.
+ */
+TEST(WorkStealingScheduler, WakesUpParkedHarts) {
+    constexpr size_t NUM_HARTS = 8;
+    RV64UWord const program[] = {
+        0xf1402573, // csrr a0, mhartid
+        0x00100293, // addi t0, zero, 1
+        0x00c29293, // slli t0, t0, 12
+        0x04051063, // bnez a0, waiter
+        0x10000313, // addi t1, zero, 0x100
+        0x00c31313, // slli t1, t1, 12
+        0x00100393, // addi t2, zero, 1
+        0x00800e13, // addi t3, zero, NUM_HARTS
+        0x00100593, // addi a1, zero, 1
+        0x00239e93, // msip: slli t4, t2, 2
+        0x006e8eb3, // add t4, t4, t1
+        0x00bea023, // sw a1, 0(t4)
+        0x00138393, // addi t2, t2, 1
+        0xffc398e3, // bne t2, t3, msip
+        0xfffe0e13, // addi t3, t3, -1
+        0x0100000f, // spin: pause
+        0x0002bf03, // ld t5, 0(t0)
+        0xffcf1ce3, // bne t5, t3, spin
+        0x00100073, // ebreak
+        0x00800313, // waiter: addi t1, zero, 8
+        0x30432073, // csrs mie, t1
+        0x10500073, // wait: wfi
+        0x344023f3, // csrr t2, mip
+        0x0083f393, // andi t2, t2, 8
+        0xfe038ae3, // beqz t2, wait
+        0x00100e13, // addi t3, zero, 1
+        0x01c2b02f, // amoadd.d zero, t3, (t0)
+        0x0000006f, // done: j done
+    };
+    constexpr RV64Ptr EBREAK = 0x48;
+
+    mem::CLINT::SPtr clint = mem::CLINT::Create(NUM_HARTS, 10'000'000);
+    std::shared_ptr<mem::PhysMem> pMem =
+        mem::PhysMemBuilder()
+            .mapRAM(0, RAM_SIZE, 4096, 64 * 1024)
+            .mapTimer(CLINT_ADDRESS, clint)
+            .build();
+    pMem->storeContArea(0, program, sizeof(program));
+
+    std::vector<sim::Hart::SPtr> harts;
+    sim::HookManager::SPtr hookManager = sim::HookManager::Create();
+    for (size_t hartId = 0; hartId < NUM_HARTS; ++hartId) {
+        harts.push_back(sim::Hart::Create(pMem, hookManager, hartId));
+        harts.back()->attachCLINT(clint);
+    }
+
+    sim::WorkStealingScheduler scheduler(harts, 2, 1000);
+    scheduler.runUntil(sim::Hart::kNoStopPC);
+
+    EXPECT_EQ(harts[0]->getGPRF().read(exec::GPRF::PC), EBREAK);
+    EXPECT_EQ(pMem->loadDWord(COUNTER), NUM_HARTS - 1);
+}
@@ -0,0 +1,68 @@
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/hooks.hpp"
+#include "besm-666/sim/instr-mix-profiler.hpp"
+#include "test-programs.hpp"
+
+using namespace besm;
+
+TEST(InstrMixProfiler, WeightsBlocksByRuns) {
+    sim::InstrMixProfiler profiler;
+    sim::Hart::SPtr hart =
+        sim::Hart::Create(test::MakePhysMem(test::CountdownProgram),
+                          sim::HookManager::Create());
+    hart->attachProfiler(&profiler);
+    hart->runUntil(test::COUNTDOWN_END);
+    profiler.finish(*hart);
+
+    auto mix = profiler.getMix();
+    EXPECT_EQ(mix.getTotal(), hart->getInstrsExecuted());
+    EXPECT_EQ(mix.ops[ADDI], 11);
+    EXPECT_EQ(mix.ops[BNE], 10);
+    EXPECT_EQ(mix.getClassCount(sim::InstrMixProfiler::CLASS_ALU), 11);
+    EXPECT_EQ(mix.getClassCount(sim::InstrMixProfiler::CLASS_BRANCH), 10);
+    EXPECT_EQ(mix.getClassCount(sim::InstrMixProfiler::CLASS_LOAD), 0);
+
+    std::ostringstream json;
+    sim::InstrMixProfiler::WriteJSON(json, mix);
+    EXPECT_NE(json.str().find("\"operations\": {\"bne\": 10, \"addi\": 11}"),
+              std::string::npos);
+}
+
+/*
+ * The AMO traps in the middle of the entry block, only the instructions
+ * retired before the trap are counted
+ */
+TEST(InstrMixProfiler, CountsPrefixOfTrappedBlock) {
+    RV64UWord const program[] = {
+        0x00100293, // addi t0, zero, 1
+        0x00c29293, // slli t0, t0, 12
+        0x30529073, // csrw mtvec, t0
+        0x00228313, // addi t1, t0, 2
+        0x0073252f, // amoadd.w a0, t2, (t1)
+        0x00100073, // ebreak
+    };
+    RV64UWord const handler[] = {
+        0x00000013, // nop
+        0x00100073, // ebreak
+    };
+    std::shared_ptr<mem::PhysMem> pMem = test::MakePhysMem(program);
+    pMem->storeContArea(0x1000, handler, sizeof(handler));
+
+    sim::InstrMixProfiler profiler;
+    sim::Hart::SPtr hart = sim::Hart::Create(pMem, sim::HookManager::Create());
+    hart->attachProfiler(&profiler);
+    hart->run();
+    profiler.finish(*hart);
+
+    auto mix = profiler.getMix();
+    EXPECT_EQ(mix.getTotal(), hart->getInstrsExecuted());
+    EXPECT_EQ(mix.ops[SLLI], 1);
+    EXPECT_EQ(mix.ops[CSRRW], 1);
+    EXPECT_EQ(mix.ops[EBREAK], 0);
+}
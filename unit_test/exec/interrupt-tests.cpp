@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include "besm-666/exec/gprf.hpp"
+#include "besm-666/memory/clint.hpp"
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/hooks.hpp"
+
+using namespace besm;
+
+/*
+ * Arms the timer for 5 ticks (500 instructions at 10MHz) and spins until
+ * the interrupt handler stops the hart.
+ */
+TEST(Interrupts, TimerLatencyIsBoundedByBlock) {
+    RV64UWord const program[] = {
+        0x00100293, // addi t0, zero, 1
+        0x00c29293, // slli t0, t0, 12
+        0x30529073, // csrw mtvec, t0
+        0x08000293, // addi t0, zero, 128
+        0x3042a073, // csrs mie, t0
+        0x30046073, // csrsi mstatus, 8
+        0x10400313, // addi t1, zero, 0x104
+        0x00c31313, // slli t1, t1, 12
+        0x00500393, // addi t2, zero, 5
+        0x00733023, // sd t2, 0(t1)
+        0x00150513, // loop: addi a0, a0, 1
+        0xffdff06f, // j loop
+    };
+    RV64UWord const handler[] = {
+        0x00100073, // ebreak
+    };
+    constexpr RV64Ptr HANDLER = 0x1000;
+    constexpr RV64Ptr LOOP = 0x28;
+    constexpr RV64Ptr CLINT_ADDRESS = 0x100000;
+    constexpr RV64Size RAM_SIZE = 64 * 1024 * 1024;
+
+    mem::CLINT::SPtr clint = mem::CLINT::Create(1, 10'000'000);
+    std::shared_ptr<mem::PhysMem> pMem =
+        mem::PhysMemBuilder()
+            .mapRAM(0, RAM_SIZE, 4096, 64 * 1024)
+            .mapTimer(CLINT_ADDRESS, clint)
+            .build();
+    pMem->storeContArea(0, program, sizeof(program));
+    pMem->storeContArea(HANDLER, handler, sizeof(handler));
+
+    sim::Hart::SPtr hart = sim::Hart::Create(pMem, sim::HookManager::Create());
+    hart->attachCLINT(clint);
+    hart->run();
+
+    EXPECT_EQ(hart->getGPRF().read(exec::GPRF::PC), HANDLER);
+    EXPECT_EQ(hart->getCSRF().mcause.get<exec::MCause::Interrupt>(), 1);
+    EXPECT_EQ(hart->getCSRF().mcause.get<exec::MCause::ExceptionCode>(),
+              INTERRUPT_MTIMER);
+    EXPECT_EQ(hart->getCSRF().mepc.get<exec::MEPC::Value>(), LOOP);
+
+    EXPECT_GE(hart->getInstrsExecuted(), 500);
+    EXPECT_LT(hart->getInstrsExecuted(),
+              500 + exec::BasicBlock::kCapacity - 1);
+}
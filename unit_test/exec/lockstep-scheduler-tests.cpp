@@ -0,0 +1,213 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "besm-666/exec/gprf.hpp"
+#include "besm-666/memory/clint.hpp"
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/hooks.hpp"
+#include "besm-666/sim/lockstep-scheduler.hpp"
+
+using namespace besm;
+
+namespace {
+
+constexpr RV64Ptr COUNTER = 0x1000;
+constexpr RV64Size RAM_SIZE = 64 * 1024 * 1024;
+constexpr size_t NUM_HARTS = 4;
+constexpr size_t ITERATIONS = 200;
+
+/*
+ * The harts increment a shared counter without atomics. The load and the
+ * store are in different basic blocks, so the number of lost updates
+ * depends on the interleaving only.
+ */
+RV64UWord const RacyProgram[] = {
+    0x00100293, // addi t0, zero, 1
+    0x00c29293, // slli t0, t0, 12
+    0x0c800313, // addi t1, zero, ITERATIONS
+    0x0002be03, // loop: ld t3, 0(t0)
+    0x00000013, // nop
+    0x00000013, // nop
+    0x00000013, // nop
+    0x00000013, // nop
+    0x00000013, // nop
+    0x00000013, // nop
+    0x001e0e13, // addi t3, t3, 1
+    0x01c2b023, // sd t3, 0(t0)
+    0xfff30313, // addi t1, t1, -1
+    0xfc031ce3, // bnez t1, loop
+    0x00100073, // end: ebreak
+};
+constexpr RV64Ptr END = 0x38;
+
+struct Outcome {
+    RV64UDWord counter;
+    std::vector<size_t> instrs;
+
+    bool operator==(Outcome const &other) const {
+        return counter == other.counter && instrs == other.instrs;
+    }
+};
+
+Outcome RunRacy(size_t numThreads, size_t quantum, uint64_t seed) {
+    std::shared_ptr<mem::PhysMem> pMem =
+        mem::PhysMemBuilder().mapRAM(0, RAM_SIZE, 4096, 64 * 1024).build();
+    pMem->storeContArea(0, RacyProgram, sizeof(RacyProgram));
+
+    std::vector<sim::Hart::SPtr> harts;
+    sim::HookManager::SPtr hookManager = sim::HookManager::Create();
+    for (size_t hartId = 0; hartId < NUM_HARTS; ++hartId) {
+        harts.push_back(sim::Hart::Create(pMem, hookManager, hartId));
+    }
+
+    sim::LockstepScheduler scheduler(harts, numThreads, quantum, seed,
+                                     nullptr);
+    scheduler.runUntil(END);
+
+    Outcome outcome = {pMem->loadDWord(COUNTER), {}};
+    for (auto const &hart : harts) {
+        EXPECT_EQ(hart->getGPRF().read(exec::GPRF::PC), END);
+        outcome.instrs.push_back(hart->getInstrsExecuted());
+    }
+    return outcome;
+}
+
+} // namespace
+
+TEST(LockstepScheduler, SameSeedAndQuantumReproduceRun) {
+    for (uint64_t seed : {0, 1, 42}) {
+        Outcome first = RunRacy(1, 37, seed);
+        Outcome second = RunRacy(1, 37, seed);
+
+        EXPECT_EQ(first, second);
+        // Updates are lost, so the interleaving has mattered
+        EXPECT_LT(first.counter, NUM_HARTS * ITERATIONS);
+    }
+}
+
+TEST(LockstepScheduler, LargeQuantumRunsHartsInTurn) {
+    Outcome outcome = RunRacy(1, 1'000'000, 0);
+
+    EXPECT_EQ(outcome.counter, NUM_HARTS * ITERATIONS);
+}
+
+TEST(LockstepScheduler, BarrierRunsAllHarts) {
+    Outcome outcome = RunRacy(2, 37, 0);
+
+    EXPECT_GE(outcome.counter, ITERATIONS);
+    EXPECT_LE(outcome.counter, NUM_HARTS * ITERATIONS);
+}
+
+/*
+ * Hart 0 stops at once, hart 1 stores the mtime ticks of its loop. mtime is
+ * at CLINT_BASE + 0xBFF8.
+ */
+TEST(LockstepScheduler, BarrierAdvancesTimeWithoutBootHart) {
+    RV64UWord const program[] = {
+        0xf14022f3, // csrr t0, mhartid
+        0x02028a63, // beqz t0, end
+        0x00100313, // addi t1, zero, 1
+        0x01b31313, // slli t1, t1, 27
+        0x0000cfb7, // lui t6, 0xc
+        0x01f30333, // add t1, t1, t6
+        0xff833383, // ld t2, -8(t1)
+        0x3e800e13, // addi t3, zero, 1000
+        0xfffe0e13, // loop: addi t3, t3, -1
+        0xfe0e1ee3, // bnez t3, loop
+        0xff833e83, // ld t4, -8(t1)
+        0x407e8eb3, // sub t4, t4, t2
+        0x00001f37, // lui t5, 0x1
+        0x01df3023, // sd t4, 0(t5)
+        0x00100073, // end: ebreak
+    };
+    constexpr RV64Ptr PROGRAM_END = 0x38;
+    constexpr RV64Ptr CLINT_BASE = 0x8000000;
+    constexpr size_t QUANTUM = 37;
+
+    mem::CLINT::SPtr clint = mem::CLINT::Create(2, mem::CLINT::kHartFrequency);
+    std::shared_ptr<mem::PhysMem> pMem =
+        mem::PhysMemBuilder()
+            .mapRAM(0, RAM_SIZE, 4096, 64 * 1024)
+            .mapTimer(CLINT_BASE, clint)
+            .build();
+    pMem->storeContArea(0, program, sizeof(program));
+
+    std::vector<sim::Hart::SPtr> harts;
+    sim::HookManager::SPtr hookManager = sim::HookManager::Create();
+    for (size_t hartId = 0; hartId < 2; ++hartId) {
+        harts.push_back(sim::Hart::Create(pMem, hookManager, hartId));
+        harts.back()->attachCLINT(clint);
+    }
+
+    {
+        sim::LockstepScheduler scheduler(harts, 2, QUANTUM, 0, clint);
+        scheduler.runUntil(PROGRAM_END);
+    }
+
+    // The loop starts and ends within some rounds
+    RV64UDWord ticks = pMem->loadDWord(COUNTER);
+    EXPECT_GT(ticks, 2000 - 3 * QUANTUM);
+    EXPECT_EQ(ticks % QUANTUM, 0);
+}
+
+TEST(LockstepScheduler, BarrierFiresTimerAtMTime) {
+    // Hart 1 arms its timer 500 ticks ahead and spins on PAUSE, so its own
+    // clock lags far behind mtime
+    RV64UWord const program[] = {
+        0xf14022f3, // csrr t0, mhartid
+        0x04028e63, // beqz t0, end
+        0x00100313, // addi t1, zero, 1
+        0x01b31313, // slli t1, t1, 27
+        0x0000cfb7, // lui t6, 0xc
+        0x01f30f33, // add t5, t1, t6
+        0x00004fb7, // lui t6, 0x4
+        0x01f30eb3, // add t4, t1, t6
+        0x05000293, // addi t0, zero, handler
+        0x30529073, // csrw mtvec, t0
+        0x08000293, // addi t0, zero, 0x80
+        0x30429073, // csrw mie, t0
+        0xff8f3383, // ld t2, -8(t5)
+        0x1f438e13, // addi t3, t2, 500
+        0x01ceb423, // sd t3, 8(t4)
+        0x30046073, // csrsi mstatus, 8
+        0x0100000f, // loop: pause
+        0xffdff06f, // j loop
+        0x00000013, // nop
+        0x00000013, // nop
+        0xff8f3e03, // handler: ld t3, -8(t5)
+        0x407e0e33, // sub t3, t3, t2
+        0x00001fb7, // lui t6, 0x1
+        0x01cfb023, // sd t3, 0(t6)
+        0x00100073, // end: ebreak
+    };
+    constexpr RV64Ptr PROGRAM_END = 0x60;
+    constexpr RV64Ptr CLINT_BASE = 0x8000000;
+    constexpr size_t QUANTUM = 37;
+
+    mem::CLINT::SPtr clint = mem::CLINT::Create(2, mem::CLINT::kHartFrequency);
+    std::shared_ptr<mem::PhysMem> pMem =
+        mem::PhysMemBuilder()
+            .mapRAM(0, RAM_SIZE, 4096, 64 * 1024)
+            .mapTimer(CLINT_BASE, clint)
+            .build();
+    pMem->storeContArea(0, program, sizeof(program));
+
+    std::vector<sim::Hart::SPtr> harts;
+    sim::HookManager::SPtr hookManager = sim::HookManager::Create();
+    for (size_t hartId = 0; hartId < 2; ++hartId) {
+        harts.push_back(sim::Hart::Create(pMem, hookManager, hartId));
+        harts.back()->attachCLINT(clint);
+    }
+
+    {
+        sim::LockstepScheduler scheduler(harts, 2, QUANTUM, 0, clint);
+        scheduler.runUntil(PROGRAM_END);
+    }
+
+    // The timer fires at the first round end past mtimecmp
+    RV64UDWord ticks = pMem->loadDWord(COUNTER);
+    EXPECT_GE(ticks, 500);
+    EXPECT_LT(ticks, 500 + QUANTUM);
+}
@@ -0,0 +1,63 @@
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "besm-666/exec/csrf.hpp"
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/hooks.hpp"
+#include "besm-666/sim/pc-sampler.hpp"
+#include "test-programs.hpp"
+
+using namespace besm;
+
+TEST(PCSampler, SamplesPublishedBlockWord) {
+    RV64UWord const program[] = {
+        0x00000013, // nop
+        0x0000006f, // spin: j spin
+    };
+
+    sim::Hart::SPtr hart = sim::Hart::Create(test::MakePhysMem(program),
+                                             sim::HookManager::Create());
+
+    sim::PCSampler sampler(1000);
+    ASSERT_TRUE(sampler.start({hart.get()})) << sampler.getError();
+    sim::PCSampler other(1000);
+    EXPECT_FALSE(other.start({hart.get()}));
+
+    std::thread runner([&hart] { hart->run(); });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (sampler.getSamplesNum() < 100 &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    hart->requestStop();
+    runner.join();
+    sampler.stop();
+
+    uint64_t word = hart->getBlockWord().load();
+    EXPECT_EQ(sim::Hart::GetBlockWordPC(word), 0x4);
+    EXPECT_EQ(sim::Hart::GetBlockWordPrivilege(word),
+              exec::PRIVILLEGE_MACHINE);
+
+    // The entry block may be sampled before the hart spins
+    auto samples = sampler.getSamples();
+    ASSERT_FALSE(samples.empty());
+    EXPECT_GE(sampler.getSamplesNum(), 100);
+    EXPECT_EQ(sampler.getDroppedNum(), 0);
+    EXPECT_EQ(samples[0].pc, 0x4);
+    EXPECT_EQ(samples[0].privilege, exec::PRIVILLEGE_MACHINE);
+
+    util::Symtab symtab({
+        {.name = "spin", .address = 0x4, .size = 0x4, .isFunction = true},
+    });
+    auto profile = sim::PCSampler::Symbolize(symtab, samples);
+    EXPECT_EQ(profile[0].name, "spin");
+    EXPECT_EQ(profile[0].counts[exec::PRIVILLEGE_MACHINE], samples[0].count);
+
+    std::ostringstream folded;
+    sim::PCSampler::WriteFolded(folded, profile);
+    EXPECT_EQ(folded.str().rfind("M;spin ", 0), 0);
+}
@@ -0,0 +1,124 @@
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/hooks.hpp"
+#include "besm-666/sim/stats.hpp"
+#include "test-programs.hpp"
+
+using namespace besm;
+
+TEST(Stats, CounterSumsShards) {
+    auto stats = sim::Stats::Create(4);
+    auto &counter = stats->counter("test.events", "Test events");
+
+    std::vector<std::thread> writers;
+    for (size_t shard = 0; shard < 4; ++shard) {
+        writers.emplace_back([&counter, shard] {
+            for (size_t i = 0; i < 100000; ++i) {
+                counter.add(shard);
+            }
+        });
+    }
+    for (auto &writer : writers) {
+        writer.join();
+    }
+    counter.add(0, 5);
+
+    EXPECT_EQ(counter.read(), 400005);
+    // The same name gives the same counter
+    EXPECT_EQ(&stats->counter("test.events", ""), &counter);
+    EXPECT_EQ(stats->findCounter("test.events"), &counter);
+    EXPECT_EQ(stats->findCounter("test.none"), nullptr);
+}
+
+TEST(Stats, HistogramBuckets) {
+    auto stats = sim::Stats::Create(2);
+    auto &histogram = stats->histogram("test.sizes", "Test sizes");
+
+    histogram.record(0, 0);
+    histogram.record(0, 1);
+    histogram.record(1, 3);
+    histogram.record(1, 4);
+    histogram.record(0, 1ull << 40);
+
+    auto snapshot = histogram.read();
+    EXPECT_EQ(snapshot.count, 5);
+    EXPECT_EQ(snapshot.sum, 8 + (1ull << 40));
+    EXPECT_EQ(snapshot.buckets[0], 1);
+    EXPECT_EQ(snapshot.buckets[1], 1);
+    EXPECT_EQ(snapshot.buckets[2], 1);
+    EXPECT_EQ(snapshot.buckets[3], 1);
+    EXPECT_EQ(snapshot.buckets[sim::Stats::Histogram::kBuckets - 1], 1);
+}
+
+TEST(Stats, Exporters) {
+    auto stats = sim::Stats::Create(1);
+    stats->counter("bb_cache.misses", "Misses").add(0, 7);
+    stats->gauge("ram.pages_touched", "Pages", [] { return 1234567.0; });
+    auto &histogram = stats->histogram("hart.block_length", "Length");
+    histogram.record(0, 2);
+    histogram.record(0, 5);
+
+    std::ostringstream prometheus;
+    stats->writePrometheus(prometheus);
+    std::string text = prometheus.str();
+    EXPECT_NE(text.find("# TYPE besm666_bb_cache_misses_total counter\n"
+                        "besm666_bb_cache_misses_total 7\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("besm666_ram_pages_touched 1234567\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("besm666_hart_block_length_bucket{le=\"3\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("besm666_hart_block_length_bucket{le=\"7\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("besm666_hart_block_length_bucket{le=\"+Inf\"} 2\n"
+                        "besm666_hart_block_length_sum 7\n"
+                        "besm666_hart_block_length_count 2\n"),
+              std::string::npos);
+
+    std::ostringstream json;
+    stats->writeJSON(json);
+    EXPECT_EQ(json.str().rfind("{\"counters\": {\"bb_cache.misses\": 7}, "
+                               "\"gauges\": {\"ram.pages_touched\": 1234567}, "
+                               "\"histograms\": {\"hart.block_length\": "
+                               "{\"count\": 2, \"sum\": 7, \"buckets\": [",
+                               0),
+              0);
+}
+
+TEST(Stats, HartWritesItsShard) {
+    RV64UWord const program[] = {
+        0x00100293, // addi t0, zero, 1
+        0x00c29293, // slli t0, t0, 12
+        0x30529073, // csrw mtvec, t0
+        0x00000073, // ecall
+    };
+    RV64UWord const handler[] = {
+        0x00000013, // nop
+        0x00100073, // ebreak
+    };
+    constexpr RV64Ptr HANDLER = 0x1000;
+
+    std::shared_ptr<mem::PhysMem> pMem = test::MakePhysMem(program);
+    pMem->storeContArea(HANDLER, handler, sizeof(handler));
+
+    auto stats = sim::Stats::Create(2);
+    sim::Hart::SPtr hart =
+        sim::Hart::Create(pMem, sim::HookManager::Create(), 1);
+    hart->attachStats(stats);
+    EXPECT_EQ(&hart->getStats(), stats.get());
+
+    hart->run();
+    EXPECT_EQ(stats->findCounter("csrf.exceptions")->read(), 1);
+    EXPECT_EQ(stats->findCounter("csrf.interrupts")->read(), 0);
+
+    EXPECT_THROW(sim::Hart::Create(pMem, sim::HookManager::Create(), 2)
+                     ->attachStats(stats),
+                 std::invalid_argument);
+}
@@ -0,0 +1,245 @@
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "besm-666/exec/gprf.hpp"
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/sim/hart.hpp"
+#include "besm-666/sim/hooks.hpp"
+#include "besm-666/sim/syscall-emulator.hpp"
+
+using namespace besm;
+
+/*
+ * write(1, "hello\n", 6);
+ * exit(argc + 41);
+ */
+TEST(SyscallEmulator, WriteAndExit) {
+    RV64UWord const program[] = {
+        0x00100513, // addi a0, zero, 1
+        0x000025b7, // lui a1, 0x2
+        0x00600613, // addi a2, zero, 6
+        0x04000893, // addi a7, zero, 64
+        0x00000073, // ecall
+        0x00013283, // ld t0, 0(sp)
+        0x02928513, // addi a0, t0, 41
+        0x05d00893, // addi a7, zero, 93
+        0x00000073, // ecall
+    };
+    constexpr RV64Ptr ENTRY = 0x1000;
+    constexpr RV64Ptr MESSAGE = 0x2000;
+    constexpr RV64Size RAM_SIZE = 64 * 1024 * 1024;
+
+    std::shared_ptr<mem::PhysMem> pMem =
+        mem::PhysMemBuilder().mapRAM(0, RAM_SIZE, 4096, 64 * 1024).build();
+    pMem->storeContArea(ENTRY, program, sizeof(program));
+    pMem->storeContArea(MESSAGE, "hello\n", 6);
+
+    sim::SyscallEmulator::SPtr syscalls =
+        sim::SyscallEmulator::Create(sim::SyscallEmulator::ProcessImage{
+            .entry = ENTRY,
+            .programHeaders = {.address = 0, .entrySize = 0, .count = 0},
+            .imageEnd = MESSAGE + 0x1000,
+            .stackTop = RAM_SIZE,
+            .args = {"program"}});
+
+    sim::Hart::SPtr hart = sim::Hart::Create(pMem, sim::HookManager::Create());
+    hart->attachSyscallEmulator(syscalls);
+    hart->run();
+
+    EXPECT_TRUE(syscalls->exited());
+    EXPECT_EQ(syscalls->exitCode(), 42);
+    EXPECT_EQ(hart->getGPRF().read(exec::GPRF::X2) % 16, 0);
+}
+
+namespace {
+
+constexpr RV64Size RAM_SIZE = 64 * 1024 * 1024;
+constexpr RV64Ptr IMAGE_END = 0x3000;
+constexpr RV64Ptr MMAP_TOP = RAM_SIZE - sim::SyscallEmulator::kStackSize;
+constexpr RV64Ptr NO_MEMORY = 2 * RAM_SIZE;
+
+constexpr RV64UDWord SYSCALL_GETCWD = 17;
+constexpr RV64UDWord SYSCALL_READ = 63;
+constexpr RV64UDWord SYSCALL_WRITE = 64;
+constexpr RV64UDWord SYSCALL_READV = 65;
+constexpr RV64UDWord SYSCALL_WRITEV = 66;
+constexpr RV64UDWord SYSCALL_BRK = 214;
+constexpr RV64UDWord SYSCALL_MUNMAP = 215;
+constexpr RV64UDWord SYSCALL_MMAP = 222;
+constexpr RV64UDWord MAP_FIXED_ANONYMOUS = 0x30;
+constexpr RV64UDWord MAP_ANONYMOUS_PRIVATE = 0x22;
+
+/// Serves syscalls without a guest program
+class SyscallEmulatorTest : public ::testing::Test {
+protected:
+    SyscallEmulatorTest()
+        : pMem_(mem::PhysMemBuilder()
+                    .mapRAM(0, RAM_SIZE, 4096, 64 * 1024)
+                    .build()),
+          mmu_(mem::MMU::Create(pMem_)),
+          syscalls_(
+              sim::SyscallEmulator::Create(sim::SyscallEmulator::ProcessImage{
+                  .entry = 0x1000,
+                  .programHeaders = {.address = 0, .entrySize = 0, .count = 0},
+                  .imageEnd = IMAGE_END,
+                  .stackTop = RAM_SIZE,
+                  .args = {"program"}})) {}
+
+    RV64DWord syscall(RV64UDWord number, std::vector<RV64UDWord> args) {
+        args.resize(6, 0);
+        for (size_t i = 0; i < args.size(); ++i) {
+            gprf_.write(exec::GPRF::X10 + i, args[i]);
+        }
+        gprf_.write(exec::GPRF::X17, number);
+        syscalls_->handle(gprf_, *mmu_);
+        return static_cast<RV64DWord>(gprf_.read(exec::GPRF::X10));
+    }
+
+    std::shared_ptr<mem::PhysMem> pMem_;
+    mem::MMU::SPtr mmu_;
+    exec::GPRF gprf_;
+    sim::SyscallEmulator::SPtr syscalls_;
+};
+
+} // namespace
+
+TEST_F(SyscallEmulatorTest, MmapSparesReleasedBreak) {
+    RV64Ptr brkEnd = MMAP_TOP - 0x2000;
+    EXPECT_EQ(syscall(SYSCALL_BRK, {brkEnd}), brkEnd);
+    pMem_->storeDWord(brkEnd - 0x1008, 0xDEAD);
+    EXPECT_EQ(syscall(SYSCALL_BRK, {IMAGE_END}), IMAGE_END);
+
+    EXPECT_EQ(syscall(SYSCALL_MMAP,
+                      {0, 0x3000, 3, MAP_ANONYMOUS_PRIVATE, RV64UDWord(-1)}),
+              -ENOMEM);
+    EXPECT_EQ(syscall(SYSCALL_MMAP, {0, RV64UDWord(1) << 63, 3,
+                                     MAP_ANONYMOUS_PRIVATE, RV64UDWord(-1)}),
+              -ENOMEM);
+    EXPECT_EQ(syscall(SYSCALL_MMAP,
+                      {0, 0x2000, 3, MAP_ANONYMOUS_PRIVATE, RV64UDWord(-1)}),
+              brkEnd);
+
+    EXPECT_EQ(syscall(SYSCALL_BRK, {brkEnd - 0x1000}), brkEnd - 0x1000);
+    EXPECT_EQ(pMem_->loadDWord(brkEnd - 0x1008), 0);
+}
+
+TEST_F(SyscallEmulatorTest, BreakOverFixedMapping) {
+    constexpr RV64Ptr FIXED = 0x10000;
+    EXPECT_EQ(syscall(SYSCALL_MMAP, {FIXED, 0x1000, 3, MAP_FIXED_ANONYMOUS,
+                                     RV64UDWord(-1)}),
+              FIXED);
+    pMem_->storeDWord(FIXED, 0xDEAD);
+
+    EXPECT_EQ(syscall(SYSCALL_BRK, {FIXED + 0x1000}), FIXED + 0x1000);
+    EXPECT_EQ(pMem_->loadDWord(FIXED), 0);
+}
+
+TEST_F(SyscallEmulatorTest, ReadVWriteV) {
+    constexpr RV64Ptr IOV = 0x2000;
+    constexpr RV64Ptr DATA = 0x2100;
+
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+
+    pMem_->storeContArea(DATA, "hello, world", 12);
+    RV64UDWord const writeIov[] = {DATA, 5, DATA + 5, 7};
+    pMem_->storeContArea(IOV, writeIov, sizeof(writeIov));
+    EXPECT_EQ(syscall(SYSCALL_WRITEV, {RV64UDWord(fds[1]), IOV, 2}), 12);
+
+    RV64UDWord const readIov[] = {DATA + 0x100, 7, DATA + 0x200, 5};
+    pMem_->storeContArea(IOV, readIov, sizeof(readIov));
+    EXPECT_EQ(syscall(SYSCALL_READV, {RV64UDWord(fds[0]), IOV, 2}), 12);
+
+    auto load = [this](RV64Ptr address, size_t size) {
+        std::string string;
+        for (size_t i = 0; i < size; ++i) {
+            string += static_cast<char>(pMem_->loadByte(address + i));
+        }
+        return string;
+    };
+    EXPECT_EQ(load(DATA + 0x100, 7), "hello, ");
+    EXPECT_EQ(load(DATA + 0x200, 5), "world");
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST_F(SyscallEmulatorTest, ReadVWriteVBadPointers) {
+    constexpr RV64Ptr IOV = 0x2000;
+
+    EXPECT_EQ(syscall(SYSCALL_WRITEV, {1, NO_MEMORY, 1}), -EFAULT);
+    EXPECT_EQ(syscall(SYSCALL_READV, {0, RAM_SIZE - 8, 1}), -EFAULT);
+
+    RV64UDWord const iov[] = {NO_MEMORY, 16};
+    pMem_->storeContArea(IOV, iov, sizeof(iov));
+    EXPECT_EQ(syscall(SYSCALL_WRITEV, {1, IOV, 1}), -EFAULT);
+
+    EXPECT_EQ(syscall(SYSCALL_WRITEV, {1, IOV, RV64UDWord(1) << 40}),
+              -EINVAL);
+}
+
+TEST_F(SyscallEmulatorTest, MunmapReusesPages) {
+    constexpr RV64Size SIZE = 16 * 1024 * 1024;
+
+    // The region would run out without reuse
+    for (size_t i = 0; i < 16; ++i) {
+        RV64DWord mapping = syscall(SYSCALL_MMAP, {0, SIZE, 3,
+                                                   MAP_ANONYMOUS_PRIVATE,
+                                                   RV64UDWord(-1)});
+        ASSERT_EQ(mapping, MMAP_TOP - SIZE);
+        pMem_->storeDWord(mapping, 0xDEAD);
+        EXPECT_EQ(syscall(SYSCALL_MUNMAP, {RV64UDWord(mapping), SIZE}), 0);
+    }
+
+    RV64Ptr first = syscall(SYSCALL_MMAP, {0, 0x2000, 3,
+                                           MAP_ANONYMOUS_PRIVATE,
+                                           RV64UDWord(-1)});
+    RV64Ptr second = syscall(SYSCALL_MMAP, {0, 0x2000, 3,
+                                            MAP_ANONYMOUS_PRIVATE,
+                                            RV64UDWord(-1)});
+    EXPECT_EQ(second, first - 0x2000);
+    pMem_->storeDWord(first, 0xDEAD);
+    EXPECT_EQ(syscall(SYSCALL_MUNMAP, {first, 0x2000}), 0);
+
+    // A hole below the top is reused and zeroed
+    EXPECT_EQ(syscall(SYSCALL_MMAP,
+                      {0, 0x1000, 3, MAP_ANONYMOUS_PRIVATE, RV64UDWord(-1)}),
+              first);
+    EXPECT_EQ(pMem_->loadDWord(first), 0);
+    EXPECT_EQ(syscall(SYSCALL_MUNMAP, {NO_MEMORY + 1, 0x1000}), -EINVAL);
+}
+
+TEST_F(SyscallEmulatorTest, ReadWriteStopAtUnbackedPage) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+
+    pMem_->storeContArea(RAM_SIZE - 4, "tail", 4);
+    EXPECT_EQ(syscall(SYSCALL_WRITE, {RV64UDWord(fds[1]), RAM_SIZE - 4, 16}),
+              4);
+    EXPECT_EQ(syscall(SYSCALL_READ, {RV64UDWord(fds[0]), RAM_SIZE - 2, 16}),
+              2);
+    EXPECT_EQ(pMem_->loadHWord(RAM_SIZE - 2), 't' | 'a' << 8);
+    EXPECT_EQ(syscall(SYSCALL_READ, {RV64UDWord(fds[0]), NO_MEMORY, 16}),
+              -EFAULT);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST_F(SyscallEmulatorTest, GetCwdBufferSize) {
+    constexpr RV64Ptr BUF = 0x2000;
+
+    EXPECT_EQ(syscall(SYSCALL_GETCWD, {BUF, 0}), -EINVAL);
+    EXPECT_EQ(syscall(SYSCALL_GETCWD, {BUF, 1}), -ERANGE);
+
+    char cwd[PATH_MAX];
+    ASSERT_NE(::getcwd(cwd, sizeof(cwd)), nullptr);
+    EXPECT_EQ(syscall(SYSCALL_GETCWD, {BUF, RV64UDWord(1) << 40}),
+              strlen(cwd) + 1);
+    EXPECT_EQ(pMem_->loadByte(BUF), '/');
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/riscv-types.hpp"
+
+namespace besm::test {
+
+/**
+ * Counts t0 down from 10: the entry block runs the first iteration, the
+ * loop block the other 9, 1 + 10 * 2 instructions before END
+ */
+constexpr RV64UWord CountdownProgram[] = {
+    0x00a00293, // _start: addi t0, zero, 10
+    0xfff28293, // loop:   addi t0, t0, -1
+    0xfe029ee3, //         bnez t0, loop
+    0x00100073, // end:    ebreak
+};
+constexpr RV64Ptr COUNTDOWN_END = 0xc;
+
+/// RAM from 0 with the program stored at 0
+template <size_t N>
+std::shared_ptr<mem::PhysMem> MakePhysMem(RV64UWord const (&program)[N],
+                                          RV64Size ramSize = 1024 * 1024) {
+    std::shared_ptr<mem::PhysMem> pMem =
+        mem::PhysMemBuilder().mapRAM(0, ramSize, 4096, 64 * 1024).build();
+    pMem->storeContArea(0, program, sizeof(program));
+    return pMem;
+}
+
+} // namespace besm::test
@@ -1,6 +1,16 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "besm-666/exec/csrf.hpp"
+#include "besm-666/memory/clint.hpp"
+#include "besm-666/memory/htif.hpp"
 #include "besm-666/memory/phys-mem.hpp"
+#include "besm-666/memory/shared-image.hpp"
+#include "besm-666/memory/uart.hpp"
+#include "besm-666/util/symtab.hpp"
 #include "elf-gen.hpp"
 
 constexpr size_t RAMSize = 64ull * 1024 * 1024 * 1024; // 32GB
@@ -47,3 +57,252 @@ TEST(phys_mem_tests, load_elf) {
         EXPECT_EQ(memory->loadByte(gen::defaultPtr + i), gen::defaultData[i]);
     }
 }
+
+TEST(phys_mem_tests, htif_over_ram) {
+    using namespace besm::mem;
+
+    constexpr besm::RV64Ptr ToHost = 0x1000;
+    constexpr besm::RV64Ptr FromHost = 0x1040;
+
+    HTIF::SPtr htif = HTIF::Create(ToHost, FromHost);
+    std::shared_ptr<PhysMem> mem = PhysMemBuilder()
+                                       .mapRAM(0, RAMSize, PageSize, ChunkSize)
+                                       .mapHTIF(htif)
+                                       .build();
+
+    mem->storeDWord(ToHost - 8, 1);
+    mem->storeDWord(FromHost + 8, 2);
+    EXPECT_FALSE(htif->pending());
+
+    mem->storeDWord(ToHost, (42 << 1) | 1);
+    EXPECT_TRUE(htif->pending());
+    EXPECT_EQ(mem->loadDWord(ToHost - 8), 1);
+    EXPECT_EQ(mem->loadDWord(FromHost + 8), 2);
+
+    EXPECT_FALSE(htif->process(*mem));
+    EXPECT_TRUE(htif->exited());
+    EXPECT_EQ(htif->exitCode(), 42);
+    EXPECT_FALSE(htif->pending());
+}
+
+TEST(phys_mem_tests, uart_rx_from_file) {
+    using namespace besm::mem;
+
+    constexpr besm::RV64Ptr UARTAddress = 0x10000000;
+    constexpr besm::RV64Ptr LSR = UARTAddress + 5;
+
+    std::filesystem::path inputPath = "./uart_input";
+    std::ofstream(inputPath) << "ok";
+
+    std::shared_ptr<PhysMem> mem =
+        PhysMemBuilder()
+            .mapRAM(0, RAMSize, PageSize, ChunkSize)
+            .mapUART(UARTAddress, UART::Create(inputPath))
+            .build();
+
+    std::string received;
+    for (int i = 0; i < 1000 && received.size() < 2; ++i) {
+        if (mem->loadByte(LSR) & 1) {
+            received.push_back(mem->loadByte(UARTAddress));
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    EXPECT_EQ(received, "ok");
+    EXPECT_EQ(mem->loadByte(LSR) & 1, 0);
+}
+
+TEST(phys_mem_tests, clint_virtual_time) {
+    using namespace besm::mem;
+
+    constexpr besm::RV64Ptr CLINTAddress = 0x2000000;
+    constexpr besm::RV64Ptr MTimeCmp = CLINTAddress + CLINT::kMTimeCmpBase;
+    constexpr besm::RV64Ptr MTime = CLINTAddress + CLINT::kMTime;
+
+    // 10 MHz timer, 100 instructions per tick
+    CLINT::SPtr clint = CLINT::Create(1, 10'000'000);
+    std::shared_ptr<PhysMem> mem = PhysMemBuilder()
+                                       .mapRAM(0, RAMSize, PageSize, ChunkSize)
+                                       .mapTimer(CLINTAddress, clint)
+                                       .build();
+
+    std::atomic<size_t> instrs{1050};
+    besm::exec::CSRF csrf;
+    clint->attachHart(0, &instrs, csrf.mip);
+    EXPECT_EQ(mem->loadDWord(MTime), 10);
+    EXPECT_EQ(clint->getDeadline(0), CLINT::kNoDeadline);
+
+    mem->storeDWord(MTimeCmp, 25);
+    EXPECT_EQ(clint->getDeadline(0), 2500);
+    EXPECT_EQ(mem->loadWord(MTimeCmp), 25);
+
+    clint->expireTimer(0);
+    EXPECT_TRUE(clint->timerPending(0));
+    EXPECT_EQ(csrf.mip.read(), MIP_MTIP);
+    EXPECT_EQ(clint->getDeadline(0), CLINT::kNoDeadline);
+
+    mem->storeWord(MTimeCmp + 4, 1);
+    EXPECT_FALSE(clint->timerPending(0));
+    EXPECT_EQ(csrf.mip.read(), 0);
+    EXPECT_EQ(mem->loadDWord(MTimeCmp), (1ull << 32) + 25);
+
+    mem->storeWord(CLINTAddress, 1);
+    EXPECT_TRUE(clint->softwarePending(0));
+    EXPECT_EQ(csrf.mip.read(), MIP_MSIP);
+}
+
+TEST(phys_mem_tests, clint_mtime_backward) {
+    using namespace besm::mem;
+
+    constexpr besm::RV64Ptr CLINTAddress = 0x2000000;
+    constexpr besm::RV64Ptr MTimeCmp = CLINTAddress + CLINT::kMTimeCmpBase;
+    constexpr besm::RV64Ptr MTime = CLINTAddress + CLINT::kMTime;
+
+    // 10 MHz timer, 100 instructions per tick
+    CLINT::SPtr clint = CLINT::Create(1, 10'000'000);
+    std::shared_ptr<PhysMem> mem = PhysMemBuilder()
+                                       .mapRAM(0, RAMSize, PageSize, ChunkSize)
+                                       .mapTimer(CLINTAddress, clint)
+                                       .build();
+
+    std::atomic<size_t> instrs{1050};
+    besm::exec::CSRF csrf;
+    clint->attachHart(0, &instrs, csrf.mip);
+
+    mem->storeDWord(MTime, 0);
+    EXPECT_EQ(mem->loadDWord(MTime), 0);
+    mem->storeDWord(MTimeCmp, 5);
+    EXPECT_EQ(clint->getDeadline(0), 1500);
+
+    // Moving mtime back rearms an expired compare value in the future
+    instrs = 2000;
+    EXPECT_EQ(mem->loadDWord(MTime), 10);
+    mem->storeDWord(MTime, 2);
+    EXPECT_EQ(clint->getDeadline(0), 2300);
+    EXPECT_FALSE(clint->timerPending(0));
+
+    mem->storeDWord(MTimeCmp, 1);
+    EXPECT_EQ(clint->getDeadline(0), 0);
+}
+
+TEST(phys_mem_tests, concurrent_page_touch) {
+    using namespace besm::mem;
+    using namespace besm;
+
+    constexpr size_t ThreadsNum = 4;
+    constexpr size_t PagesNum = 256;
+
+    std::shared_ptr<PhysMem> mem =
+        PhysMemBuilder().mapRAM(0, RAMSize, PageSize, ChunkSize).build();
+
+    // Every thread touches every page, so first touches race
+    std::vector<std::thread> threads;
+    for (size_t thread = 0; thread < ThreadsNum; ++thread) {
+        threads.emplace_back([&, thread] {
+            for (size_t page = 0; page < PagesNum; ++page) {
+                mem->storeDWord(page * PageSize + thread * sizeof(RV64UDWord),
+                                page * ThreadsNum + thread);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (size_t page = 0; page < PagesNum; ++page) {
+        for (size_t thread = 0; thread < ThreadsNum; ++thread) {
+            EXPECT_EQ(mem->loadDWord(page * PageSize +
+                                     thread * sizeof(RV64UDWord)),
+                      page * ThreadsNum + thread);
+        }
+    }
+}
+
+namespace {
+
+class TwoSegmentsElf final : public besm::util::IElfParser {
+public:
+    static constexpr besm::RV64Ptr TextAddress = 0x10000;
+    static constexpr besm::RV64Ptr DataAddress = 0x10000 + 3 * PageSize + 16;
+
+    explicit TwoSegmentsElf(bool writableData = true, size_t dataMemSize = 64)
+        : text_(3 * PageSize + 8, 'T'), data_(64, 'D') {
+        segments_.emplace_back(TextAddress, text_.data(), text_.size(),
+                               text_.size(), false);
+        segments_.emplace_back(DataAddress, data_.data(), data_.size(),
+                               dataMemSize, writableData);
+    }
+
+    std::vector<LoadableSegment> const &getLoadableSegments() & override {
+        return segments_;
+    }
+    besm::RV64Ptr getEntryPoint() const override { return TextAddress; }
+    ProgramHeaders getProgramHeaders() const override { return {}; }
+    std::vector<Symbol> const &getSymbols() & override { return symbols_; }
+    besm::util::Symtab const &getSymtab() & override { return symtab_; }
+
+private:
+    std::vector<char> text_;
+    std::vector<char> data_;
+    std::vector<LoadableSegment> segments_;
+    std::vector<Symbol> symbols_;
+    besm::util::Symtab symtab_;
+};
+
+} // namespace
+
+TEST(phys_mem_tests, shared_image) {
+    using namespace besm::mem;
+    using namespace besm;
+
+    TwoSegmentsElf elf;
+    SharedImage::SPtr image = SharedImage::Get(elf, 1, PageSize);
+    ASSERT_NE(image, nullptr);
+    EXPECT_EQ(SharedImage::Get(elf, 1, PageSize), image);
+
+    // The last text page also holds data, it is loaded as usual
+    ASSERT_EQ(image->getRanges().size(), 1);
+    EXPECT_EQ(image->getRanges()[0].address, TwoSegmentsElf::TextAddress);
+    EXPECT_EQ(image->getRanges()[0].size, 3 * PageSize);
+
+    std::shared_ptr<PhysMem> first =
+        PhysMemBuilder().mapRAM(0, RAMSize, PageSize, ChunkSize).build();
+    std::shared_ptr<PhysMem> second =
+        PhysMemBuilder().mapRAM(0, RAMSize, PageSize, ChunkSize).build();
+    PhysMemLoader(first).loadElf(elf, *image);
+    PhysMemLoader(second).loadElf(elf, *image);
+
+    for (auto const &memory : {first, second}) {
+        EXPECT_EQ(memory->loadByte(TwoSegmentsElf::TextAddress), 'T');
+        EXPECT_EQ(memory->loadByte(TwoSegmentsElf::TextAddress +
+                                   3 * PageSize + 7),
+                  'T');
+        EXPECT_EQ(memory->loadByte(TwoSegmentsElf::DataAddress), 'D');
+        EXPECT_EQ(memory->loadByte(TwoSegmentsElf::DataAddress + 64), 0);
+    }
+
+    // Copy-on-write
+    first->storeByte(TwoSegmentsElf::TextAddress + 1, 'W');
+    EXPECT_EQ(first->loadByte(TwoSegmentsElf::TextAddress + 1), 'W');
+    EXPECT_EQ(second->loadByte(TwoSegmentsElf::TextAddress + 1), 'T');
+}
+
+TEST(phys_mem_tests, shared_image_layout) {
+    using namespace besm::mem;
+    using namespace besm;
+
+    // Same bytes, but the zero-filled tail covers another page
+    TwoSegmentsElf shortTail(false, 64);
+    TwoSegmentsElf longTail(false, PageSize);
+    SharedImage::SPtr shortImage = SharedImage::Get(shortTail, 2, PageSize);
+    SharedImage::SPtr longImage = SharedImage::Get(longTail, 2, PageSize);
+    ASSERT_NE(shortImage, nullptr);
+    ASSERT_NE(longImage, nullptr);
+    EXPECT_NE(shortImage, longImage);
+
+    ASSERT_EQ(shortImage->getRanges().size(), 1);
+    EXPECT_EQ(shortImage->getRanges()[0].size, 4 * PageSize);
+    ASSERT_EQ(longImage->getRanges().size(), 1);
+    EXPECT_EQ(longImage->getRanges()[0].size, 5 * PageSize);
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include "besm-666/memory/ram.hpp"
+
+using namespace besm;
+
+TEST(ram_tests, chunk_pool_reuses_zeroed_chunks) {
+    constexpr size_t const RAM_SIZE = 64 * 1024 * 1024;
+    constexpr size_t const PAGE_SIZE = 4096;
+    constexpr size_t const CHUNK_SIZE = 2 * 1024 * 1024;
+    constexpr RV64Ptr const ADDR = 3 * PAGE_SIZE + 8;
+    constexpr RV64UDWord const VAL = 0xDEADBABEBAD0BEEF;
+
+    mem::RAMChunkPool::SPtr pool = mem::RAMChunkPool::Create();
+    {
+        mem::RAM ram(RAM_SIZE, PAGE_SIZE, CHUNK_SIZE, pool);
+        ram.storeDWord(ADDR, VAL);
+        ram.storeDWord(CHUNK_SIZE + ADDR, VAL);
+        EXPECT_EQ(ram.loadDWord(ADDR), VAL);
+    }
+    size_t chunksNum = pool->getChunksNum();
+    EXPECT_GT(chunksNum, 0);
+
+    {
+        mem::RAM ram(RAM_SIZE, PAGE_SIZE, CHUNK_SIZE, pool);
+        // Backed by the host memory which has held VAL
+        ram.storeDWord(CHUNK_SIZE + ADDR + 8, 1);
+        EXPECT_EQ(ram.loadDWord(CHUNK_SIZE + ADDR), 0);
+        EXPECT_EQ(ram.loadDWord(CHUNK_SIZE + ADDR + 8), 1);
+    }
+    EXPECT_EQ(pool->getChunksNum(), chunksNum);
+}
+
+TEST(ram_tests, counts_touched_pages_and_chunks) {
+    constexpr size_t const RAM_SIZE = 64 * 1024 * 1024;
+    constexpr size_t const PAGE_SIZE = 4096;
+    constexpr size_t const CHUNK_SIZE = 4 * PAGE_SIZE;
+
+    mem::RAM ram(RAM_SIZE, PAGE_SIZE, CHUNK_SIZE);
+    EXPECT_EQ(ram.getPagesTouched(), 0);
+    EXPECT_EQ(ram.getChunksNum(), 0);
+
+    // Loads of untouched pages don't allocate them
+    EXPECT_EQ(ram.loadDWord(10 * PAGE_SIZE), 0);
+    EXPECT_EQ(ram.getPagesTouched(), 0);
+
+    for (size_t page = 0; page < 8; ++page) {
+        ram.storeDWord(page * PAGE_SIZE, page);
+        ram.storeDWord(page * PAGE_SIZE + 8, page);
+    }
+    EXPECT_EQ(ram.getPagesTouched(), 8);
+    EXPECT_EQ(ram.getChunksNum(), 2);
+}
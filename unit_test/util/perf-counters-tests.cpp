@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "besm-666/util/perf-counters.hpp"
+
+using namespace besm;
+
+namespace {
+
+uint64_t Spin(uint64_t iterations) {
+    volatile uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        sum = sum + i;
+    }
+    return sum;
+}
+
+} // namespace
+
+/*
+ * Host counters may be unavailable wherever the test runs, then every
+ * event must be reported empty instead of failing.
+ */
+TEST(PerfCounters, CountsOrFallsBack) {
+    util::PerfCounters counters;
+
+    counters.start();
+    Spin(1'000'000);
+    util::PerfCounters::Counts counts = counters.stop();
+
+    if (!counters.available()) {
+        EXPECT_FALSE(counters.getError().empty());
+        for (auto const &count : counts) {
+            EXPECT_FALSE(count.has_value());
+        }
+        return;
+    }
+
+    auto instrs = counts[util::PerfCounters::EVENT_INSTRUCTIONS];
+    if (instrs.has_value()) {
+        EXPECT_GT(*instrs, 1'000'000);
+    }
+}
+
+TEST(PerfCounters, NamesEvents) {
+    EXPECT_STREQ(
+        util::PerfCounters::GetEventName(util::PerfCounters::EVENT_CYCLES),
+        "cycles");
+    EXPECT_STREQ(util::PerfCounters::GetEventName(
+                     util::PerfCounters::EVENT_DTLB_LOAD_MISSES),
+                 "dTLB-load-misses");
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "besm-666/util/spsc-queue.hpp"
+
+TEST(SPSCQueue, FillAndDrain) {
+    using namespace besm::util;
+
+    SPSCQueue<int, 4> queue;
+    EXPECT_TRUE(queue.empty());
+
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.push(i));
+    }
+    EXPECT_FALSE(queue.push(4));
+
+    int out[8];
+    EXPECT_EQ(queue.pop(out, 3), 3);
+    EXPECT_EQ(out[0], 0);
+    EXPECT_EQ(out[2], 2);
+
+    EXPECT_TRUE(queue.push(4));
+    EXPECT_EQ(queue.pop(out, 8), 2);
+    EXPECT_EQ(out[0], 3);
+    EXPECT_EQ(out[1], 4);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SPSCQueue, ProducerConsumer) {
+    using namespace besm::util;
+
+    constexpr int Count = 1000000;
+    SPSCQueue<int, 256> queue;
+
+    std::thread producer([&] {
+        for (int i = 0; i < Count;) {
+            if (queue.push(i)) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    int expected = 0;
+    int out[64];
+    while (expected < Count) {
+        size_t count = queue.pop(out, 64);
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(out[i], expected++);
+        }
+    }
+
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+
+#include "besm-666/util/symtab.hpp"
+
+using namespace besm;
+
+TEST(Symtab, LooksUpCoveringFunction) {
+    util::Symtab symtab({
+        {.name = "main", .address = 0x1100, .size = 0x40, .isFunction = true},
+        {.name = "_start", .address = 0x1000, .size = 0, .isFunction = true},
+        {.name = "start", .address = 0x1000, .size = 0, .isFunction = true},
+        {.name = "loop", .address = 0x1120, .size = 0, .isFunction = false},
+        {.name = "data", .address = 0x2000, .size = 8, .isFunction = false},
+    });
+
+    ASSERT_EQ(symtab.getEntries().size(), 2);
+    EXPECT_EQ(symtab.lookup(0xfff), nullptr);
+    ASSERT_NE(symtab.lookup(0x1000), nullptr);
+    EXPECT_EQ(symtab.lookup(0x1000)->name, "_start");
+    // Unsized symbols span up to the next one
+    EXPECT_EQ(symtab.lookup(0x10fc)->name, "_start");
+    EXPECT_EQ(symtab.lookup(0x1120)->name, "main");
+    EXPECT_EQ(symtab.lookup(0x113c)->name, "main");
+    EXPECT_EQ(symtab.lookup(0x1140), nullptr);
+}
+
+TEST(Symtab, IndexesLabelsWithoutFunctions) {
+    util::Symtab symtab({
+        {.name = "loop", .address = 0x8, .size = 0, .isFunction = false},
+        {.name = "_start", .address = 0x0, .size = 0, .isFunction = false},
+    });
+
+    EXPECT_EQ(symtab.lookup(0x4)->name, "_start");
+    EXPECT_EQ(symtab.lookup(0x100)->name, "loop");
+    EXPECT_TRUE(util::Symtab().empty());
+}
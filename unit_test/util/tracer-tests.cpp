@@ -0,0 +1,115 @@
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "besm-666/util/tracer.hpp"
+
+using namespace besm;
+
+namespace {
+
+std::string ReadFile(std::filesystem::path const &path) {
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+size_t CountOf(std::string const &string, std::string const &substring) {
+    size_t count = 0;
+    for (size_t pos = string.find(substring); pos != std::string::npos;
+         pos = string.find(substring, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+TEST(Tracer, WritesSpansOfAllThreads) {
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "besm666-tracer-test.json";
+
+    ASSERT_TRUE(util::Tracer::Start(path, std::chrono::milliseconds(1)));
+    EXPECT_TRUE(util::Tracer::Enabled());
+    EXPECT_FALSE(util::Tracer::Start(path));
+
+    { util::TraceSpan span("test.main"); }
+    std::thread worker([] {
+        util::Tracer::SetThreadName("worker");
+        for (int i = 0; i < 100; ++i) {
+            util::TraceSpan span("test.worker");
+        }
+    });
+    worker.join();
+
+    util::TraceBurst burst("test.burst", "events",
+                           std::chrono::milliseconds(1000));
+    uint64_t now = util::Tracer::Now();
+    burst.add(now, now + 10);
+    burst.add(now + 20, now + 30);
+    burst.flush();
+
+    util::Tracer::Stop();
+    EXPECT_FALSE(util::Tracer::Enabled());
+
+    // Not recorded once stopped
+    { util::TraceSpan span("test.stopped"); }
+
+    std::string trace = ReadFile(path);
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(trace.rfind("{\"traceEvents\": [", 0), 0);
+    EXPECT_NE(trace.find("\n]}\n"), std::string::npos);
+    EXPECT_EQ(CountOf(trace, "\"name\": \"test.main\", \"ph\": \"X\""), 1);
+    EXPECT_EQ(CountOf(trace, "\"name\": \"test.worker\", \"ph\": \"X\""), 100);
+    EXPECT_EQ(CountOf(trace, "\"args\": {\"name\": \"worker\"}"), 1);
+    EXPECT_EQ(CountOf(trace, "\"dur\": 0.030, \"args\": {\"events\": 2}"), 1);
+    EXPECT_EQ(CountOf(trace, "test.stopped"), 0);
+}
+
+TEST(Tracer, SpanIsFreeWhenStopped) {
+    ASSERT_FALSE(util::Tracer::Enabled());
+    util::TraceSpan span("test.disabled");
+    util::TraceBurst burst("test.burst", "events",
+                           std::chrono::microseconds(1));
+    burst.add(1, 2);
+    burst.flush();
+}
+
+TEST(Tracer, KeepsEventsOfExitedThreads) {
+    std::filesystem::path path =
+        std::filesystem::temp_directory_path() / "besm666-tracer-exit.json";
+
+    // Named while stopped, the name is written with its first span
+    std::atomic<bool> started{false};
+    std::thread named([&started] {
+        util::Tracer::SetThreadName("early");
+        while (!started.load()) {
+            std::this_thread::yield();
+        }
+        util::TraceSpan span("test.early");
+    });
+
+    ASSERT_TRUE(util::Tracer::Start(path, std::chrono::milliseconds(1)));
+    started.store(true);
+    named.join();
+
+    for (int i = 0; i < 8; ++i) {
+        std::thread([] { util::TraceSpan span("test.exited"); }).join();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    util::Tracer::Stop();
+
+    std::string trace = ReadFile(path);
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(CountOf(trace, "\"args\": {\"name\": \"early\"}"), 1);
+    EXPECT_EQ(CountOf(trace, "\"name\": \"test.early\", \"ph\": \"X\""), 1);
+    EXPECT_EQ(CountOf(trace, "\"name\": \"test.exited\", \"ph\": \"X\""), 8);
+}